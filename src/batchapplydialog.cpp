@@ -0,0 +1,397 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include "batchapplydialog.h"
+
+#include <QCheckBox>
+#include <QComboBox>
+#include <QDebug>
+#include <QDialogButtonBox>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QGridLayout>
+#include <QGroupBox>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QSet>
+#include <QSettings>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+#include <algorithm>
+
+#include "metadatajson.h"
+#include "savequeue.h"
+#include "utils.h"
+
+namespace
+{
+enum Column {
+    ColumnFile,
+    ColumnStatus,
+    ColumnDetails,
+    ColumnCount
+};
+} // namespace
+
+BatchApplyDialog::BatchApplyDialog(SaveQueue *queue, const QStringList &paramFiles, QWidget *parent)
+    : QDialog(parent),
+      m_queue(queue)
+{
+    setWindowTitle(QStringLiteral("Batch Apply Parameters"));
+    resize(760, 520);
+
+    QSettings settings("OMERewriter", "OMERewriter");
+
+    // Files to update
+    m_fileTree = new QTreeWidget(this);
+    m_fileTree->setColumnCount(ColumnCount);
+    m_fileTree->setHeaderLabels({QStringLiteral("File"), QStringLiteral("Status"), QStringLiteral("Details")});
+    m_fileTree->setRootIsDecorated(false);
+    m_fileTree->setUniformRowHeights(true);
+    m_fileTree->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    m_fileTree->header()->setStretchLastSection(true);
+    m_fileTree->header()->setSectionResizeMode(ColumnFile, QHeaderView::Interactive);
+    m_fileTree->setColumnWidth(ColumnFile, 280);
+
+    m_btnAddFiles = new QPushButton(QStringLiteral("Add Files..."), this);
+    m_btnAddFiles->setIcon(QIcon::fromTheme(QIcon::ThemeIcon::ListAdd));
+    m_btnAddFolder = new QPushButton(QStringLiteral("Add Folder..."), this);
+    m_btnAddFolder->setIcon(QIcon::fromTheme(QIcon::ThemeIcon::FolderOpen));
+    m_btnRemove = new QPushButton(QStringLiteral("Remove"), this);
+    m_btnRemove->setIcon(QIcon::fromTheme(QIcon::ThemeIcon::ListRemove));
+
+    m_patternEdit = new QLineEdit(settings.value("batchApply/pattern", "*.tif *.tiff").toString(), this);
+    m_patternEdit->setToolTip(QStringLiteral("File name patterns used when adding a folder, separated by spaces"));
+    m_recursiveCheck = new QCheckBox(QStringLiteral("Include subfolders"), this);
+    m_recursiveCheck->setChecked(settings.value("batchApply/recursive", false).toBool());
+
+    auto fileButtonLayout = new QHBoxLayout;
+    fileButtonLayout->addWidget(m_btnAddFiles);
+    fileButtonLayout->addWidget(m_btnAddFolder);
+    fileButtonLayout->addWidget(new QLabel(QStringLiteral("Pattern:"), this));
+    fileButtonLayout->addWidget(m_patternEdit, 1);
+    fileButtonLayout->addWidget(m_recursiveCheck);
+    fileButtonLayout->addWidget(m_btnRemove);
+
+    // Parameter set to apply
+    m_paramsCombo = new QComboBox(this);
+    for (const auto &path : paramFiles) {
+        const QFileInfo fi(path);
+        m_paramsCombo->addItem(fi.dir().dirName() + "/" + fi.fileName(), path);
+        m_paramsCombo->setItemData(m_paramsCombo->count() - 1, path, Qt::ToolTipRole);
+    }
+    auto btnBrowseParams = new QPushButton(QStringLiteral("Browse..."), this);
+
+    m_deleteSourceCheck = new QCheckBox(QStringLiteral("Delete raw TIFF files once they were converted"), this);
+    m_deleteSourceCheck->setToolTip(
+        QStringLiteral(
+            "Raw TIFF files are written as new OME-TIFF files next to the original.\n"
+            "OME-TIFF files are always updated in place."));
+
+    auto paramsBox = new QGroupBox(QStringLiteral("Parameters"), this);
+    auto paramsLayout = new QGridLayout(paramsBox);
+    paramsLayout->addWidget(new QLabel(QStringLiteral("Parameter set:"), paramsBox), 0, 0);
+    paramsLayout->addWidget(m_paramsCombo, 0, 1);
+    paramsLayout->addWidget(btnBrowseParams, 0, 2);
+    paramsLayout->addWidget(m_deleteSourceCheck, 1, 0, 1, 3);
+    paramsLayout->setColumnStretch(1, 1);
+
+    m_summaryLabel = new QLabel(this);
+    m_summaryLabel->setWordWrap(true);
+
+    auto buttonBox = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    m_btnApply = buttonBox->addButton(QStringLiteral("Apply to All Files"), QDialogButtonBox::ApplyRole);
+    m_btnApply->setIcon(QIcon::fromTheme(QIcon::ThemeIcon::DocumentSave));
+
+    auto layout = new QVBoxLayout(this);
+    layout->addWidget(m_fileTree, 1);
+    layout->addLayout(fileButtonLayout);
+    layout->addWidget(paramsBox);
+    layout->addWidget(m_summaryLabel);
+    layout->addWidget(buttonBox);
+
+    connect(m_btnAddFiles, &QPushButton::clicked, this, &BatchApplyDialog::onAddFilesClicked);
+    connect(m_btnAddFolder, &QPushButton::clicked, this, &BatchApplyDialog::onAddFolderClicked);
+    connect(m_btnRemove, &QPushButton::clicked, this, &BatchApplyDialog::onRemoveClicked);
+    connect(btnBrowseParams, &QPushButton::clicked, this, &BatchApplyDialog::onBrowseParamsClicked);
+    connect(m_btnApply, &QPushButton::clicked, this, &BatchApplyDialog::onApplyClicked);
+    connect(buttonBox, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    connect(m_fileTree, &QTreeWidget::itemSelectionChanged, this, &BatchApplyDialog::updateButtons);
+    connect(m_paramsCombo, &QComboBox::currentIndexChanged, this, &BatchApplyDialog::updateButtons);
+    connect(m_queue, &SaveQueue::jobRemoved, this, [this](SaveJob *job) {
+        m_items.remove(job);
+    });
+
+    updateSummary();
+    updateButtons();
+}
+
+BatchApplyDialog::~BatchApplyDialog()
+{
+    QSettings settings("OMERewriter", "OMERewriter");
+    settings.setValue("batchApply/pattern", m_patternEdit->text());
+    settings.setValue("batchApply/recursive", m_recursiveCheck->isChecked());
+}
+
+void BatchApplyDialog::addFiles(const QStringList &files)
+{
+    QSet<QString> knownFiles;
+    for (int i = 0; i < m_fileTree->topLevelItemCount(); ++i)
+        knownFiles.insert(m_fileTree->topLevelItem(i)->data(ColumnFile, Qt::UserRole).toString());
+
+    for (const auto &file : files) {
+        const auto path = QFileInfo(file).absoluteFilePath();
+        if (knownFiles.contains(path))
+            continue;
+        knownFiles.insert(path);
+
+        auto item = new QTreeWidgetItem(m_fileTree);
+        item->setText(ColumnFile, QFileInfo(path).fileName());
+        item->setToolTip(ColumnFile, path);
+        item->setData(ColumnFile, Qt::UserRole, path);
+        item->setText(ColumnStatus, OMETiffImage::hasOmeTiffExtension(path) ? QStringLiteral("OME-TIFF")
+                                                                            : QStringLiteral("Raw TIFF"));
+    }
+
+    updateSummary();
+    updateButtons();
+}
+
+void BatchApplyDialog::onAddFilesClicked()
+{
+    QSettings settings("OMERewriter", "OMERewriter");
+    const auto files = QFileDialog::getOpenFileNames(
+        this,
+        QStringLiteral("Select Images"),
+        settings.value("directories/batchApply", QDir::homePath()).toString(),
+        QStringLiteral(
+            "All TIFF Files (*.ome.tiff *.ome.tif *.tiff *.tif);;OME-TIFF Files (*.ome.tiff *.ome.tif);;"
+            "All Files (*)"));
+    if (files.isEmpty())
+        return;
+
+    settings.setValue("directories/batchApply", QFileInfo(files.first()).absolutePath());
+    addFiles(files);
+}
+
+void BatchApplyDialog::onAddFolderClicked()
+{
+    QSettings settings("OMERewriter", "OMERewriter");
+    const auto dir = QFileDialog::getExistingDirectory(
+        this, QStringLiteral("Select Folder"), settings.value("directories/batchApply", QDir::homePath()).toString());
+    if (dir.isEmpty())
+        return;
+    settings.setValue("directories/batchApply", dir);
+
+    auto patterns = m_patternEdit->text().split(' ', Qt::SkipEmptyParts);
+    if (patterns.isEmpty())
+        patterns.append(QStringLiteral("*"));
+
+    QStringList files;
+    QDirIterator it(
+        dir,
+        patterns,
+        QDir::Files | QDir::Readable,
+        m_recursiveCheck->isChecked() ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags);
+    while (it.hasNext())
+        files.append(it.next());
+
+    if (files.isEmpty()) {
+        QMessageBox::information(
+            this,
+            QStringLiteral("No Files Found"),
+            QStringLiteral("No files matching '%1' were found in:\n%2").arg(patterns.join(' '), dir));
+        return;
+    }
+
+    files.sort();
+    addFiles(files);
+}
+
+void BatchApplyDialog::onRemoveClicked()
+{
+    const auto selected = m_fileTree->selectedItems();
+    for (auto it = m_items.begin(); it != m_items.end();) {
+        if (selected.contains(it.value()))
+            it = m_items.erase(it);
+        else
+            ++it;
+    }
+    qDeleteAll(selected);
+    updateSummary();
+    updateButtons();
+}
+
+void BatchApplyDialog::onBrowseParamsClicked()
+{
+    QSettings settings("OMERewriter", "OMERewriter");
+    const auto filename = QFileDialog::getOpenFileName(
+        this,
+        QStringLiteral("Select Parameter Set"),
+        settings.value("directories/loadParams", QDir::homePath()).toString(),
+        QStringLiteral("Parameter Files (*.json *.ome.tiff *.ome.tif);;JSON Files (*.json);;All Files (*)"));
+    if (filename.isEmpty())
+        return;
+
+    auto index = m_paramsCombo->findData(filename);
+    if (index < 0) {
+        m_paramsCombo->addItem(QFileInfo(filename).fileName(), filename);
+        index = m_paramsCombo->count() - 1;
+        m_paramsCombo->setItemData(index, filename, Qt::ToolTipRole);
+    }
+    m_paramsCombo->setCurrentIndex(index);
+}
+
+void BatchApplyDialog::onApplyClicked()
+{
+    const auto paramsPath = m_paramsCombo->currentData().toString();
+    const auto params = MetadataJson::loadParameters(paramsPath);
+    if (!params) {
+        QMessageBox::critical(
+            this, QStringLiteral("Load Failed"), QStringLiteral("Failed to load parameters:\n%1").arg(params.error()));
+        return;
+    }
+
+    m_items.clear();
+    m_queuedCount = m_succeeded = m_headerOnly = m_failed = m_cancelled = m_skipped = 0;
+
+    // jobs of one batch must never write to the same file
+    QSet<QString> queuedDestinations;
+    for (int i = 0; i < m_fileTree->topLevelItemCount(); ++i) {
+        auto item = m_fileTree->topLevelItem(i);
+        const auto sourcePath = item->data(ColumnFile, Qt::UserRole).toString();
+        item->setToolTip(ColumnDetails, QString());
+
+        SaveRequest request;
+        request.sourcePath = sourcePath;
+        request.metadata = params.value();
+        request.applyAsParameters = true;
+
+        if (OMETiffImage::hasOmeTiffExtension(sourcePath)) {
+            // updated in place, which usually only touches the OME-XML header
+            request.destPath = sourcePath;
+        } else {
+            const QFileInfo fi(sourcePath);
+            request.destPath = fi.absoluteDir().absoluteFilePath(fi.completeBaseName() + ".ome.tiff");
+            request.deleteSource = m_deleteSourceCheck->isChecked();
+
+            // never silently replace an OME-TIFF that was already written for this file
+            if (QFile::exists(request.destPath)) {
+                m_skipped++;
+                item->setText(ColumnStatus, QStringLiteral("Skipped"));
+                item->setText(
+                    ColumnDetails,
+                    QStringLiteral("%1 already exists").arg(QFileInfo(request.destPath).fileName()));
+                continue;
+            }
+        }
+
+        const auto destination = QFileInfo(request.destPath).absoluteFilePath();
+        if (queuedDestinations.contains(destination)) {
+            m_skipped++;
+            item->setText(ColumnStatus, QStringLiteral("Skipped"));
+            item->setText(
+                ColumnDetails,
+                QStringLiteral("%1 is already written by another file of this batch")
+                    .arg(QFileInfo(request.destPath).fileName()));
+            continue;
+        }
+        queuedDestinations.insert(destination);
+
+        auto job = m_queue->enqueue(request);
+        m_items.insert(job, item);
+        m_queuedCount++;
+        item->setText(ColumnStatus, QStringLiteral("Queued"));
+        item->setText(ColumnDetails, QString());
+
+        connect(job, &SaveJob::started, this, [this, job]() {
+            if (auto item = m_items.value(job))
+                item->setText(ColumnStatus, QStringLiteral("Writing"));
+        });
+        connect(job, &SaveJob::finished, this, [this, job](bool success, const QString &message) {
+            onJobFinished(job, success, message);
+        });
+        emit jobQueued(job);
+    }
+
+    qDebug().noquote() << "Applying parameters from" << paramsPath << "to" << m_queuedCount << "files";
+    updateSummary();
+    updateButtons();
+}
+
+void BatchApplyDialog::onJobFinished(SaveJob *job, bool success, const QString &message)
+{
+    auto item = m_items.value(job);
+    if (!item)
+        return;
+
+    if (!success) {
+        const bool cancelled = job->state() == SaveJob::State::Cancelled;
+        if (cancelled)
+            m_cancelled++;
+        else
+            m_failed++;
+        item->setText(ColumnStatus, cancelled ? QStringLiteral("Cancelled") : QStringLiteral("Failed"));
+        item->setText(ColumnDetails, message);
+        item->setToolTip(ColumnDetails, message);
+    } else {
+        m_succeeded++;
+        const auto stats = job->statistics();
+        if (stats.headerOnly)
+            m_headerOnly++;
+
+        const auto details = stats.headerOnly
+                                 ? QStringLiteral("Header updated in %1 ms").arg(stats.totalMs, 0, 'f', 0)
+                                 : QStringLiteral("Rewritten in %1, %2")
+                                       .arg(formatDuration(static_cast<qint64>(stats.totalMs / 1000.0)))
+                                       .arg(formatDataSize(stats.bytesOut));
+        item->setText(ColumnStatus, message.isEmpty() ? QStringLiteral("Done") : QStringLiteral("Done (warning)"));
+        item->setText(ColumnDetails, message.isEmpty() ? details : message);
+        item->setToolTip(ColumnDetails, message.isEmpty() ? details : details + "\n" + message);
+    }
+
+    updateSummary();
+    updateButtons();
+}
+
+void BatchApplyDialog::updateSummary()
+{
+    if (m_queuedCount == 0 && m_skipped == 0) {
+        m_summaryLabel->setText(QStringLiteral("%1 file(s) selected").arg(m_fileTree->topLevelItemCount()));
+        return;
+    }
+
+    const auto done = m_succeeded + m_failed + m_cancelled;
+    auto summary = QStringLiteral("%1 of %2 file(s) done: %3 header only, %4 rewritten, %5 failed")
+                       .arg(done)
+                       .arg(m_queuedCount)
+                       .arg(m_headerOnly)
+                       .arg(m_succeeded - m_headerOnly)
+                       .arg(m_failed);
+    if (m_cancelled > 0)
+        summary += QStringLiteral(", %1 cancelled").arg(m_cancelled);
+    if (m_skipped > 0)
+        summary += QStringLiteral(", %1 skipped").arg(m_skipped);
+    m_summaryLabel->setText(summary);
+}
+
+void BatchApplyDialog::updateButtons()
+{
+    const bool running = std::any_of(m_items.keyBegin(), m_items.keyEnd(), [](SaveJob *job) {
+        return !job->isDone();
+    });
+
+    m_btnAddFiles->setEnabled(!running);
+    m_btnAddFolder->setEnabled(!running);
+    m_btnRemove->setEnabled(!running && !m_fileTree->selectedItems().isEmpty());
+    m_btnApply->setEnabled(!running && m_fileTree->topLevelItemCount() > 0 && m_paramsCombo->currentIndex() >= 0);
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <QDialog>
+#include <QHash>
+#include <QStringList>
+
+class QCheckBox;
+class QComboBox;
+class QLabel;
+class QLineEdit;
+class QPushButton;
+class QTreeWidget;
+class QTreeWidgetItem;
+class SaveJob;
+class SaveQueue;
+
+/**
+ * @brief Dialog to apply a saved parameter set to many image files at once.
+ *
+ * Every file is rewritten by its own job on the save queue. The parameters are merged
+ * with the metadata each file already has, so OME-TIFF files usually only need their
+ * OME-XML header to be patched.
+ */
+class BatchApplyDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit BatchApplyDialog(SaveQueue *queue, const QStringList &paramFiles, QWidget *parent = nullptr);
+    ~BatchApplyDialog() override;
+
+    /**
+     * @brief Add files to the list of images to update.
+     */
+    void addFiles(const QStringList &files);
+
+signals:
+    /**
+     * @brief Emitted for every job this dialog has added to the save queue.
+     */
+    void jobQueued(SaveJob *job);
+
+private:
+    void onAddFilesClicked();
+    void onAddFolderClicked();
+    void onRemoveClicked();
+    void onBrowseParamsClicked();
+    void onApplyClicked();
+    void onJobFinished(SaveJob *job, bool success, const QString &message);
+    void updateSummary();
+    void updateButtons();
+
+    SaveQueue *m_queue;
+    QTreeWidget *m_fileTree;
+    QLineEdit *m_patternEdit;
+    QCheckBox *m_recursiveCheck;
+    QComboBox *m_paramsCombo;
+    QCheckBox *m_deleteSourceCheck;
+    QLabel *m_summaryLabel;
+    QPushButton *m_btnAddFiles;
+    QPushButton *m_btnAddFolder;
+    QPushButton *m_btnRemove;
+    QPushButton *m_btnApply;
+
+    QHash<SaveJob *, QTreeWidgetItem *> m_items;
+    int m_queuedCount = 0;
+    int m_succeeded = 0;
+    int m_headerOnly = 0;
+    int m_failed = 0;
+    int m_cancelled = 0;
+    int m_skipped = 0;
+};
@@ -0,0 +1,475 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include "catalog.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStandardPaths>
+#include <QVariant>
+#include <atomic>
+
+#include "metadatajson.h"
+#include "perftrace.h"
+
+// Version of the database layout, stored as the user_version of the database
+static constexpr int SchemaVersion = 1;
+
+// Number of IDs per query when loading the channels of search results
+static constexpr int ChannelQueryBatchSize = 500;
+
+static const char *const SchemaStatements[] = {
+    "CREATE TABLE IF NOT EXISTS images ("
+    "  id INTEGER PRIMARY KEY,"
+    "  path TEXT NOT NULL UNIQUE,"
+    "  file_size INTEGER NOT NULL,"
+    "  modified INTEGER NOT NULL,"
+    "  is_ome INTEGER NOT NULL,"
+    "  image_name TEXT,"
+    "  size_x INTEGER, size_y INTEGER, size_z INTEGER, size_c INTEGER, size_t INTEGER,"
+    "  pixel_type TEXT,"
+    "  data_size INTEGER,"
+    "  phys_x_nm REAL, phys_y_nm REAL, phys_z_nm REAL,"
+    "  na REAL,"
+    "  immersion TEXT,"
+    "  medium TEXT,"
+    "  immersion_ri REAL,"
+    "  params_json TEXT,"
+    "  converted_at INTEGER)",
+    "CREATE INDEX IF NOT EXISTS images_na ON images(na)",
+    "CREATE TABLE IF NOT EXISTS channels ("
+    "  image_id INTEGER NOT NULL REFERENCES images(id) ON DELETE CASCADE,"
+    "  idx INTEGER NOT NULL,"
+    "  name TEXT,"
+    "  acquisition_mode TEXT,"
+    "  ex_nm REAL, em_nm REAL,"
+    "  pinhole_nm REAL,"
+    "  photon_count INTEGER,"
+    "  PRIMARY KEY (image_id, idx))",
+    "CREATE INDEX IF NOT EXISTS channels_ex ON channels(ex_nm)",
+    "CREATE INDEX IF NOT EXISTS channels_em ON channels(em_nm)",
+};
+
+static QString sqlError(const QSqlQuery &query)
+{
+    return QStringLiteral("Catalog query failed: %1").arg(query.lastError().text());
+}
+
+/**
+ * Bounds for a range query matching all paths inside a directory, which unlike LIKE
+ * can use the index on the path column and has no wildcard characters to escape.
+ */
+static std::pair<QString, QString> directoryPathRange(const QString &dirPath)
+{
+    const auto dir = QDir::cleanPath(QFileInfo(dirPath).absoluteFilePath());
+
+    // '0' is the character following '/'
+    return {dir + QLatin1Char('/'), dir + QLatin1Char('0')};
+}
+
+static QString escapeLike(QString text)
+{
+    text.replace(QLatin1Char('\\'), QStringLiteral("\\\\"));
+    text.replace(QLatin1Char('%'), QStringLiteral("\\%"));
+    text.replace(QLatin1Char('_'), QStringLiteral("\\_"));
+    return text;
+}
+
+template<typename Enum>
+static Enum enumFromString(const QString &value, Enum fallback)
+{
+    if (value.isEmpty())
+        return fallback;
+    try {
+        return Enum(value.toStdString());
+    } catch (const std::exception &) {
+        return fallback;
+    }
+}
+
+Catalog::Catalog(const QString &dbPath)
+    : m_dbPath(dbPath)
+{
+    static std::atomic<int> connectionCounter{0};
+    m_connectionName = QStringLiteral("catalog-%1").arg(connectionCounter++);
+}
+
+Catalog::~Catalog()
+{
+    {
+        auto db = QSqlDatabase::database(m_connectionName, false);
+        if (db.isOpen())
+            db.close();
+    }
+    QSqlDatabase::removeDatabase(m_connectionName);
+}
+
+QString Catalog::defaultPath()
+{
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).filePath("catalog.sqlite");
+}
+
+std::expected<bool, QString> Catalog::open()
+{
+    if (isOpen())
+        return true;
+
+    QDir().mkpath(QFileInfo(m_dbPath).absolutePath());
+    auto db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), m_connectionName);
+    db.setDatabaseName(m_dbPath);
+
+    // the GUI and the background scanner write to the same database
+    db.setConnectOptions(QStringLiteral("QSQLITE_BUSY_TIMEOUT=5000"));
+    if (!db.open())
+        return std::unexpected(QStringLiteral("Failed to open catalog %1: %2").arg(m_dbPath, db.lastError().text()));
+
+    QSqlQuery query(db);
+    query.exec(QStringLiteral("PRAGMA journal_mode=WAL"));
+    query.exec(QStringLiteral("PRAGMA synchronous=NORMAL"));
+    query.exec(QStringLiteral("PRAGMA foreign_keys=ON"));
+
+    if (!query.exec(QStringLiteral("PRAGMA user_version")) || !query.next())
+        return std::unexpected(sqlError(query));
+    const auto version = query.value(0).toInt();
+    if (version > SchemaVersion)
+        return std::unexpected(
+            QStringLiteral("The catalog %1 was created by a newer version of this application.").arg(m_dbPath));
+
+    for (const auto statement : SchemaStatements) {
+        if (!query.exec(QString::fromLatin1(statement)))
+            return std::unexpected(sqlError(query));
+    }
+    query.exec(QStringLiteral("PRAGMA user_version=%1").arg(SchemaVersion));
+
+    return true;
+}
+
+bool Catalog::isOpen() const
+{
+    return QSqlDatabase::database(m_connectionName, false).isOpen();
+}
+
+std::expected<CatalogEntry, QString> Catalog::readEntry(const QString &path)
+{
+    PERF_TRACE_SCOPE("Catalog::readEntry", "catalog");
+    const QFileInfo fi(path);
+    if (!fi.exists())
+        return std::unexpected(QStringLiteral("File not found: %1").arg(path));
+
+    CatalogEntry entry;
+    entry.path = fi.absoluteFilePath();
+    entry.fileSize = fi.size();
+    entry.modified = fi.lastModified();
+    entry.isOmeTiff = OMETiffImage::hasOmeTiffExtension(path);
+
+    if (entry.isOmeTiff) {
+        auto meta = OMETiffImage::inspectFile(path);
+        if (!meta)
+            return std::unexpected(meta.error());
+        entry.metadata = std::move(meta.value());
+    } else {
+        OMETiffImage image;
+        if (!image.open(path))
+            return std::unexpected(QStringLiteral("Failed to open file: %1").arg(path));
+        entry.metadata = image.extractMetadata();
+    }
+
+    if (entry.metadata.imageName.isEmpty())
+        entry.metadata.imageName = fi.fileName();
+    return entry;
+}
+
+std::expected<bool, QString> Catalog::addEntry(const CatalogEntry &entry)
+{
+    auto db = QSqlDatabase::database(m_connectionName, false);
+    if (!db.isOpen())
+        return std::unexpected(QStringLiteral("The catalog is not open."));
+
+    // an entry and its channels are always replaced together
+    const bool ownTransaction = db.transaction();
+    const auto fail = [&](const QSqlQuery &query) {
+        if (ownTransaction)
+            db.rollback();
+        return std::unexpected(sqlError(query));
+    };
+
+    const auto &meta = entry.metadata;
+    QSqlQuery query(db);
+    query.prepare(QStringLiteral(
+        "INSERT INTO images (path, file_size, modified, is_ome, image_name,"
+        " size_x, size_y, size_z, size_c, size_t, pixel_type, data_size,"
+        " phys_x_nm, phys_y_nm, phys_z_nm, na, immersion, medium, immersion_ri, params_json, converted_at)"
+        " VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"
+        " ON CONFLICT(path) DO UPDATE SET"
+        "  file_size = excluded.file_size, modified = excluded.modified, is_ome = excluded.is_ome,"
+        "  image_name = excluded.image_name, size_x = excluded.size_x, size_y = excluded.size_y,"
+        "  size_z = excluded.size_z, size_c = excluded.size_c, size_t = excluded.size_t,"
+        "  pixel_type = excluded.pixel_type, data_size = excluded.data_size,"
+        "  phys_x_nm = excluded.phys_x_nm, phys_y_nm = excluded.phys_y_nm, phys_z_nm = excluded.phys_z_nm,"
+        "  na = excluded.na, immersion = excluded.immersion, medium = excluded.medium,"
+        "  immersion_ri = excluded.immersion_ri,"
+        "  params_json = COALESCE(excluded.params_json, params_json),"
+        "  converted_at = COALESCE(excluded.converted_at, converted_at)"));
+    query.addBindValue(entry.path);
+    query.addBindValue(entry.fileSize);
+    query.addBindValue(entry.modified.toMSecsSinceEpoch());
+    query.addBindValue(entry.isOmeTiff);
+    query.addBindValue(meta.imageName);
+    query.addBindValue(meta.sizeX);
+    query.addBindValue(meta.sizeY);
+    query.addBindValue(meta.sizeZ);
+    query.addBindValue(meta.sizeC);
+    query.addBindValue(meta.sizeT);
+    query.addBindValue(meta.pixelType);
+    query.addBindValue(static_cast<qint64>(meta.dataSizeBytes));
+    query.addBindValue(meta.physSizeXNm);
+    query.addBindValue(meta.physSizeYNm);
+    query.addBindValue(meta.physSizeZNm);
+    query.addBindValue(meta.numericalAperture);
+    query.addBindValue(QString::fromStdString(std::string(meta.lensImmersion)));
+    query.addBindValue(QString::fromStdString(std::string(meta.embeddingMedium)));
+    query.addBindValue(meta.immersionRI);
+    query.addBindValue(entry.paramsJson.isEmpty() ? QVariant(QMetaType::fromType<QString>()) : entry.paramsJson);
+    query.addBindValue(
+        entry.convertedAt.isValid() ? QVariant(entry.convertedAt.toMSecsSinceEpoch())
+                                    : QVariant(QMetaType::fromType<qint64>()));
+    if (!query.exec())
+        return fail(query);
+
+    query.prepare(QStringLiteral("SELECT id FROM images WHERE path = ?"));
+    query.addBindValue(entry.path);
+    if (!query.exec() || !query.next())
+        return fail(query);
+    const auto imageId = query.value(0).toLongLong();
+
+    query.prepare(QStringLiteral("DELETE FROM channels WHERE image_id = ?"));
+    query.addBindValue(imageId);
+    if (!query.exec())
+        return fail(query);
+
+    query.prepare(QStringLiteral(
+        "INSERT INTO channels (image_id, idx, name, acquisition_mode, ex_nm, em_nm, pinhole_nm, photon_count)"
+        " VALUES (?, ?, ?, ?, ?, ?, ?, ?)"));
+    for (size_t i = 0; i < meta.channels.size(); ++i) {
+        const auto &ch = meta.channels[i];
+        query.addBindValue(imageId);
+        query.addBindValue(static_cast<int>(i));
+        query.addBindValue(ch.name);
+        query.addBindValue(QString::fromStdString(std::string(ch.acquisitionMode)));
+        query.addBindValue(ch.exWavelengthNm);
+        query.addBindValue(ch.emWavelengthNm);
+        query.addBindValue(ch.pinholeSizeNm);
+        query.addBindValue(ch.photonCount);
+        if (!query.exec())
+            return fail(query);
+    }
+
+    if (ownTransaction && !db.commit())
+        return std::unexpected(QStringLiteral("Failed to update catalog: %1").arg(db.lastError().text()));
+
+    return true;
+}
+
+std::expected<bool, QString> Catalog::recordFile(const QString &path, const ImageMetadata *params)
+{
+    auto entry = readEntry(path);
+    if (!entry)
+        return std::unexpected(entry.error());
+
+    if (params) {
+        entry->paramsJson = QString::fromUtf8(
+            QJsonDocument(MetadataJson::toJson(*params)).toJson(QJsonDocument::Compact));
+        entry->convertedAt = QDateTime::currentDateTime();
+    }
+
+    return addEntry(entry.value());
+}
+
+QHash<QString, std::pair<qint64, qint64>> Catalog::fileStamps(const QString &dirPath) const
+{
+    QHash<QString, std::pair<qint64, qint64>> stamps;
+    auto db = QSqlDatabase::database(m_connectionName, false);
+    if (!db.isOpen())
+        return stamps;
+
+    const auto [lower, upper] = directoryPathRange(dirPath);
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare(QStringLiteral("SELECT path, file_size, modified FROM images WHERE path >= ? AND path < ?"));
+    query.addBindValue(lower);
+    query.addBindValue(upper);
+    if (!query.exec()) {
+        qWarning().noquote() << sqlError(query);
+        return stamps;
+    }
+
+    while (query.next())
+        stamps.insert(query.value(0).toString(), {query.value(1).toLongLong(), query.value(2).toLongLong()});
+    return stamps;
+}
+
+std::expected<int, QString> Catalog::removeMissing(const QString &dirPath, const QSet<QString> &existing)
+{
+    const auto stamps = fileStamps(dirPath);
+    auto db = QSqlDatabase::database(m_connectionName, false);
+
+    int removed = 0;
+    QSqlQuery query(db);
+    query.prepare(QStringLiteral("DELETE FROM images WHERE path = ?"));
+    for (auto it = stamps.cbegin(); it != stamps.cend(); ++it) {
+        if (existing.contains(it.key()))
+            continue;
+
+        query.addBindValue(it.key());
+        if (!query.exec())
+            return std::unexpected(sqlError(query));
+        removed++;
+    }
+
+    return removed;
+}
+
+std::expected<QList<CatalogEntry>, QString> Catalog::search(const CatalogQuery &cq) const
+{
+    PERF_TRACE_SCOPE("Catalog::search", "catalog");
+    auto db = QSqlDatabase::database(m_connectionName, false);
+    if (!db.isOpen())
+        return std::unexpected(QStringLiteral("The catalog is not open."));
+
+    QStringList conditions;
+    QVariantList values;
+    if (!cq.text.isEmpty()) {
+        conditions.append(QStringLiteral("(i.path LIKE ? ESCAPE '\\' OR i.image_name LIKE ? ESCAPE '\\')"));
+        const auto pattern = QStringLiteral("%%1%").arg(escapeLike(cq.text));
+        values << pattern << pattern;
+    }
+    if (cq.numericalAperture > 0) {
+        conditions.append(QStringLiteral("i.na BETWEEN ? AND ?"));
+        values << cq.numericalAperture - 0.0005 << cq.numericalAperture + 0.0005;
+    }
+    if (cq.exWavelengthNm > 0) {
+        conditions.append(
+            QStringLiteral("EXISTS (SELECT 1 FROM channels c WHERE c.image_id = i.id AND c.ex_nm BETWEEN ? AND ?)"));
+        values << cq.exWavelengthNm - cq.wavelengthToleranceNm << cq.exWavelengthNm + cq.wavelengthToleranceNm;
+    }
+    if (cq.emWavelengthNm > 0) {
+        conditions.append(
+            QStringLiteral("EXISTS (SELECT 1 FROM channels c WHERE c.image_id = i.id AND c.em_nm BETWEEN ? AND ?)"));
+        values << cq.emWavelengthNm - cq.wavelengthToleranceNm << cq.emWavelengthNm + cq.wavelengthToleranceNm;
+    }
+    if (!cq.pixelType.isEmpty()) {
+        conditions.append(QStringLiteral("i.pixel_type = ?"));
+        values << cq.pixelType;
+    }
+    if (cq.missingMetadataOnly) {
+        conditions.append(QStringLiteral(
+            "(i.is_ome = 0 OR i.na <= 0 OR i.phys_x_nm <= 0 OR i.phys_y_nm <= 0"
+            " OR EXISTS (SELECT 1 FROM channels c WHERE c.image_id = i.id AND (c.ex_nm <= 0 OR c.em_nm <= 0)))"));
+    }
+
+    auto sql = QStringLiteral(
+        "SELECT i.id, i.path, i.file_size, i.modified, i.is_ome, i.image_name,"
+        " i.size_x, i.size_y, i.size_z, i.size_c, i.size_t, i.pixel_type, i.data_size,"
+        " i.phys_x_nm, i.phys_y_nm, i.phys_z_nm, i.na, i.immersion, i.medium, i.immersion_ri,"
+        " i.params_json, i.converted_at FROM images i");
+    if (!conditions.isEmpty())
+        sql += QStringLiteral(" WHERE ") + conditions.join(QStringLiteral(" AND "));
+    sql += QStringLiteral(" ORDER BY i.path LIMIT %1").arg(cq.limit);
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare(sql);
+    for (const auto &value : values)
+        query.addBindValue(value);
+    if (!query.exec())
+        return std::unexpected(sqlError(query));
+
+    QList<CatalogEntry> results;
+    QHash<qint64, qsizetype> indexById;
+    while (query.next()) {
+        CatalogEntry entry;
+        entry.path = query.value(1).toString();
+        entry.fileSize = query.value(2).toLongLong();
+        entry.modified = QDateTime::fromMSecsSinceEpoch(query.value(3).toLongLong());
+        entry.isOmeTiff = query.value(4).toBool();
+
+        auto &meta = entry.metadata;
+        meta.imageName = query.value(5).toString();
+        meta.sizeX = query.value(6).toInt();
+        meta.sizeY = query.value(7).toInt();
+        meta.sizeZ = query.value(8).toInt();
+        meta.sizeC = query.value(9).toInt();
+        meta.sizeT = query.value(10).toInt();
+        meta.pixelType = query.value(11).toString();
+        meta.dataSizeBytes = static_cast<size_t>(query.value(12).toLongLong());
+        meta.physSizeXNm = query.value(13).toDouble();
+        meta.physSizeYNm = query.value(14).toDouble();
+        meta.physSizeZNm = query.value(15).toDouble();
+        meta.numericalAperture = query.value(16).toDouble();
+        meta.lensImmersion = enumFromString(query.value(17).toString(), meta.lensImmersion);
+        meta.embeddingMedium = enumFromString(query.value(18).toString(), meta.embeddingMedium);
+        meta.immersionRI = query.value(19).toDouble();
+
+        entry.paramsJson = query.value(20).toString();
+        if (!query.value(21).isNull())
+            entry.convertedAt = QDateTime::fromMSecsSinceEpoch(query.value(21).toLongLong());
+
+        indexById.insert(query.value(0).toLongLong(), results.size());
+        results.append(std::move(entry));
+    }
+
+    // load the channels of all results with a few queries, instead of one per file
+    const auto ids = indexById.keys();
+    for (qsizetype start = 0; start < ids.size(); start += ChannelQueryBatchSize) {
+        QStringList idList;
+        for (auto i = start; i < std::min(ids.size(), start + ChannelQueryBatchSize); ++i)
+            idList.append(QString::number(ids[i]));
+
+        QSqlQuery chQuery(db);
+        chQuery.setForwardOnly(true);
+        if (!chQuery.exec(QStringLiteral(
+                              "SELECT image_id, name, acquisition_mode, ex_nm, em_nm, pinhole_nm, photon_count"
+                              " FROM channels WHERE image_id IN (%1) ORDER BY image_id, idx")
+                              .arg(idList.join(QLatin1Char(',')))))
+            return std::unexpected(sqlError(chQuery));
+
+        while (chQuery.next()) {
+            ChannelParams ch;
+            ch.name = chQuery.value(1).toString();
+            ch.acquisitionMode = enumFromString(chQuery.value(2).toString(), ch.acquisitionMode);
+            ch.exWavelengthNm = chQuery.value(3).toDouble();
+            ch.emWavelengthNm = chQuery.value(4).toDouble();
+            ch.pinholeSizeNm = chQuery.value(5).toDouble();
+            ch.photonCount = chQuery.value(6).toInt();
+            results[indexById.value(chQuery.value(0).toLongLong())].metadata.channels.push_back(ch);
+        }
+    }
+
+    return results;
+}
+
+int Catalog::entryCount() const
+{
+    QSqlQuery query(QSqlDatabase::database(m_connectionName, false));
+    if (!query.exec(QStringLiteral("SELECT COUNT(*) FROM images")) || !query.next())
+        return 0;
+    return query.value(0).toInt();
+}
+
+bool Catalog::beginTransaction()
+{
+    return QSqlDatabase::database(m_connectionName, false).transaction();
+}
+
+bool Catalog::commitTransaction()
+{
+    return QSqlDatabase::database(m_connectionName, false).commit();
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <expected>
+
+#include "ometiffimage.h"
+
+/**
+ * @brief A single image file known to the catalog.
+ */
+struct CatalogEntry {
+    QString path;
+    qint64 fileSize = 0;
+    QDateTime modified;
+    bool isOmeTiff = false;
+    ImageMetadata metadata;
+    QString paramsJson;    /// Parameter set the file was last written with, if it was written by us
+    QDateTime convertedAt; /// When the file was last written by us, invalid if never
+};
+
+/**
+ * @brief Filter for catalog searches. Fields left at their default match anything.
+ */
+struct CatalogQuery {
+    QString text;                      /// Part of the file path or image name
+    double numericalAperture = 0;      /// Exact NA, within rounding
+    double exWavelengthNm = 0;         /// Excitation wavelength of any channel
+    double emWavelengthNm = 0;         /// Emission wavelength of any channel
+    double wavelengthToleranceNm = 2;  /// Allowed deviation of the wavelength filters
+    QString pixelType;                 /// OME pixel type name
+    bool missingMetadataOnly = false;  /// Only files lacking physical sizes, NA or wavelengths
+    int limit = 5000;                  /// Maximum number of results
+};
+
+/**
+ * @brief Embedded SQLite database of image files that were opened, written or scanned.
+ *
+ * Every instance uses its own database connection, so it must only be used from
+ * the thread it was created on. Create a separate instance for each worker thread.
+ */
+class Catalog
+{
+public:
+    explicit Catalog(const QString &dbPath = defaultPath());
+    ~Catalog();
+
+    Catalog(const Catalog &) = delete;
+    Catalog &operator=(const Catalog &) = delete;
+
+    /**
+     * @brief Location of the catalog database in the application data directory.
+     */
+    [[nodiscard]] static QString defaultPath();
+
+    /**
+     * @brief Open the database and create or upgrade its schema.
+     */
+    std::expected<bool, QString> open();
+    [[nodiscard]] bool isOpen() const;
+
+    /**
+     * @brief Read the catalog entry for a file from disk.
+     *
+     * For OME-TIFF files only the OME-XML header is scanned, raw TIFF files are opened.
+     */
+    static std::expected<CatalogEntry, QString> readEntry(const QString &path);
+
+    /**
+     * @brief Add or replace the entry of a file.
+     *
+     * An empty parameter set keeps the one recorded previously.
+     */
+    std::expected<bool, QString> addEntry(const CatalogEntry &entry);
+
+    /**
+     * @brief Record a file that was opened or written, reading its metadata from disk.
+     * @param path The image file
+     * @param params Parameter set the file was written with, or nullptr if it was only opened.
+     */
+    std::expected<bool, QString> recordFile(const QString &path, const ImageMetadata *params = nullptr);
+
+    /**
+     * @brief Size and modification time (msecs since epoch) of all known files below a directory.
+     */
+    [[nodiscard]] QHash<QString, std::pair<qint64, qint64>> fileStamps(const QString &dirPath) const;
+
+    /**
+     * @brief Remove entries below a directory whose path is not in the given set.
+     * @return Number of removed entries
+     */
+    std::expected<int, QString> removeMissing(const QString &dirPath, const QSet<QString> &existing);
+
+    /**
+     * @brief Find all files matching a query, ordered by path.
+     */
+    [[nodiscard]] std::expected<QList<CatalogEntry>, QString> search(const CatalogQuery &query) const;
+
+    [[nodiscard]] int entryCount() const;
+
+    bool beginTransaction();
+    bool commitTransaction();
+
+private:
+    QString m_dbPath;
+    QString m_connectionName;
+};
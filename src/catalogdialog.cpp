@@ -0,0 +1,292 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include "catalogdialog.h"
+
+#include <QCheckBox>
+#include <QDialogButtonBox>
+#include <QDir>
+#include <QDoubleSpinBox>
+#include <QElapsedTimer>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QFormLayout>
+#include <QGridLayout>
+#include <QGroupBox>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QLocale>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QTimer>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+#include "catalog.h"
+
+namespace
+{
+enum Column {
+    ColumnFile,
+    ColumnDimensions,
+    ColumnPixelType,
+    ColumnNA,
+    ColumnExcitation,
+    ColumnEmission,
+    ColumnWritten,
+    ColumnCount
+};
+} // namespace
+
+static QString channelWavelengths(const ImageMetadata &meta, bool excitation)
+{
+    QStringList values;
+    for (const auto &ch : meta.channels) {
+        const auto nm = excitation ? ch.exWavelengthNm : ch.emWavelengthNm;
+        values.append(nm > 0 ? QString::number(nm, 'g', 4) : QStringLiteral("–"));
+    }
+    return values.join(QStringLiteral(", "));
+}
+
+CatalogDialog::CatalogDialog(Catalog *catalog, CatalogScanner *scanner, QWidget *parent)
+    : QDialog(parent),
+      m_catalog(catalog),
+      m_scanner(scanner)
+{
+    setWindowTitle(QStringLiteral("Dataset Catalog"));
+    resize(900, 600);
+
+    // Search filters
+    m_textEdit = new QLineEdit(this);
+    m_textEdit->setPlaceholderText(QStringLiteral("Part of the file path or image name"));
+    m_textEdit->setClearButtonEnabled(true);
+
+    m_naSpin = new QDoubleSpinBox(this);
+    m_naSpin->setRange(0, 2);
+    m_naSpin->setDecimals(2);
+    m_naSpin->setSingleStep(0.05);
+    m_naSpin->setSpecialValueText(QStringLiteral("Any"));
+
+    m_exSpin = new QSpinBox(this);
+    m_exSpin->setRange(0, 5000);
+    m_exSpin->setSuffix(QStringLiteral(" nm"));
+    m_exSpin->setSpecialValueText(QStringLiteral("Any"));
+
+    m_emSpin = new QSpinBox(this);
+    m_emSpin->setRange(0, 5000);
+    m_emSpin->setSuffix(QStringLiteral(" nm"));
+    m_emSpin->setSpecialValueText(QStringLiteral("Any"));
+
+    m_missingCheck = new QCheckBox(QStringLiteral("Only files with missing metadata"), this);
+    m_missingCheck->setToolTip(
+        QStringLiteral("Raw TIFF files, and files without physical sizes, NA or channel wavelengths"));
+
+    auto filterLayout = new QFormLayout;
+    filterLayout->addRow(QStringLiteral("Search:"), m_textEdit);
+    auto opticsLayout = new QHBoxLayout;
+    opticsLayout->addWidget(new QLabel(QStringLiteral("NA:"), this));
+    opticsLayout->addWidget(m_naSpin);
+    opticsLayout->addWidget(new QLabel(QStringLiteral("Excitation:"), this));
+    opticsLayout->addWidget(m_exSpin);
+    opticsLayout->addWidget(new QLabel(QStringLiteral("Emission:"), this));
+    opticsLayout->addWidget(m_emSpin);
+    opticsLayout->addStretch();
+    opticsLayout->addWidget(m_missingCheck);
+    filterLayout->addRow(opticsLayout);
+
+    // Results
+    m_resultTree = new QTreeWidget(this);
+    m_resultTree->setColumnCount(ColumnCount);
+    m_resultTree->setHeaderLabels(
+        {QStringLiteral("File"),
+         QStringLiteral("Dimensions"),
+         QStringLiteral("Pixel Type"),
+         QStringLiteral("NA"),
+         QStringLiteral("Excitation"),
+         QStringLiteral("Emission"),
+         QStringLiteral("Written")});
+    m_resultTree->setRootIsDecorated(false);
+    m_resultTree->setUniformRowHeights(true);
+    m_resultTree->setAlternatingRowColors(true);
+    m_resultTree->header()->setSectionResizeMode(ColumnFile, QHeaderView::Stretch);
+    m_resultTree->header()->setStretchLastSection(false);
+    m_resultLabel = new QLabel(this);
+
+    // Scanned directories
+    auto dirBox = new QGroupBox(QStringLiteral("Scanned Directories"), this);
+    m_dirList = new QListWidget(dirBox);
+    m_dirList->addItems(m_scanner->directories());
+    m_dirList->setMaximumHeight(90);
+    auto btnAddDir = new QPushButton(QStringLiteral("Add..."), dirBox);
+    btnAddDir->setIcon(QIcon::fromTheme(QIcon::ThemeIcon::ListAdd));
+    auto btnRemoveDir = new QPushButton(QStringLiteral("Remove"), dirBox);
+    btnRemoveDir->setIcon(QIcon::fromTheme(QIcon::ThemeIcon::ListRemove));
+    m_btnScan = new QPushButton(QStringLiteral("Scan Now"), dirBox);
+    m_btnScan->setIcon(QIcon::fromTheme(QIcon::ThemeIcon::ViewRefresh));
+    m_scanLabel = new QLabel(dirBox);
+
+    auto dirButtonLayout = new QVBoxLayout;
+    dirButtonLayout->addWidget(btnAddDir);
+    dirButtonLayout->addWidget(btnRemoveDir);
+    dirButtonLayout->addWidget(m_btnScan);
+    dirButtonLayout->addStretch();
+    auto dirLayout = new QGridLayout(dirBox);
+    dirLayout->addWidget(m_dirList, 0, 0);
+    dirLayout->addLayout(dirButtonLayout, 0, 1);
+    dirLayout->addWidget(m_scanLabel, 1, 0, 1, 2);
+
+    auto buttonBox = new QDialogButtonBox(QDialogButtonBox::Close, this);
+
+    auto layout = new QVBoxLayout(this);
+    layout->addLayout(filterLayout);
+    layout->addWidget(m_resultTree, 1);
+    layout->addWidget(m_resultLabel);
+    layout->addWidget(dirBox);
+    layout->addWidget(buttonBox);
+
+    // search while typing, but not for every single keystroke
+    m_searchTimer = new QTimer(this);
+    m_searchTimer->setSingleShot(true);
+    m_searchTimer->setInterval(150);
+    connect(m_searchTimer, &QTimer::timeout, this, &CatalogDialog::runSearch);
+    const auto scheduleSearch = [this]() {
+        m_searchTimer->start();
+    };
+    connect(m_textEdit, &QLineEdit::textChanged, this, scheduleSearch);
+    connect(m_naSpin, &QDoubleSpinBox::valueChanged, this, scheduleSearch);
+    connect(m_exSpin, &QSpinBox::valueChanged, this, scheduleSearch);
+    connect(m_emSpin, &QSpinBox::valueChanged, this, scheduleSearch);
+    connect(m_missingCheck, &QCheckBox::toggled, this, scheduleSearch);
+
+    connect(m_resultTree, &QTreeWidget::itemActivated, this, [this](QTreeWidgetItem *item) {
+        emit openFileRequested(item->data(ColumnFile, Qt::UserRole).toString());
+    });
+    connect(btnAddDir, &QPushButton::clicked, this, &CatalogDialog::onAddDirectoryClicked);
+    connect(btnRemoveDir, &QPushButton::clicked, this, &CatalogDialog::onRemoveDirectoryClicked);
+    connect(m_btnScan, &QPushButton::clicked, m_scanner, &CatalogScanner::start);
+    connect(buttonBox, &QDialogButtonBox::rejected, this, &QDialog::reject);
+
+    connect(m_scanner, &CatalogScanner::started, this, &CatalogDialog::updateScanStatus);
+    connect(m_scanner, &CatalogScanner::progressChanged, this, [this](int filesScanned) {
+        m_scanLabel->setText(QStringLiteral("Scanning... %1 files checked").arg(filesScanned));
+    });
+    connect(m_scanner, &CatalogScanner::finished, this, &CatalogDialog::onScanFinished);
+
+    updateScanStatus();
+    runSearch();
+}
+
+CatalogDialog::~CatalogDialog() = default;
+
+void CatalogDialog::runSearch()
+{
+    CatalogQuery query;
+    query.text = m_textEdit->text().trimmed();
+    query.numericalAperture = m_naSpin->value();
+    query.exWavelengthNm = m_exSpin->value();
+    query.emWavelengthNm = m_emSpin->value();
+    query.missingMetadataOnly = m_missingCheck->isChecked();
+
+    QElapsedTimer timer;
+    timer.start();
+    const auto results = m_catalog->search(query);
+    const auto searchMs = timer.nsecsElapsed() / 1000000.0;
+
+    m_resultTree->clear();
+    if (!results) {
+        m_resultLabel->setText(results.error());
+        return;
+    }
+
+    QList<QTreeWidgetItem *> items;
+    items.reserve(results->size());
+    for (const auto &entry : results.value()) {
+        const auto &meta = entry.metadata;
+        auto item = new QTreeWidgetItem;
+        item->setText(ColumnFile, QFileInfo(entry.path).fileName());
+        item->setToolTip(ColumnFile, entry.path);
+        item->setData(ColumnFile, Qt::UserRole, entry.path);
+        item->setText(
+            ColumnDimensions,
+            QStringLiteral("%1×%2, Z:%3 T:%4 C:%5")
+                .arg(meta.sizeX)
+                .arg(meta.sizeY)
+                .arg(meta.sizeZ)
+                .arg(meta.sizeT)
+                .arg(meta.sizeC));
+        item->setText(ColumnPixelType, meta.pixelType);
+        item->setText(ColumnNA, meta.numericalAperture > 0 ? QString::number(meta.numericalAperture) : QString());
+        item->setText(ColumnExcitation, channelWavelengths(meta, true));
+        item->setText(ColumnEmission, channelWavelengths(meta, false));
+        if (entry.convertedAt.isValid()) {
+            item->setText(ColumnWritten, QLocale().toString(entry.convertedAt, QLocale::ShortFormat));
+            item->setToolTip(ColumnWritten, entry.paramsJson);
+        }
+        items.append(item);
+    }
+    m_resultTree->addTopLevelItems(items);
+
+    m_resultLabel->setText(
+        QStringLiteral("%1 matching file(s) of %2 in the catalog, found in %3 ms")
+            .arg(results->size())
+            .arg(m_catalog->entryCount())
+            .arg(searchMs, 0, 'f', 1));
+}
+
+void CatalogDialog::onAddDirectoryClicked()
+{
+    const auto dir = QFileDialog::getExistingDirectory(this, QStringLiteral("Add Directory to Catalog"));
+    if (dir.isEmpty())
+        return;
+
+    auto dirs = m_scanner->directories();
+    const auto cleanDir = QDir::cleanPath(dir);
+    if (dirs.contains(cleanDir))
+        return;
+
+    dirs.append(cleanDir);
+    m_scanner->setDirectories(dirs);
+    m_dirList->addItem(cleanDir);
+    m_scanner->start();
+}
+
+void CatalogDialog::onRemoveDirectoryClicked()
+{
+    const auto selected = m_dirList->selectedItems();
+    if (selected.isEmpty())
+        return;
+
+    auto dirs = m_scanner->directories();
+    for (auto item : selected)
+        dirs.removeAll(item->text());
+    m_scanner->setDirectories(dirs);
+    qDeleteAll(selected);
+}
+
+void CatalogDialog::onScanFinished(const CatalogScanner::Summary &summary)
+{
+    m_btnScan->setEnabled(true);
+    m_scanLabel->setText(
+        QStringLiteral("Last scan: %1 files, %2 updated, %3 removed, %4 unreadable")
+            .arg(summary.scanned)
+            .arg(summary.updated)
+            .arg(summary.removed)
+            .arg(summary.failed));
+    runSearch();
+}
+
+void CatalogDialog::updateScanStatus()
+{
+    const bool running = m_scanner->isRunning();
+    m_btnScan->setEnabled(!running);
+    if (running)
+        m_scanLabel->setText(QStringLiteral("Scanning..."));
+    else if (m_dirList->count() == 0)
+        m_scanLabel->setText(QStringLiteral("Add directories to keep track of the image files they contain."));
+}
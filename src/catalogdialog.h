@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <QDialog>
+
+#include "catalogscanner.h"
+
+class QCheckBox;
+class QDoubleSpinBox;
+class QLabel;
+class QLineEdit;
+class QListWidget;
+class QPushButton;
+class QSpinBox;
+class QTimer;
+class QTreeWidget;
+class Catalog;
+
+/**
+ * @brief Search the catalog of known image files, and manage the directories it scans.
+ */
+class CatalogDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit CatalogDialog(Catalog *catalog, CatalogScanner *scanner, QWidget *parent = nullptr);
+    ~CatalogDialog() override;
+
+signals:
+    /**
+     * @brief Emitted when the user wants to open a file from the results.
+     */
+    void openFileRequested(const QString &path);
+
+private:
+    void runSearch();
+    void onAddDirectoryClicked();
+    void onRemoveDirectoryClicked();
+    void onScanFinished(const CatalogScanner::Summary &summary);
+    void updateScanStatus();
+
+    Catalog *m_catalog;
+    CatalogScanner *m_scanner;
+    QTimer *m_searchTimer;
+
+    QLineEdit *m_textEdit;
+    QDoubleSpinBox *m_naSpin;
+    QSpinBox *m_exSpin;
+    QSpinBox *m_emSpin;
+    QCheckBox *m_missingCheck;
+    QTreeWidget *m_resultTree;
+    QLabel *m_resultLabel;
+
+    QListWidget *m_dirList;
+    QPushButton *m_btnScan;
+    QLabel *m_scanLabel;
+};
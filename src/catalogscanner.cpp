@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include "catalogscanner.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QPromise>
+#include <QSet>
+#include <QSettings>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include "catalog.h"
+#include "perftrace.h"
+
+// Files modified more recently than this may still be written to, and are picked up by the next scan
+static constexpr qint64 MinFileAgeMs = 10000;
+
+// Number of updated entries written to the catalog in one transaction
+static constexpr int TransactionBatchSize = 100;
+
+// Number of files between two progress notifications
+static constexpr int ProgressInterval = 50;
+
+static void runScan(QPromise<CatalogScanner::Summary> &promise, const QStringList &dirs, const QString &dbPath)
+{
+    PERF_TRACE_SCOPE("CatalogScanner::scan", "catalog");
+    CatalogScanner::Summary summary;
+    QElapsedTimer timer;
+    timer.start();
+
+    Catalog catalog(dbPath);
+    const auto r = catalog.open();
+    if (!r) {
+        qWarning().noquote() << r.error();
+        promise.addResult(summary);
+        return;
+    }
+
+    const auto now = QDateTime::currentDateTime();
+    for (const auto &dir : dirs) {
+        if (!QFileInfo(dir).isDir())
+            continue;
+
+        const auto stamps = catalog.fileStamps(dir);
+        QSet<QString> seen;
+        int pending = 0;
+
+        catalog.beginTransaction();
+        QDirIterator it(
+            dir,
+            {QStringLiteral("*.tif"), QStringLiteral("*.tiff")},
+            QDir::Files | QDir::Readable,
+            QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            if (promise.isCanceled()) {
+                catalog.commitTransaction();
+                promise.addResult(summary);
+                return;
+            }
+
+            const auto fi = it.nextFileInfo();
+            const auto path = fi.absoluteFilePath();
+
+            // never index our own temporary output
+            if (path.contains(QStringLiteral("/_temp-omewrite")))
+                continue;
+
+            seen.insert(path);
+            if (++summary.scanned % ProgressInterval == 0)
+                promise.setProgressValue(summary.scanned);
+
+            const auto mtime = fi.lastModified();
+            const auto stamp = stamps.value(path, {-1, -1});
+            if (stamp.first == fi.size() && stamp.second == mtime.toMSecsSinceEpoch())
+                continue;
+            if (mtime.msecsTo(now) < MinFileAgeMs)
+                continue;
+
+            const auto entry = Catalog::readEntry(path);
+            if (!entry) {
+                qDebug().noquote() << "Catalog: skipping" << path << "-" << entry.error();
+                summary.failed++;
+                continue;
+            }
+            const auto added = catalog.addEntry(entry.value());
+            if (!added) {
+                qWarning().noquote() << added.error();
+                summary.failed++;
+                continue;
+            }
+            summary.updated++;
+
+            if (++pending >= TransactionBatchSize) {
+                catalog.commitTransaction();
+                catalog.beginTransaction();
+                pending = 0;
+            }
+        }
+
+        const auto removed = catalog.removeMissing(dir, seen);
+        catalog.commitTransaction();
+        if (removed)
+            summary.removed += removed.value();
+        else
+            qWarning().noquote() << removed.error();
+    }
+
+    qDebug().noquote() << QStringLiteral("Catalog scan: %1 files, %2 updated, %3 removed, %4 failed in %5 ms")
+                              .arg(summary.scanned)
+                              .arg(summary.updated)
+                              .arg(summary.removed)
+                              .arg(summary.failed)
+                              .arg(timer.elapsed());
+    promise.addResult(summary);
+}
+
+CatalogScanner::CatalogScanner(const QString &dbPath, QObject *parent)
+    : QObject(parent),
+      m_dbPath(dbPath)
+{
+    connect(&m_watcher, &QFutureWatcher<Summary>::progressValueChanged, this, &CatalogScanner::progressChanged);
+    connect(&m_watcher, &QFutureWatcher<Summary>::finished, this, [this]() {
+        emit finished(m_future.resultCount() > 0 ? m_future.result() : Summary());
+    });
+}
+
+CatalogScanner::~CatalogScanner()
+{
+    m_watcher.disconnect(this);
+    m_future.cancel();
+    m_future.waitForFinished();
+}
+
+QStringList CatalogScanner::directories() const
+{
+    QSettings settings("OMERewriter", "OMERewriter");
+    return settings.value("catalog/directories").toStringList();
+}
+
+void CatalogScanner::setDirectories(const QStringList &dirs)
+{
+    QSettings settings("OMERewriter", "OMERewriter");
+    settings.setValue("catalog/directories", dirs);
+}
+
+void CatalogScanner::start()
+{
+    if (isRunning())
+        return;
+
+    const auto dirs = directories();
+    if (dirs.isEmpty())
+        return;
+
+    m_future = QtConcurrent::run(runScan, dirs, m_dbPath);
+    m_watcher.setFuture(m_future);
+    emit started();
+}
+
+void CatalogScanner::cancel()
+{
+    m_future.cancel();
+}
+
+bool CatalogScanner::isRunning() const
+{
+    return m_future.isRunning();
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QStringList>
+
+/**
+ * @brief Keeps the catalog up to date with the image files in a set of directories.
+ *
+ * Scans run on a worker thread with their own catalog connection. Only files that
+ * are new, or whose size or modification time changed, are read again, and entries
+ * of files that disappeared are dropped.
+ */
+class CatalogScanner : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Summary {
+        int scanned = 0; /// Image files found
+        int updated = 0; /// Files that were (re)read
+        int removed = 0; /// Entries of files that no longer exist
+        int failed = 0;  /// Files that could not be read
+    };
+
+    explicit CatalogScanner(const QString &dbPath, QObject *parent = nullptr);
+    ~CatalogScanner() override;
+
+    /**
+     * @brief Directories that are scanned, including their subdirectories.
+     */
+    [[nodiscard]] QStringList directories() const;
+    void setDirectories(const QStringList &dirs);
+
+    /**
+     * @brief Start a scan of all directories, unless one is running already.
+     */
+    void start();
+    void cancel();
+    [[nodiscard]] bool isRunning() const;
+
+signals:
+    void started();
+    void progressChanged(int filesScanned);
+    void finished(const CatalogScanner::Summary &summary);
+
+private:
+    QString m_dbPath;
+    QFuture<Summary> m_future;
+    QFutureWatcher<Summary> m_watcher;
+};
@@ -0,0 +1,334 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include "codecselector.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QSettings>
+#include <QThread>
+#include <algorithm>
+#include <iterator>
+
+#include <ome/files/VariantPixelBuffer.h>
+
+#include "perftrace.h"
+
+using ome::files::VariantPixelBuffer;
+using Compression = Hdf5ExportOptions::Compression;
+
+// Planes that are compressed with every candidate, and how much of them is used
+static constexpr quint64 MaxSamplePlanes = 8;
+static constexpr size_t MaxSampleBytes = 8 * 1024 * 1024;
+
+// Levels libtiff compresses with, as ome-files does not let us choose them
+static constexpr int TiffDeflateLevel = 6;
+static constexpr int TiffZstdLevel = 9;
+
+Hdf5ExportOptions tiffCompressionModel(TiffCompression compression)
+{
+    Hdf5ExportOptions options;
+    options.shuffle = false;
+    if (compression == TiffCompression::Zstd) {
+        options.compression = Compression::Zstd;
+        options.level = TiffZstdLevel;
+    } else {
+        options.compression = Compression::Deflate;
+        options.level = TiffDeflateLevel;
+    }
+
+    return options;
+}
+
+std::expected<CompressionGoal, QString> CompressionGoal::fromString(const QString &text)
+{
+    const auto parts = text.trimmed().split(QLatin1Char(':'));
+    CompressionGoal goal;
+    if (parts[0] == QStringLiteral("ratio")) {
+        goal.objective = Objective::Ratio;
+        goal.minMBps = 0;
+    } else if (parts[0] == QStringLiteral("speed")) {
+        goal.objective = Objective::Speed;
+        goal.minRatio = 1;
+    } else {
+        return std::unexpected(QStringLiteral("Unknown compression goal: %1").arg(text));
+    }
+
+    if (parts.size() > 2)
+        return std::unexpected(QStringLiteral("Invalid compression goal: %1").arg(text));
+    if (parts.size() == 2) {
+        bool ok = false;
+        const auto value = parts[1].toDouble(&ok);
+        if (!ok || value < 0)
+            return std::unexpected(QStringLiteral("Invalid limit in compression goal: %1").arg(text));
+        if (goal.objective == Objective::Ratio)
+            goal.minMBps = value;
+        else
+            goal.minRatio = value;
+    }
+
+    return goal;
+}
+
+CompressionGoal CompressionGoal::fromSettings()
+{
+    QSettings settings("OMERewriter", "OMERewriter");
+    const auto goal = fromString(settings.value("saving/compressionGoal", "ratio:100").toString());
+    if (!goal) {
+        qWarning().noquote() << goal.error();
+        return {};
+    }
+
+    return goal.value();
+}
+
+QString CompressionGoal::toString() const
+{
+    if (objective == Objective::Speed)
+        return QStringLiteral("speed:%1").arg(minRatio);
+    return QStringLiteral("ratio:%1").arg(minMBps);
+}
+
+QString CodecTrial::name() const
+{
+    QString codec;
+    switch (compression) {
+    case Compression::None:
+        codec = QStringLiteral("none");
+        break;
+    case Compression::Deflate:
+        codec = QStringLiteral("deflate-%1").arg(level);
+        break;
+    case Compression::Zstd:
+        codec = QStringLiteral("zstd-%1").arg(level);
+        break;
+    }
+
+    return shuffle ? QStringLiteral("shuffle+") + codec : codec;
+}
+
+void CodecChoice::applyTo(TiffCompression &compression, Hdf5ExportOptions &options) const
+{
+    compression = chosen.compression == Compression::Zstd ? TiffCompression::Zstd : TiffCompression::Deflate;
+    options.compression = chosen.compression;
+    options.level = chosen.level;
+    options.shuffle = chosen.shuffle;
+}
+
+QJsonObject CodecChoice::toJson() const
+{
+    QJsonArray trialList;
+    for (const auto &trial : trials)
+        trialList.append(
+            QJsonObject{
+                {"codec", trial.name()},
+                {"ratio", trial.ratio},
+                {"mbPerSec", trial.mbPerSec},
+            });
+
+    return QJsonObject{
+        {"goal", goal.toString()},
+        {"chosen", chosen.name()},
+        {"goalMet", goalMet},
+        {"samplePlanes", static_cast<qint64>(samplePlanes)},
+        {"sampleBytes", static_cast<qint64>(sampleBytes)},
+        {"sampleMs", sampleMs},
+        {"trials", trialList},
+    };
+}
+
+CodecSelector::CodecSelector(OMETiffImage &image, const CompressionGoal &goal)
+    : m_image(image),
+      m_goal(goal)
+{
+}
+
+std::expected<CodecChoice, QString> CodecSelector::selectTiffCompression()
+{
+    const auto candidate = [](TiffCompression compression) {
+        const auto model = tiffCompressionModel(compression);
+        return std::vector<CodecTrial>{{model.compression, model.level, model.shuffle}};
+    };
+    std::vector<std::vector<CodecTrial>> ladders = {candidate(TiffCompression::Deflate)};
+    if (OMETiffImage::isCompressionAvailable(TiffCompression::Zstd)
+        && Hdf5ExportOptions::isCompressionAvailable(Compression::Zstd))
+        ladders.push_back(candidate(TiffCompression::Zstd));
+
+    // libtiff compresses on the thread that writes the file
+    return select(ladders, 1, TiffModelBlockBytes);
+}
+
+std::expected<CodecChoice, QString> CodecSelector::selectHdf5Compression(const Hdf5ExportOptions &options)
+{
+    std::vector<std::vector<CodecTrial>> ladders;
+    for (const bool shuffle : {true, false}) {
+        ladders.push_back(
+            {{Compression::Deflate, 1, shuffle},
+             {Compression::Deflate, 4, shuffle},
+             {Compression::Deflate, 6, shuffle},
+             {Compression::Deflate, 9, shuffle}});
+        if (Hdf5ExportOptions::isCompressionAvailable(Compression::Zstd))
+            ladders.push_back(
+                {{Compression::Zstd, 1, shuffle},
+                 {Compression::Zstd, 3, shuffle},
+                 {Compression::Zstd, 9, shuffle},
+                 {Compression::Zstd, 15, shuffle}});
+    }
+
+    // the exporter compresses all chunks of a block of frames concurrently
+    const auto pixelBytes = m_image.planeSizeBytes() / std::max<size_t>(m_image.sizeX() * m_image.sizeY(), 1);
+    const auto chunkBytes = static_cast<size_t>(options.chunkFrames) * options.chunkY * options.chunkX * pixelBytes;
+    return select(ladders, std::max(QThread::idealThreadCount(), 1), std::max<size_t>(chunkBytes, 1));
+}
+
+std::expected<bool, QString> CodecSelector::readSample(size_t blockBytes)
+{
+    m_blocks.clear();
+    m_samplePlanes = 0;
+
+    const auto sizeZ = m_image.sizeZ();
+    const auto sizeC = m_image.sizeC();
+    const auto sizeT = m_image.sizeT();
+    const auto total = sizeZ * sizeC * sizeT;
+    if (total == 0 || m_image.sizeY() == 0)
+        return std::unexpected(QStringLiteral("The image has no planes to sample"));
+    const auto count = std::min<quint64>(MaxSamplePlanes, total);
+    const auto planeBudget = MaxSampleBytes / count;
+
+    for (quint64 i = 0; i < count; ++i) {
+        // the middle of every stretch of planes, going through time first
+        const auto index = (2 * i + 1) * total / (2 * count);
+        const auto t = index / (sizeZ * sizeC);
+        const auto c = index / sizeZ % sizeC;
+        const auto z = index % sizeZ;
+
+        VariantPixelBuffer buf;
+        const auto r = m_image.readPlaneData(z, c, t, buf);
+        if (!r)
+            return std::unexpected(r.error());
+
+        std::visit(
+            [&](const auto &pixels) {
+                if (!pixels)
+                    return;
+                m_elementSize = sizeof(*pixels->data());
+                const auto data = reinterpret_cast<const unsigned char *>(pixels->data());
+                const auto planeBytes = pixels->num_elements() * m_elementSize;
+
+                // a band of rows from the center, where the specimen usually is
+                const auto rowBytes = planeBytes / m_image.sizeY();
+                const auto rows = std::clamp<size_t>(planeBudget / std::max<size_t>(rowBytes, 1), 1, m_image.sizeY());
+                const auto bandStart = data + (m_image.sizeY() - rows) / 2 * rowBytes;
+                const auto bandBytes = rows * rowBytes;
+
+                const auto block = std::max(blockBytes - blockBytes % m_elementSize, m_elementSize);
+                for (size_t offset = 0; offset < bandBytes; offset += block) {
+                    const auto size = std::min(block, bandBytes - offset);
+                    m_blocks.emplace_back(bandStart + offset, bandStart + offset + size);
+                }
+            },
+            buf.vbuffer());
+        m_samplePlanes++;
+    }
+
+    return true;
+}
+
+CodecTrial CodecSelector::runTrial(CodecTrial trial, int threads) const
+{
+    Hdf5ExportOptions options;
+    options.compression = trial.compression;
+    options.level = trial.level;
+    options.shuffle = trial.shuffle;
+
+    quint64 bytesIn = 0;
+    quint64 bytesOut = 0;
+    qint64 nsecs = 0;
+    QElapsedTimer timer;
+    for (const auto &block : m_blocks) {
+        auto data = block;
+        timer.start();
+        const auto encoded = options.encode(std::move(data), m_elementSize);
+        nsecs += timer.nsecsElapsed();
+        if (encoded.empty())
+            return trial;
+
+        bytesIn += block.size();
+        bytesOut += encoded.size();
+    }
+
+    trial.ratio = bytesOut > 0 ? static_cast<double>(bytesIn) / static_cast<double>(bytesOut) : 0;
+    trial.mbPerSec = nsecs > 0 ? bytesIn * 1000.0 / static_cast<double>(nsecs) * threads : 0;
+    return trial;
+}
+
+std::expected<CodecChoice, QString> CodecSelector::select(
+    const std::vector<std::vector<CodecTrial>> &ladders,
+    int threads,
+    size_t blockBytes)
+{
+    PERF_TRACE_SCOPE("CodecSelector::select", "save");
+    QElapsedTimer timer;
+    timer.start();
+
+    const auto r = readSample(blockBytes);
+    if (!r)
+        return std::unexpected(r.error());
+
+    CodecChoice choice;
+    choice.goal = m_goal;
+    choice.samplePlanes = m_samplePlanes;
+    for (const auto &block : m_blocks)
+        choice.sampleBytes += block.size();
+
+    const bool forRatio = m_goal.objective == CompressionGoal::Objective::Ratio;
+    const auto meetsGoal = [&](const CodecTrial &trial) {
+        return forRatio ? trial.mbPerSec >= m_goal.minMBps : trial.ratio >= m_goal.minRatio;
+    };
+    for (const auto &ladder : ladders) {
+        for (const auto &candidate : ladder) {
+            const auto trial = runTrial(candidate, threads);
+            if (trial.ratio <= 0)
+                continue;
+            choice.trials.push_back(trial);
+
+            // higher levels only compress slower, so they can neither get back above the
+            // throughput limit, nor be faster than a level that already reaches the ratio
+            if (forRatio != meetsGoal(trial))
+                break;
+        }
+    }
+    if (choice.trials.empty())
+        return std::unexpected(QStringLiteral("None of the compression methods could compress the sampled planes"));
+
+    const auto byRatio = [](const CodecTrial &a, const CodecTrial &b) {
+        return a.ratio < b.ratio;
+    };
+    const auto bySpeed = [](const CodecTrial &a, const CodecTrial &b) {
+        return a.mbPerSec < b.mbPerSec;
+    };
+    std::vector<CodecTrial> eligible;
+    std::ranges::copy_if(choice.trials, std::back_inserter(eligible), meetsGoal);
+    if (eligible.empty()) {
+        // nothing reaches the goal, so get as close to it as possible
+        choice.goalMet = false;
+        choice.chosen = forRatio ? *std::ranges::max_element(choice.trials, bySpeed)
+                                 : *std::ranges::max_element(choice.trials, byRatio);
+    } else {
+        choice.chosen = forRatio ? *std::ranges::max_element(eligible, byRatio)
+                                 : *std::ranges::max_element(eligible, bySpeed);
+    }
+
+    choice.sampleMs = timer.nsecsElapsed() / 1000000.0;
+    qDebug().noquote() << QStringLiteral("Chose %1 for goal %2 (ratio %3, %4 MB/s) after %5 trials in %6 ms")
+                              .arg(choice.chosen.name(), m_goal.toString())
+                              .arg(choice.chosen.ratio, 0, 'f', 2)
+                              .arg(choice.chosen.mbPerSec, 0, 'f', 0)
+                              .arg(choice.trials.size())
+                              .arg(choice.sampleMs, 0, 'f', 0);
+    return choice;
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <QJsonObject>
+#include <QString>
+#include <expected>
+#include <vector>
+
+#include "hdf5exporter.h"
+#include "ometiffimage.h"
+
+/**
+ * @brief What the automatic compression selection optimizes for.
+ *
+ * Written as "ratio:300" for the smallest output that is still compressed at 300 MB/s
+ * or faster, or as "speed:2" for the fastest setting that still halves the size.
+ */
+struct CompressionGoal {
+    enum class Objective {
+        Ratio, /// Best compression ratio at or above minMBps
+        Speed  /// Highest throughput at or above minRatio
+    };
+
+    Objective objective = Objective::Ratio;
+    double minMBps = 100; /// Slowest acceptable compression throughput, for the ratio objective
+    double minRatio = 1;  /// Lowest acceptable compression ratio, for the speed objective
+
+    /**
+     * @brief Parse a goal like "ratio", "ratio:300", "speed" or "speed:2".
+     *
+     * Without a limit, "ratio" picks the best ratio at any speed, and "speed" the
+     * fastest setting that makes the data smaller at all.
+     */
+    static std::expected<CompressionGoal, QString> fromString(const QString &text);
+
+    /**
+     * @brief Read the goal from the application settings.
+     */
+    static CompressionGoal fromSettings();
+
+    [[nodiscard]] QString toString() const;
+};
+
+/**
+ * @brief Compression setting, and how it performed on the sampled planes.
+ */
+struct CodecTrial {
+    Hdf5ExportOptions::Compression compression = Hdf5ExportOptions::Compression::Deflate;
+    int level = 0;
+    bool shuffle = false;
+
+    double ratio = 0;    /// Uncompressed size divided by the compressed size
+    double mbPerSec = 0; /// Expected compression throughput of the writer, in MB of pixel data per second
+
+    /**
+     * @brief Short name of the setting, e.g. "shuffle+zstd-3".
+     */
+    [[nodiscard]] QString name() const;
+};
+
+/**
+ * @brief Setting picked by CodecSelector, and the measurements it was based on.
+ */
+struct CodecChoice {
+    CompressionGoal goal;
+    CodecTrial chosen;
+    bool goalMet = true; /// false if no setting reached the goal, and the closest one was picked
+    quint64 samplePlanes = 0;
+    quint64 sampleBytes = 0;
+    double sampleMs = 0; /// Reading the sample and running all trials
+    std::vector<CodecTrial> trials;
+
+    /**
+     * @brief Use the chosen setting for whichever format is written.
+     */
+    void applyTo(TiffCompression &compression, Hdf5ExportOptions &options) const;
+
+    /**
+     * @brief Describe the decision for the job report.
+     */
+    [[nodiscard]] QJsonObject toJson() const;
+};
+
+/**
+ * @brief Get chunk filters that compress like libtiff does with the given OME-TIFF codec.
+ *
+ * libtiff compresses every strip on its own, which is modelled by compressing blocks
+ * of TiffModelBlockBytes with these options.
+ */
+Hdf5ExportOptions tiffCompressionModel(TiffCompression compression);
+inline constexpr size_t TiffModelBlockBytes = 256 * 1024;
+
+/**
+ * @brief Picks the compression of a save by compressing a sample of the planes of an image.
+ *
+ * Planes are sampled evenly across all time points, channels and slices, so sparse
+ * and dense regions of a recording are both represented. Every candidate setting
+ * compresses the same sample on one thread; the measured throughput is scaled by
+ * the number of threads the writer compresses on. Levels of a codec are tried in
+ * order of increasing effort, and skipped once they can no longer win.
+ *
+ * The sample is taken from the source pixel data, so the effect of a pixel type
+ * conversion or of combining frames on the compressibility is not accounted for.
+ */
+class CodecSelector
+{
+public:
+    CodecSelector(OMETiffImage &image, const CompressionGoal &goal);
+
+    /**
+     * @brief Choose between the OME-TIFF codecs, at the levels libtiff writes them with.
+     */
+    std::expected<CodecChoice, QString> selectTiffCompression();
+
+    /**
+     * @brief Choose the codec, level and shuffle filter of HDF5 chunks.
+     * @param options Chunk shape to sample with, the compression settings are ignored.
+     */
+    std::expected<CodecChoice, QString> selectHdf5Compression(const Hdf5ExportOptions &options);
+
+private:
+    std::expected<bool, QString> readSample(size_t blockBytes);
+    CodecTrial runTrial(CodecTrial trial, int threads) const;
+    std::expected<CodecChoice, QString> select(
+        const std::vector<std::vector<CodecTrial>> &ladders,
+        int threads,
+        size_t blockBytes);
+
+    OMETiffImage &m_image;
+    CompressionGoal m_goal;
+    size_t m_elementSize = 1;
+    quint64 m_samplePlanes = 0;
+    std::vector<std::vector<unsigned char>> m_blocks;
+};
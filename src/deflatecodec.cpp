@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include "deflatecodec.h"
+
+#include <QSettings>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <zlib.h>
+
+#include "config.h"
+
+#ifdef HAVE_LIBDEFLATE
+#include <libdeflate.h>
+#endif
+
+namespace DeflateCodec
+{
+
+// -1 until the backend was read from the settings
+static std::atomic<int> g_backend{-1};
+
+#ifdef HAVE_LIBDEFLATE
+struct CompressorDeleter {
+    void operator()(libdeflate_compressor *c) const
+    {
+        libdeflate_free_compressor(c);
+    }
+};
+
+struct DecompressorDeleter {
+    void operator()(libdeflate_decompressor *d) const
+    {
+        libdeflate_free_decompressor(d);
+    }
+};
+
+// libdeflate's (de)compressors can not be shared between threads, and are
+// expensive to allocate, so every thread keeps its own around.
+
+static libdeflate_compressor *threadCompressor(int level)
+{
+    thread_local std::array<std::unique_ptr<libdeflate_compressor, CompressorDeleter>, 10> compressors;
+    auto &compressor = compressors[level];
+    if (!compressor)
+        compressor.reset(libdeflate_alloc_compressor(level));
+    return compressor.get();
+}
+
+static libdeflate_decompressor *threadDecompressor()
+{
+    thread_local std::unique_ptr<libdeflate_decompressor, DecompressorDeleter> decompressor(
+        libdeflate_alloc_decompressor());
+    return decompressor.get();
+}
+#endif
+
+bool isAvailable(Backend backend)
+{
+#ifdef HAVE_LIBDEFLATE
+    Q_UNUSED(backend)
+    return true;
+#else
+    return backend == Backend::Zlib;
+#endif
+}
+
+Backend backend()
+{
+    auto value = g_backend.load(std::memory_order_relaxed);
+    if (value < 0) {
+        QSettings settings("OMERewriter", "OMERewriter");
+        const auto name = settings.value("performance/deflateBackend", backendName(Backend::Libdeflate)).toString();
+        const auto selected = name == backendName(Backend::Zlib) ? Backend::Zlib : Backend::Libdeflate;
+        setBackend(selected);
+        value = g_backend.load(std::memory_order_relaxed);
+    }
+
+    return static_cast<Backend>(value);
+}
+
+void setBackend(Backend backend)
+{
+    if (!isAvailable(backend))
+        backend = Backend::Zlib;
+    g_backend.store(static_cast<int>(backend), std::memory_order_relaxed);
+}
+
+QString backendName(Backend backend)
+{
+    switch (backend) {
+    case Backend::Zlib:
+        return QStringLiteral("zlib");
+    case Backend::Libdeflate:
+        return QStringLiteral("libdeflate");
+    }
+
+    return {};
+}
+
+size_t compressBound(size_t size)
+{
+    auto bound = static_cast<size_t>(::compressBound(static_cast<uLong>(size)));
+#ifdef HAVE_LIBDEFLATE
+    bound = std::max(bound, libdeflate_zlib_compress_bound(threadCompressor(6), size));
+#endif
+    return bound;
+}
+
+size_t compress(const void *src, size_t srcSize, void *dst, size_t dstCapacity, int level)
+{
+    level = std::clamp(level, 1, 9);
+#ifdef HAVE_LIBDEFLATE
+    if (backend() == Backend::Libdeflate) {
+        auto compressor = threadCompressor(level);
+        return compressor ? libdeflate_zlib_compress(compressor, src, srcSize, dst, dstCapacity) : 0;
+    }
+#endif
+
+    auto size = static_cast<uLongf>(dstCapacity);
+    const auto r = compress2(
+        static_cast<Bytef *>(dst), &size, static_cast<const Bytef *>(src), static_cast<uLong>(srcSize), level);
+    return r == Z_OK ? static_cast<size_t>(size) : 0;
+}
+
+bool decompress(const void *src, size_t srcSize, void *dst, size_t dstSize)
+{
+#ifdef HAVE_LIBDEFLATE
+    if (backend() == Backend::Libdeflate) {
+        auto decompressor = threadDecompressor();
+        // without a pointer for the actual size, libdeflate insists on filling the buffer exactly
+        return decompressor
+               && libdeflate_zlib_decompress(decompressor, src, srcSize, dst, dstSize, nullptr) == LIBDEFLATE_SUCCESS;
+    }
+#endif
+
+    auto size = static_cast<uLongf>(dstSize);
+    const auto r = uncompress(
+        static_cast<Bytef *>(dst), &size, static_cast<const Bytef *>(src), static_cast<uLong>(srcSize));
+    return r == Z_OK && size == dstSize;
+}
+
+} // namespace DeflateCodec
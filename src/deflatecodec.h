@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <QString>
+#include <cstddef>
+
+/**
+ * @brief Whole-buffer compression & decompression of zlib streams, as used by TIFF and HDF5.
+ *
+ * libdeflate works on complete buffers and is several times faster than zlib's streaming
+ * interface, while producing and accepting exactly the same format. It is used if OMERewriter
+ * was built with it, unless zlib is selected with the "performance/deflateBackend" setting.
+ *
+ * All functions can be called from any thread.
+ */
+namespace DeflateCodec
+{
+
+enum class Backend {
+    Zlib,
+    Libdeflate
+};
+
+/**
+ * @brief Check whether this build includes the given implementation.
+ */
+[[nodiscard]] bool isAvailable(Backend backend);
+
+/**
+ * @brief Get the implementation in use.
+ */
+[[nodiscard]] Backend backend();
+
+/**
+ * @brief Select the implementation to use, falling back to zlib if it is not available.
+ */
+void setBackend(Backend backend);
+
+[[nodiscard]] QString backendName(Backend backend);
+
+/**
+ * @brief Get the largest possible size of @p size bytes after compression.
+ */
+[[nodiscard]] size_t compressBound(size_t size);
+
+/**
+ * @brief Compress a buffer into a zlib stream.
+ * @param level Compression level, from 1 (fastest) to 9 (smallest).
+ * @return Size of the compressed data, or 0 if it did not fit into @p dstCapacity bytes.
+ */
+size_t compress(const void *src, size_t srcSize, void *dst, size_t dstCapacity, int level);
+
+/**
+ * @brief Decompress a zlib stream whose decompressed size is known.
+ * @return false if the data is corrupt or does not decompress to exactly @p dstSize bytes.
+ */
+bool decompress(const void *src, size_t srcSize, void *dst, size_t dstSize);
+
+} // namespace DeflateCodec
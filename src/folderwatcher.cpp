@@ -0,0 +1,270 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include "folderwatcher.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QSocketNotifier>
+
+#ifdef Q_OS_LINUX
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+#include "ometiffimage.h"
+
+// Interval in which the sizes of unfinished files are checked, in msec
+static constexpr int CheckIntervalMs = 1000;
+
+// Without close notifications, we need to be more careful before assuming a file is complete
+static constexpr qint64 FallbackStableFactor = 3;
+
+FolderWatcher::FolderWatcher(QObject *parent)
+    : QObject(parent),
+      m_nameFilters({QStringLiteral("*.tif"), QStringLiteral("*.tiff")}),
+      m_stableTimeMs(5000)
+{
+#ifdef Q_OS_LINUX
+    m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotifyFd >= 0) {
+        m_inotifyNotifier = new QSocketNotifier(m_inotifyFd, QSocketNotifier::Read, this);
+        connect(m_inotifyNotifier, &QSocketNotifier::activated, this, &FolderWatcher::readInotifyEvents);
+    } else {
+        qWarning().noquote() << "Failed to initialize inotify, falling back to polling:" << std::strerror(errno);
+    }
+#endif
+
+    if (m_inotifyFd < 0) {
+        m_fsWatcher = new QFileSystemWatcher(this);
+        connect(m_fsWatcher, &QFileSystemWatcher::directoryChanged, this, [this](const QString &dirPath) {
+            scanDirectory(dirPath, false);
+        });
+    }
+
+    m_checkTimer.setInterval(CheckIntervalMs);
+    connect(&m_checkTimer, &QTimer::timeout, this, &FolderWatcher::checkCandidates);
+}
+
+FolderWatcher::~FolderWatcher()
+{
+#ifdef Q_OS_LINUX
+    if (m_inotifyFd >= 0)
+        ::close(m_inotifyFd);
+#endif
+}
+
+bool FolderWatcher::addDirectory(const QString &dirPath)
+{
+    const auto dir = QDir::cleanPath(QFileInfo(dirPath).absoluteFilePath());
+    if (!QFileInfo(dir).isDir()) {
+        qWarning().noquote() << "Can not watch" << dir << "- not a directory";
+        return false;
+    }
+    if (m_directories.contains(dir))
+        return true;
+
+    // watch everything below the directory first, so no file created while we scan is missed
+    QStringList subdirs = {dir};
+    QDirIterator it(dir, QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext())
+        subdirs.append(it.next());
+
+    for (const auto &subdir : subdirs) {
+#ifdef Q_OS_LINUX
+        if (m_inotifyFd >= 0) {
+            if (!addInotifyWatch(subdir) && subdir == dir)
+                return false;
+            continue;
+        }
+#endif
+        m_fsWatcher->addPath(subdir);
+    }
+
+    m_directories.append(dir);
+    if (m_reportExisting)
+        scanDirectory(dir, true);
+
+    m_checkTimer.start();
+    return true;
+}
+
+QStringList FolderWatcher::directories() const
+{
+    return m_directories;
+}
+
+void FolderWatcher::setNameFilters(const QStringList &filters)
+{
+    m_nameFilters = filters;
+}
+
+void FolderWatcher::setStableTime(qint64 msecs)
+{
+    m_stableTimeMs = msecs;
+}
+
+void FolderWatcher::setReportExisting(bool report)
+{
+    m_reportExisting = report;
+}
+
+bool FolderWatcher::usesInotify() const
+{
+    return m_inotifyFd >= 0;
+}
+
+bool FolderWatcher::isCandidateFile(const QString &path) const
+{
+    if (m_reported.contains(path) || path.contains(QStringLiteral("/_temp-omewrite")))
+        return false;
+    if (OMETiffImage::hasOmeTiffExtension(path))
+        return false;
+    if (!QDir::match(m_nameFilters, QFileInfo(path).fileName()))
+        return false;
+
+    // files that were converted before are left alone
+    const QFileInfo fi(path);
+    return !QFileInfo::exists(fi.absoluteDir().absoluteFilePath(fi.completeBaseName() + ".ome.tiff"));
+}
+
+void FolderWatcher::addCandidate(const QString &path, bool closed)
+{
+    if (!isCandidateFile(path))
+        return;
+
+    auto &candidate = m_candidates[path];
+    candidate.closed = candidate.closed || closed;
+    candidate.size = -1;
+    candidate.stableTimer.start();
+}
+
+void FolderWatcher::scanDirectory(const QString &dirPath, bool recursive)
+{
+    QDirIterator it(
+        dirPath,
+        m_nameFilters,
+        QDir::Files | QDir::Readable,
+        recursive ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags);
+    while (it.hasNext()) {
+        const auto path = it.next();
+        if (!m_candidates.contains(path))
+            addCandidate(path, true);
+    }
+
+    if (m_fsWatcher && !recursive) {
+        // new subdirectories need to be watched too
+        QDirIterator dirIt(dirPath, QDir::Dirs | QDir::NoDotAndDotDot);
+        while (dirIt.hasNext()) {
+            const auto subdir = dirIt.next();
+            if (!m_fsWatcher->directories().contains(subdir)) {
+                m_fsWatcher->addPath(subdir);
+                scanDirectory(subdir, true);
+            }
+        }
+    }
+}
+
+void FolderWatcher::checkCandidates()
+{
+    const auto stableTimeMs = usesInotify() ? m_stableTimeMs : m_stableTimeMs * FallbackStableFactor;
+
+    QStringList ready;
+    for (auto it = m_candidates.begin(); it != m_candidates.end();) {
+        const QFileInfo fi(it.key());
+        if (!fi.exists()) {
+            it = m_candidates.erase(it);
+            continue;
+        }
+
+        auto &candidate = it.value();
+        if (fi.size() != candidate.size) {
+            candidate.size = fi.size();
+            candidate.stableTimer.restart();
+        } else if (candidate.closed && candidate.size > 0 && candidate.stableTimer.elapsed() >= stableTimeMs) {
+            ready.append(it.key());
+            it = m_candidates.erase(it);
+            continue;
+        }
+        ++it;
+    }
+
+    for (const auto &path : ready) {
+        m_reported.insert(path);
+        qDebug().noquote() << "Acquisition complete:" << path;
+        emit fileReady(path);
+    }
+}
+
+#ifdef Q_OS_LINUX
+bool FolderWatcher::addInotifyWatch(const QString &dirPath)
+{
+    const auto wd = inotify_add_watch(
+        m_inotifyFd,
+        QFile::encodeName(dirPath).constData(),
+        IN_CREATE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE_SELF | IN_ONLYDIR);
+    if (wd < 0) {
+        qWarning().noquote() << "Failed to watch" << dirPath << "-" << std::strerror(errno);
+        return false;
+    }
+
+    m_watchDirs.insert(wd, dirPath);
+    return true;
+}
+
+void FolderWatcher::readInotifyEvents()
+{
+    alignas(inotify_event) char buffer[16 * 1024];
+    while (true) {
+        const auto len = ::read(m_inotifyFd, buffer, sizeof(buffer));
+        if (len <= 0)
+            break;
+
+        for (char *ptr = buffer; ptr < buffer + len;) {
+            const auto event = reinterpret_cast<const inotify_event *>(ptr);
+            ptr += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_IGNORED) {
+                m_watchDirs.remove(event->wd);
+                continue;
+            }
+            if (event->len == 0)
+                continue;
+
+            const auto dirPath = m_watchDirs.value(event->wd);
+            if (dirPath.isEmpty())
+                continue;
+            const auto path = dirPath + QLatin1Char('/') + QFile::decodeName(event->name);
+
+            if (event->mask & IN_ISDIR) {
+                // acquisitions often go to a new directory per session
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    addInotifyWatch(path);
+                    scanDirectory(path, true);
+                }
+                continue;
+            }
+
+            if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                addCandidate(path, true);
+            } else if (event->mask & (IN_CREATE | IN_MODIFY)) {
+                // still being written, restart the stability check once it is closed again
+                auto it = m_candidates.find(path);
+                if (it != m_candidates.end())
+                    it->closed = false;
+                else
+                    addCandidate(path, false);
+            }
+        }
+    }
+}
+#endif
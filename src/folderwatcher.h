@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+
+class QFileSystemWatcher;
+class QSocketNotifier;
+
+/**
+ * @brief Reports image files in a set of directories once they have been completely written.
+ *
+ * On Linux, inotify tells us when a writer has closed a file. A file is only reported once
+ * it was closed and its size did not change for a while, so acquisitions that reopen their
+ * output do not get picked up half-way. On other platforms, directories are watched with
+ * QFileSystemWatcher and only the size is used to decide whether a file is complete.
+ */
+class FolderWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FolderWatcher(QObject *parent = nullptr);
+    ~FolderWatcher() override;
+
+    /**
+     * @brief Start watching a directory and all of its subdirectories.
+     * @return false if the directory could not be watched.
+     */
+    bool addDirectory(const QString &dirPath);
+    [[nodiscard]] QStringList directories() const;
+
+    /**
+     * @brief File name patterns of files to report, like "*.tif".
+     */
+    void setNameFilters(const QStringList &filters);
+
+    /**
+     * @brief Time the size of a closed file must stay the same before it is reported.
+     */
+    void setStableTime(qint64 msecs);
+
+    /**
+     * @brief Also report files that already existed when their directory was added.
+     */
+    void setReportExisting(bool report);
+
+    /**
+     * @brief Whether the watcher is notified about closed files, rather than only relying on file sizes.
+     */
+    [[nodiscard]] bool usesInotify() const;
+
+signals:
+    /**
+     * @brief Emitted once for every file that has been written completely.
+     */
+    void fileReady(const QString &path);
+
+private:
+    struct Candidate {
+        qint64 size = -1;
+        bool closed = false;
+        QElapsedTimer stableTimer;
+    };
+
+    bool isCandidateFile(const QString &path) const;
+    void addCandidate(const QString &path, bool closed);
+    void scanDirectory(const QString &dirPath, bool recursive);
+    void checkCandidates();
+#ifdef Q_OS_LINUX
+    bool addInotifyWatch(const QString &dirPath);
+    void readInotifyEvents();
+#endif
+
+    QStringList m_directories;
+    QStringList m_nameFilters;
+    qint64 m_stableTimeMs;
+    bool m_reportExisting = true;
+
+    QHash<QString, Candidate> m_candidates;
+    QSet<QString> m_reported;
+    QTimer m_checkTimer;
+
+    int m_inotifyFd = -1;
+    QSocketNotifier *m_inotifyNotifier = nullptr;
+    QHash<int, QString> m_watchDirs;
+    QFileSystemWatcher *m_fsWatcher = nullptr;
+};
@@ -0,0 +1,528 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include "hdf5exporter.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QList>
+#include <QSettings>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <vector>
+
+#include <ome/files/VariantPixelBuffer.h>
+
+#include "config.h"
+#include "deflatecodec.h"
+#include "perftrace.h"
+
+#ifdef HAVE_HDF5
+#include <hdf5.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+using ome::files::VariantPixelBuffer;
+typedef ome::xml::model::enums::PixelType PT;
+
+#ifdef HAVE_HDF5
+namespace
+{
+
+// ID of the Zstandard filter in the HDF5 filter registry
+constexpr H5Z_filter_t ZstdFilterId = 32015;
+
+/**
+ * Closes an HDF5 object when it goes out of scope.
+ */
+class H5Object
+{
+public:
+    H5Object(hid_t id, herr_t (*closeFn)(hid_t))
+        : m_id(id),
+          m_close(closeFn)
+    {
+    }
+    ~H5Object()
+    {
+        if (m_id >= 0)
+            m_close(m_id);
+    }
+    H5Object(const H5Object &) = delete;
+    H5Object &operator=(const H5Object &) = delete;
+
+    [[nodiscard]] bool isValid() const
+    {
+        return m_id >= 0;
+    }
+    herr_t close()
+    {
+        const auto r = m_id >= 0 ? m_close(m_id) : 0;
+        m_id = H5I_INVALID_HID;
+        return r;
+    }
+    operator hid_t() const
+    {
+        return m_id;
+    }
+
+private:
+    hid_t m_id;
+    herr_t (*m_close)(hid_t);
+};
+
+/**
+ * A chunk of the output dataset, at its position in units of samples.
+ */
+struct ChunkTile {
+    hsize_t y = 0;
+    hsize_t x = 0;
+};
+
+hid_t nativeType(PT pixelType)
+{
+    switch (pixelType) {
+    case PT::INT8:
+        return H5T_NATIVE_INT8;
+    case PT::UINT8:
+    case PT::BIT:
+        return H5T_NATIVE_UINT8;
+    case PT::INT16:
+        return H5T_NATIVE_INT16;
+    case PT::UINT16:
+        return H5T_NATIVE_UINT16;
+    case PT::INT32:
+        return H5T_NATIVE_INT32;
+    case PT::UINT32:
+        return H5T_NATIVE_UINT32;
+    case PT::FLOAT:
+        return H5T_NATIVE_FLOAT;
+    case PT::DOUBLE:
+        return H5T_NATIVE_DOUBLE;
+    default:
+        return H5I_INVALID_HID;
+    }
+}
+
+bool writeAttribute(hid_t object, const char *name, const std::string &value)
+{
+    H5Object type(H5Tcopy(H5T_C_S1), H5Tclose);
+    H5Tset_size(type, std::max<size_t>(value.size(), 1));
+    H5Tset_cset(type, H5T_CSET_UTF8);
+    H5Object space(H5Screate(H5S_SCALAR), H5Sclose);
+    H5Object attr(H5Acreate2(object, name, type, space, H5P_DEFAULT, H5P_DEFAULT), H5Aclose);
+    return attr.isValid() && H5Awrite(attr, type, value.c_str()) >= 0;
+}
+
+bool writeAttribute(hid_t object, const char *name, const QString &value)
+{
+    return writeAttribute(object, name, value.toStdString());
+}
+
+bool writeAttribute(hid_t object, const char *name, double value)
+{
+    H5Object space(H5Screate(H5S_SCALAR), H5Sclose);
+    H5Object attr(H5Acreate2(object, name, H5T_NATIVE_DOUBLE, space, H5P_DEFAULT, H5P_DEFAULT), H5Aclose);
+    return attr.isValid() && H5Awrite(attr, H5T_NATIVE_DOUBLE, &value) >= 0;
+}
+
+} // namespace
+#endif
+
+// Every block is written contiguously and read with a fixed stride, which the compiler
+// turns into SIMD byte shuffles when the element size is known at compile time.
+template<size_t ElementSize>
+static void shuffleBytesOf(const unsigned char *__restrict src, unsigned char *__restrict dst, size_t count)
+{
+    for (size_t k = 0; k < ElementSize; ++k) {
+        auto *__restrict block = dst + k * count;
+        for (size_t i = 0; i < count; ++i)
+            block[i] = src[i * ElementSize + k];
+    }
+}
+
+/**
+ * Apply the HDF5 shuffle filter: byte k of every sample is stored in the k-th block.
+ */
+static void shuffleBytes(const unsigned char *src, unsigned char *dst, size_t bytes, size_t elementSize)
+{
+    const auto count = bytes / elementSize;
+    switch (elementSize) {
+    case 2:
+        shuffleBytesOf<2>(src, dst, count);
+        break;
+    case 4:
+        shuffleBytesOf<4>(src, dst, count);
+        break;
+    case 8:
+        shuffleBytesOf<8>(src, dst, count);
+        break;
+    default:
+        for (size_t k = 0; k < elementSize; ++k) {
+            for (size_t i = 0; i < count; ++i)
+                dst[k * count + i] = src[i * elementSize + k];
+        }
+    }
+}
+
+static std::optional<Hdf5ExportOptions::Compression> compressionFromName(const QString &name)
+{
+    if (name == QStringLiteral("deflate"))
+        return Hdf5ExportOptions::Compression::Deflate;
+    if (name == QStringLiteral("zstd"))
+        return Hdf5ExportOptions::Compression::Zstd;
+    if (name == QStringLiteral("none"))
+        return Hdf5ExportOptions::Compression::None;
+    return std::nullopt;
+}
+
+bool Hdf5ExportOptions::isCompressionAvailable(Compression compression)
+{
+#ifdef HAVE_ZSTD
+    Q_UNUSED(compression)
+    return true;
+#else
+    return compression != Compression::Zstd;
+#endif
+}
+
+int Hdf5ExportOptions::maxLevel(Compression compression)
+{
+    return compression == Compression::Zstd ? 22 : 9;
+}
+
+std::vector<unsigned char> Hdf5ExportOptions::encode(std::vector<unsigned char> data, size_t elementSize) const
+{
+    if (shuffle && elementSize > 1) {
+        std::vector<unsigned char> shuffled(data.size());
+        shuffleBytes(data.data(), shuffled.data(), data.size(), elementSize);
+        data.swap(shuffled);
+    }
+
+    if (compression == Compression::Zstd) {
+#ifdef HAVE_ZSTD
+        std::vector<unsigned char> compressed(ZSTD_compressBound(data.size()));
+        const auto size = ZSTD_compress(compressed.data(), compressed.size(), data.data(), data.size(), level);
+        compressed.resize(ZSTD_isError(size) ? 0 : size);
+        return compressed;
+#else
+        return {};
+#endif
+    }
+    if (compression == Compression::None)
+        return data;
+
+    std::vector<unsigned char> compressed(DeflateCodec::compressBound(data.size()));
+    compressed.resize(DeflateCodec::compress(data.data(), data.size(), compressed.data(), compressed.size(), level));
+    return compressed;
+}
+
+Hdf5ExportOptions Hdf5ExportOptions::fromSettings()
+{
+    QSettings settings("OMERewriter", "OMERewriter");
+    Hdf5ExportOptions options;
+    options.chunkFrames = std::max(settings.value("hdf5/chunkFrames", options.chunkFrames).toInt(), 1);
+    options.chunkY = std::max(settings.value("hdf5/chunkY", options.chunkY).toInt(), 1);
+    options.chunkX = std::max(settings.value("hdf5/chunkX", options.chunkX).toInt(), 1);
+    const auto compression = compressionFromName(settings.value("hdf5/compression", "deflate").toString());
+    if (compression && isCompressionAvailable(compression.value()))
+        options.compression = compression.value();
+    options.level = std::clamp(settings.value("hdf5/level", options.level).toInt(), 1, maxLevel(options.compression));
+    options.shuffle = settings.value("hdf5/shuffle", options.shuffle).toBool();
+    return options;
+}
+
+std::expected<Hdf5ExportOptions, QString> Hdf5ExportOptions::fromJson(
+    const QJsonObject &json,
+    const Hdf5ExportOptions &defaults)
+{
+    auto options = defaults;
+    if (json.contains(QStringLiteral("chunkShape"))) {
+        const auto shape = json.value(QStringLiteral("chunkShape")).toArray();
+        bool valid = shape.size() == 3;
+        for (const auto &v : shape)
+            valid = valid && v.toInt() >= 1;
+        if (!valid)
+            return std::unexpected(QStringLiteral("chunkShape must be three positive integers: [frames, y, x]"));
+        options.chunkFrames = shape.at(0).toInt();
+        options.chunkY = shape.at(1).toInt();
+        options.chunkX = shape.at(2).toInt();
+    }
+
+    if (json.contains(QStringLiteral("compression"))) {
+        const auto name = json.value(QStringLiteral("compression")).toString();
+        const auto compression = compressionFromName(name);
+        if (!compression)
+            return std::unexpected(QStringLiteral("Unknown HDF5 compression: %1").arg(name));
+        if (!isCompressionAvailable(compression.value()))
+            return std::unexpected(QStringLiteral("HDF5 compression %1 is not supported by this build").arg(name));
+        options.compression = compression.value();
+    }
+
+    if (json.contains(QStringLiteral("level"))) {
+        options.level = json.value(QStringLiteral("level")).toInt();
+        if (options.level < 1 || options.level > maxLevel(options.compression))
+            return std::unexpected(QStringLiteral("The compression level must be between 1 and %1")
+                                       .arg(maxLevel(options.compression)));
+    } else {
+        options.level = std::min(options.level, maxLevel(options.compression));
+    }
+    options.shuffle = json.value(QStringLiteral("shuffle")).toBool(options.shuffle);
+
+    return options;
+}
+
+Hdf5Exporter::Hdf5Exporter(OMETiffImage &image, const Hdf5ExportOptions &options)
+    : m_image(image),
+      m_options(options)
+{
+}
+
+bool Hdf5Exporter::isAvailable()
+{
+#ifdef HAVE_HDF5
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool Hdf5Exporter::hasHdf5Extension(const QString &filename)
+{
+    const auto suffix = QFileInfo(filename).suffix().toLower();
+    return suffix == QStringLiteral("nwb") || suffix == QStringLiteral("h5") || suffix == QStringLiteral("hdf5");
+}
+
+#ifndef HAVE_HDF5
+std::expected<bool, QString> Hdf5Exporter::write(
+    const QString &,
+    const ImageMetadata &,
+    OMETiffImage::ProgressCallback,
+    SaveStatistics *)
+{
+    return std::unexpected(QStringLiteral("This build of OMERewriter can not write HDF5 files"));
+}
+#else
+
+std::expected<bool, QString> Hdf5Exporter::write(
+    const QString &outputPath,
+    const ImageMetadata &metadata,
+    OMETiffImage::ProgressCallback progressCallback,
+    SaveStatistics *stats)
+{
+    if (!m_image.isOpen())
+        return std::unexpected(QStringLiteral("No image data loaded"));
+    if (m_image.frameBinning() > 1)
+        return std::unexpected(QStringLiteral("Frames can not be combined when writing HDF5 files"));
+    if (m_image.pixelConversion() != PixelConversion::None)
+        return std::unexpected(QStringLiteral("The pixel type can not be converted when writing HDF5 files"));
+
+    PERF_TRACE_SCOPE("Hdf5Exporter::write", "save");
+
+    SaveStatistics localStats;
+    auto &st = stats ? *stats : localStats;
+    st = {};
+
+    QElapsedTimer totalTimer;
+    QElapsedTimer stageTimer;
+    totalTimer.start();
+    const auto msecsSince = [](const QElapsedTimer &timer) {
+        return timer.nsecsElapsed() / 1000000.0;
+    };
+
+    const auto pixelType = m_image.pixelType();
+    const auto type = nativeType(pixelType);
+    if (type == H5I_INVALID_HID)
+        return std::unexpected(QStringLiteral("Pixel type %1 can not be written to HDF5")
+                                   .arg(QString::fromStdString(std::string(pixelType))));
+
+    const auto sizeX = static_cast<hsize_t>(m_image.sizeX());
+    const auto sizeY = static_cast<hsize_t>(m_image.sizeY());
+    const auto sizeZ = static_cast<hsize_t>(m_image.sizeZ());
+    const auto sizeC = static_cast<hsize_t>(m_image.sizeC());
+    const auto sizeT = static_cast<hsize_t>(m_image.sizeT());
+    const auto elementSize = H5Tget_size(type);
+    const auto planeBytes = sizeX * sizeY * elementSize;
+
+    const auto chunkT = std::min<hsize_t>(m_options.chunkFrames, sizeT);
+    const auto chunkY = std::min<hsize_t>(m_options.chunkY, sizeY);
+    const auto chunkX = std::min<hsize_t>(m_options.chunkX, sizeX);
+    const auto chunkBytes = chunkT * chunkY * chunkX * elementSize;
+    const bool deflate = m_options.compression == Hdf5ExportOptions::Compression::Deflate;
+    const bool zstd = m_options.compression == Hdf5ExportOptions::Compression::Zstd;
+    const bool shuffle = m_options.shuffle && elementSize > 1;
+    if (!Hdf5ExportOptions::isCompressionAvailable(m_options.compression))
+        return std::unexpected(QStringLiteral("This build of OMERewriter can not compress HDF5 data with Zstandard"));
+
+    QStringList filterNames;
+    if (shuffle)
+        filterNames.append(QStringLiteral("shuffle"));
+    if (deflate)
+        filterNames.append(QStringLiteral("deflate"));
+    if (zstd)
+        filterNames.append(QStringLiteral("zstd"));
+
+    // volumes get a Z axis, plain time series are stored like every other NWB image series
+    const int rank = sizeZ > 1 ? 4 : 3;
+    const std::vector<hsize_t> dims = rank == 4 ? std::vector{sizeT, sizeZ, sizeY, sizeX}
+                                                : std::vector{sizeT, sizeY, sizeX};
+    const std::vector<hsize_t> chunkDims = rank == 4 ? std::vector<hsize_t>{chunkT, 1, chunkY, chunkX}
+                                                     : std::vector<hsize_t>{chunkT, chunkY, chunkX};
+
+    std::vector<ChunkTile> tiles;
+    for (hsize_t y = 0; y < sizeY; y += chunkY) {
+        for (hsize_t x = 0; x < sizeX; x += chunkX)
+            tiles.push_back({y, x});
+    }
+
+    stageTimer.start();
+    H5Object file(H5Fcreate(outputPath.toUtf8().constData(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT), H5Fclose);
+    if (!file.isValid())
+        return std::unexpected(QStringLiteral("Failed to create HDF5 file %1").arg(outputPath));
+    H5Object acquisition(H5Gcreate2(file, "acquisition", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT), H5Gclose);
+
+    H5Object dcpl(H5Pcreate(H5P_DATASET_CREATE), H5Pclose);
+    H5Pset_chunk(dcpl, rank, chunkDims.data());
+    if (shuffle)
+        H5Pset_shuffle(dcpl);
+    if (deflate)
+        H5Pset_deflate(dcpl, m_options.level);
+    if (zstd) {
+        // the filter is a plugin, we only announce it here and compress the chunks ourselves
+        const auto level = static_cast<unsigned int>(m_options.level);
+        if (H5Pset_filter(dcpl, ZstdFilterId, H5Z_FLAG_OPTIONAL, 1, &level) < 0)
+            return std::unexpected(QStringLiteral("Failed to set up Zstandard compression for %1").arg(outputPath));
+    }
+    H5Object space(H5Screate_simple(rank, dims.data(), nullptr), H5Sclose);
+    st.setupMs = msecsSince(stageTimer);
+
+    // Fills a chunk from a block of planes and runs it through the filters we announced
+    std::vector<unsigned char> block(chunkT * planeBytes);
+    const auto encodeChunk = [&](const ChunkTile &tile) {
+        std::vector<unsigned char> raw(chunkBytes, 0);
+        const auto rows = std::min(chunkY, sizeY - tile.y);
+        const auto rowBytes = std::min(chunkX, sizeX - tile.x) * elementSize;
+        for (hsize_t f = 0; f < chunkT; ++f) {
+            for (hsize_t row = 0; row < rows; ++row) {
+                const auto src = block.data() + f * planeBytes + ((tile.y + row) * sizeX + tile.x) * elementSize;
+                std::memcpy(raw.data() + (f * chunkY + row) * chunkX * elementSize, src, rowBytes);
+            }
+        }
+
+        return m_options.encode(std::move(raw), elementSize);
+    };
+
+    const auto totalPlanes = static_cast<OMETiffImage::dimension_size_type>(sizeC * sizeZ * sizeT);
+    OMETiffImage::dimension_size_type planesDone = 0;
+    for (hsize_t c = 0; c < sizeC; ++c) {
+        const auto channel = c < metadata.channels.size() ? metadata.channels[c] : ChannelParams();
+        auto seriesName = channel.name.isEmpty() ? QStringLiteral("ImageSeries") : channel.name;
+        if (sizeC > 1 && channel.name.isEmpty())
+            seriesName += QStringLiteral("_ch%1").arg(c);
+        seriesName.replace(QLatin1Char('/'), QLatin1Char('_'));
+
+        H5Object group(
+            H5Gcreate2(acquisition, seriesName.toUtf8().constData(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT),
+            H5Gclose);
+        if (!group.isValid())
+            return std::unexpected(QStringLiteral("Failed to create group for channel %1").arg(c));
+
+        writeAttribute(group, "neurodata_type", std::string("ImageSeries"));
+        writeAttribute(group, "namespace", std::string("core"));
+        writeAttribute(group, "description", metadata.imageName);
+        writeAttribute(group, "physical_size_x_nm", metadata.physSizeXNm);
+        writeAttribute(group, "physical_size_y_nm", metadata.physSizeYNm);
+        writeAttribute(group, "physical_size_z_nm", metadata.physSizeZNm);
+        writeAttribute(group, "numerical_aperture", metadata.numericalAperture);
+        writeAttribute(group, "immersion", std::string(metadata.lensImmersion));
+        writeAttribute(group, "embedding_medium", std::string(metadata.embeddingMedium));
+        writeAttribute(group, "immersion_refractive_index", metadata.immersionRI);
+        writeAttribute(group, "channel_name", channel.name);
+        writeAttribute(group, "acquisition_mode", std::string(channel.acquisitionMode));
+        writeAttribute(group, "excitation_wavelength_nm", channel.exWavelengthNm);
+        writeAttribute(group, "emission_wavelength_nm", channel.emWavelengthNm);
+        writeAttribute(group, "pinhole_size_nm", channel.pinholeSizeNm);
+        writeAttribute(group, "photon_count", static_cast<double>(channel.photonCount));
+
+        H5Object dataset(H5Dcreate2(group, "data", type, space, H5P_DEFAULT, dcpl, H5P_DEFAULT), H5Dclose);
+        if (!dataset.isValid())
+            return std::unexpected(QStringLiteral("Failed to create dataset for channel %1").arg(c));
+        writeAttribute(dataset, "unit", std::string("n.a."));
+        writeAttribute(dataset, "conversion", 1.0);
+        writeAttribute(dataset, "resolution", -1.0);
+        writeAttribute(dataset, "offset", 0.0);
+        writeAttribute(dataset, "dimensions", std::string(rank == 4 ? "t,z,y,x" : "t,y,x"));
+
+        for (hsize_t z = 0; z < sizeZ; ++z) {
+            for (hsize_t t0 = 0; t0 < sizeT; t0 += chunkT) {
+                if (progressCallback && !progressCallback(planesDone, totalPlanes))
+                    return std::unexpected(QStringLiteral("Save operation cancelled by user"));
+
+                // the last block of a dataset is padded with zeros, like HDF5 does for partial chunks
+                const auto frames = std::min(chunkT, sizeT - t0);
+                if (frames < chunkT)
+                    std::fill(block.begin() + static_cast<qsizetype>(frames * planeBytes), block.end(), 0);
+
+                for (hsize_t f = 0; f < frames; ++f) {
+                    PerfTrace::Span span("readPlane", "save");
+                    stageTimer.start();
+                    VariantPixelBuffer buf;
+                    const auto r = m_image.readPlaneData(z, c, t0 + f, buf);
+                    if (!r)
+                        return std::unexpected(r.error());
+                    std::visit(
+                        [&](const auto &pixels) {
+                            if (pixels)
+                                std::memcpy(block.data() + f * planeBytes, pixels->data(), planeBytes);
+                        },
+                        buf.vbuffer());
+                    st.readMs += msecsSince(stageTimer);
+                    st.bytesIn += planeBytes;
+                    st.planes++;
+                    planesDone++;
+                }
+
+                PerfTrace::Span span("writeChunks", "save");
+                stageTimer.start();
+                const auto encoded = QtConcurrent::blockingMapped<QList<std::vector<unsigned char>>>(
+                    tiles, encodeChunk);
+                for (size_t i = 0; i < tiles.size(); ++i) {
+                    const std::vector<hsize_t> offset = rank == 4
+                                                            ? std::vector{t0, z, tiles[i].y, tiles[i].x}
+                                                            : std::vector{t0, tiles[i].y, tiles[i].x};
+                    const auto &chunk = encoded.at(static_cast<qsizetype>(i));
+                    if (chunk.empty())
+                        return std::unexpected(QStringLiteral("Failed to compress chunk of %1").arg(outputPath));
+                    if (H5Dwrite_chunk(dataset, H5P_DEFAULT, 0, offset.data(), chunk.size(), chunk.data()) < 0)
+                        return std::unexpected(QStringLiteral("Failed to write chunk to %1").arg(outputPath));
+                }
+                st.writeMs += msecsSince(stageTimer);
+            }
+        }
+    }
+
+    stageTimer.start();
+    space.close();
+    dcpl.close();
+    acquisition.close();
+    if (file.close() < 0)
+        return std::unexpected(QStringLiteral("Failed to write %1").arg(outputPath));
+    st.finalizeMs = msecsSince(stageTimer);
+
+    st.bytesOut = static_cast<quint64>(QFileInfo(outputPath).size());
+    st.totalMs = msecsSince(totalTimer);
+    st.codec = filterNames.isEmpty() ? QStringLiteral("none") : filterNames.join(QLatin1Char('+'));
+
+    qDebug() << "Successfully exported HDF5 image to:" << outputPath;
+    return true;
+}
+#endif
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <QJsonObject>
+#include <QString>
+#include <expected>
+#include <vector>
+
+#include "ometiffimage.h"
+
+/**
+ * @brief Chunking and compression of HDF5 image datasets.
+ */
+struct Hdf5ExportOptions {
+    enum class Compression {
+        None,
+        Deflate,
+        Zstd /// Registered HDF5 filter 32015, readable with the hdf5plugin package or h5py's plugins
+    };
+
+    int chunkFrames = 16; /// Time points per chunk
+    int chunkY = 256;
+    int chunkX = 256;
+    Compression compression = Compression::Deflate;
+    int level = 4;        /// Deflate level 1 (fastest) to 9 (smallest), or Zstd level 1 to 22
+    bool shuffle = true;  /// Group the bytes of all samples by significance before compressing
+
+    /**
+     * @brief Check whether this build can compress chunks with the given method.
+     */
+    static bool isCompressionAvailable(Compression compression);
+
+    /**
+     * @brief Get the highest level of the given compression method.
+     */
+    static int maxLevel(Compression compression);
+
+    /**
+     * @brief Run a chunk through the shuffle and compression filters of these options.
+     * @param elementSize Size of one sample in bytes, for the shuffle filter.
+     * @return The filtered chunk, or an empty vector if compressing failed.
+     */
+    [[nodiscard]] std::vector<unsigned char> encode(std::vector<unsigned char> data, size_t elementSize) const;
+
+    /**
+     * @brief Read the options from the application settings.
+     */
+    static Hdf5ExportOptions fromSettings();
+
+    /**
+     * @brief Read options given as JSON, e.g. in a job request.
+     * @param json Object with "chunkShape" ([frames, y, x]), "compression" ("deflate", "zstd" or "none"),
+     *             "level" and "shuffle", all of which are optional.
+     * @param defaults Options to use for all values the object does not contain.
+     */
+    static std::expected<Hdf5ExportOptions, QString> fromJson(
+        const QJsonObject &json,
+        const Hdf5ExportOptions &defaults);
+};
+
+/**
+ * @brief Writes an image to an HDF5 file laid out like an NWB ImageSeries.
+ *
+ * Every channel becomes an ImageSeries group below /acquisition, whose "data" dataset
+ * has the shape (t, y, x), or (t, z, y, x) for volumes. Optical and channel parameters
+ * are stored as attributes of the group, so the datasets can be linked into the NWB
+ * file of a session by the analysis pipeline.
+ *
+ * Chunks are compressed on all cores and written with HDF5's direct chunk write,
+ * bypassing the single-threaded filter pipeline of the HDF5 library. The result can be
+ * read by any HDF5 reader, using the standard shuffle and deflate filters. Zstandard
+ * compresses noisy 16-bit data about as well as deflate at several times the speed,
+ * but needs the Zstd filter plugin to be installed where the file is read.
+ */
+class Hdf5Exporter
+{
+public:
+    explicit Hdf5Exporter(OMETiffImage &image, const Hdf5ExportOptions &options = Hdf5ExportOptions());
+
+    /**
+     * @brief Write all planes of the image to a new HDF5 file.
+     * @param outputPath Path of the file to create, an existing file is overwritten.
+     * @param metadata Metadata to store along with the pixel data.
+     * @param progressCallback Optional callback for progress reporting (current, total) -> continue?
+     * @param stats Optional statistics to fill with stage timings and data volumes.
+     * @return true if successful, error message otherwise.
+     */
+    std::expected<bool, QString> write(
+        const QString &outputPath,
+        const ImageMetadata &metadata,
+        OMETiffImage::ProgressCallback progressCallback = nullptr,
+        SaveStatistics *stats = nullptr);
+
+    /**
+     * @brief Check whether this build can write HDF5 files.
+     */
+    static bool isAvailable();
+
+    /**
+     * @brief Check whether a file name has an extension used for HDF5 files.
+     */
+    static bool hasHdf5Extension(const QString &filename);
+
+private:
+    OMETiffImage &m_image;
+    Hdf5ExportOptions m_options;
+};
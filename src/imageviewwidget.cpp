@@ -20,13 +20,27 @@
 #include "imageviewwidget.h"
 
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QFontDatabase>
 #include <QMessageBox>
+#include <QPainter>
 #include <QOpenGLTexture>
 #include <QOpenGLShaderProgram>
 #include <QOpenGLBuffer>
 #include <QOpenGLVertexArrayObject>
+#include <algorithm>
 #include <cmath>
 #include <cstring>
+#include <optional>
+
+#include "perftrace.h"
+#include "utils.h"
+
+// Weight of the newest sample in the smoothed overlay values
+static constexpr double HudSmoothingFactor = 0.2;
+
+// Minimum time between two memory usage samples, in msec
+static constexpr qint64 HudMemorySampleIntervalMs = 500;
 
 #if defined(QT_OPENGL_ES)
 #define USE_GLES 1
@@ -165,6 +179,14 @@ public:
     int lastPixelRangeMin;
     int lastPixelRangeMax;
 
+    // Performance overlay
+    bool hudVisible = false;
+    PlaneReadStatistics readStats;
+    double frameTimeMs = 0;
+    double uploadBytesPerSec = 0;
+    size_t memoryUsage = 0;
+    QElapsedTimer memorySampleTimer;
+
     void setupTextureFormat(int channels, int bytesPerChannel)
     {
         // Set texture type based on bytes per channel
@@ -317,7 +339,16 @@ void ImageViewWidget::initializeGL()
 
 void ImageViewWidget::paintGL()
 {
+    QElapsedTimer frameTimer;
+    frameTimer.start();
+
     renderImage();
+    if (d->hudVisible)
+        drawPerformanceHud();
+
+    const double frameMs = frameTimer.nsecsElapsed() / 1000000.0;
+    d->frameTimeMs = d->frameTimeMs > 0 ? HudSmoothingFactor * frameMs + (1.0 - HudSmoothingFactor) * d->frameTimeMs
+                                        : frameMs;
 }
 
 void ImageViewWidget::renderImage()
@@ -325,6 +356,8 @@ void ImageViewWidget::renderImage()
     if (d->glImage.isEmpty())
         return;
 
+    PERF_TRACE_SCOPE("ImageViewWidget::renderImage", "gpu");
+
     const auto imgWidth = d->glImage.width;
     const auto imgHeight = d->glImage.height;
     const auto channels = d->glImage.channels;
@@ -380,6 +413,13 @@ void ImageViewWidget::renderImage()
     }
 
     // Upload texture data
+    std::optional<PerfTrace::Span> uploadSpan(std::in_place, "textureUpload", "gpu");
+    uploadSpan->setArg("bytes", static_cast<qint64>(d->glImage.dataSize()));
+    QElapsedTimer uploadTimer;
+    uploadTimer.start();
+
+    // QPainter resets this when drawing the overlay
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     if (d->pboIds[0] != 0) {
         // Check if we need immediate upload (new image data)
         if (d->imageDataChanged) {
@@ -414,6 +454,18 @@ void ImageViewWidget::renderImage()
             GL_TEXTURE_2D, 0, 0, 0, imgWidth, imgHeight, d->textureFormat, d->textureType, d->glImage.data.constData());
     }
 
+    uploadSpan.reset();
+    if (d->hudVisible) {
+        // only measures the time the driver takes to accept the data, the copy itself may happen later
+        const auto uploadNs = uploadTimer.nsecsElapsed();
+        if (uploadNs > 0) {
+            const double rate = d->glImage.dataSize() * 1.0e9 / uploadNs;
+            d->uploadBytesPerSec = d->uploadBytesPerSec > 0
+                                       ? HudSmoothingFactor * rate + (1.0 - HudSmoothingFactor) * d->uploadBytesPerSec
+                                       : rate;
+        }
+    }
+
     // Render
     glClear(GL_COLOR_BUFFER_BIT);
 
@@ -475,6 +527,69 @@ bool ImageViewWidget::showImage(const RawImage &image)
     return true;
 }
 
+void ImageViewWidget::drawPerformanceHud()
+{
+    if (!d->memorySampleTimer.isValid() || d->memorySampleTimer.elapsed() >= HudMemorySampleIntervalMs) {
+        d->memoryUsage = currentProcessMemoryUsage();
+        d->memorySampleTimer.start();
+    }
+
+    const auto &stats = d->readStats;
+    const QStringList lines = {
+        QStringLiteral("Frame: %1 ms").arg(d->frameTimeMs, 0, 'f', 2),
+        QStringLiteral("Decode: %1 ms").arg(stats.lastDecodeMs, 0, 'f', 2),
+        QStringLiteral("Convert: %1 ms").arg(stats.lastConvertMs, 0, 'f', 2),
+        QStringLiteral("Upload: %1/s").arg(formatDataSize(static_cast<size_t>(d->uploadBytesPerSec))),
+        QStringLiteral("Cache: %1% hits, %2 / %3")
+            .arg(stats.cacheHitRate() * 100.0, 0, 'f', 1)
+            .arg(formatDataSize(stats.cacheUsedBytes), formatDataSize(stats.cacheCapacityBytes)),
+        QStringLiteral("Memory: %1").arg(d->memoryUsage > 0 ? formatDataSize(d->memoryUsage) : QStringLiteral("-")),
+    };
+
+    QPainter painter(this);
+    QFont font = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+    painter.setFont(font);
+
+    const QFontMetrics fm(font);
+    int textWidth = 0;
+    for (const auto &line : lines)
+        textWidth = std::max(textWidth, fm.horizontalAdvance(line));
+
+    const int padding = 6;
+    const QRect box(8, 8, textWidth + 2 * padding, static_cast<int>(lines.size()) * fm.height() + 2 * padding);
+    painter.fillRect(box, QColor(0, 0, 0, 160));
+    painter.setPen(Qt::white);
+
+    int y = box.top() + padding + fm.ascent();
+    for (const auto &line : lines) {
+        painter.drawText(box.left() + padding, y, line);
+        y += fm.height();
+    }
+}
+
+void ImageViewWidget::setPerformanceHudVisible(bool visible)
+{
+    if (d->hudVisible == visible)
+        return;
+
+    d->hudVisible = visible;
+    d->frameTimeMs = 0;
+    d->uploadBytesPerSec = 0;
+    update();
+}
+
+bool ImageViewWidget::performanceHudVisible() const
+{
+    return d->hudVisible;
+}
+
+void ImageViewWidget::setReadStatistics(const PlaneReadStatistics &stats)
+{
+    d->readStats = stats;
+    if (d->hudVisible)
+        update();
+}
+
 RawImage ImageViewWidget::currentImage() const
 {
     return d->glImage;
@@ -47,10 +47,22 @@ public slots:
 
     [[nodiscard]] bool usesGLES() const;
 
+    /**
+     * @brief Show an overlay with frame timings, read path counters and memory usage.
+     */
+    void setPerformanceHudVisible(bool visible);
+    [[nodiscard]] bool performanceHudVisible() const;
+
+    /**
+     * @brief Set the read path counters displayed in the performance overlay.
+     */
+    void setReadStatistics(const PlaneReadStatistics &stats);
+
 protected:
     void initializeGL() override;
     void paintGL() override;
     void renderImage();
+    void drawPerformanceHud();
 
 private:
     void cleanupGL();
@@ -0,0 +1,341 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include "jobserver.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QLocalServer>
+#include <QLocalSocket>
+
+#include "codecselector.h"
+#include "hdf5exporter.h"
+#include "metadatajson.h"
+#include "savequeue.h"
+
+using namespace Qt::StringLiterals;
+
+// Standard JSON-RPC 2.0 error codes
+static constexpr int RpcParseError = -32700;
+static constexpr int RpcInvalidRequest = -32600;
+static constexpr int RpcMethodNotFound = -32601;
+static constexpr int RpcInvalidParams = -32602;
+
+// Requests are small, anything bigger than this is not a client talking to us
+static constexpr qsizetype MaxMessageSize = 16 * 1024 * 1024;
+
+// How long to wait for a server that may still be listening on our socket
+static constexpr int SocketProbeTimeoutMs = 500;
+
+static QString jobStateName(SaveJob::State state)
+{
+    switch (state) {
+    case SaveJob::State::Queued:
+        return QStringLiteral("queued");
+    case SaveJob::State::Running:
+        return QStringLiteral("running");
+    case SaveJob::State::Succeeded:
+        return QStringLiteral("succeeded");
+    case SaveJob::State::Failed:
+        return QStringLiteral("failed");
+    case SaveJob::State::Cancelled:
+        return QStringLiteral("cancelled");
+    }
+
+    return {};
+}
+
+JobServer::JobServer(QObject *parent)
+    : QObject(parent),
+      m_server(new QLocalServer(this)),
+      m_queue(std::make_unique<SaveQueue>(this))
+{
+    // only the user running the server may submit jobs
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(m_server, &QLocalServer::newConnection, this, &JobServer::onNewConnection);
+}
+
+JobServer::~JobServer() = default;
+
+void JobServer::setMaxConcurrentJobs(int count)
+{
+    m_queue->setMaxConcurrentJobs(count);
+}
+
+bool JobServer::listen(const QString &name)
+{
+    // never take the socket over from a server that is still running
+    QLocalSocket probe;
+    probe.connectToServer(name);
+    if (probe.waitForConnected(SocketProbeTimeoutMs)) {
+        probe.disconnectFromServer();
+        qWarning().noquote() << "A job server is already running on" << name;
+        return false;
+    }
+
+    // a previous instance that crashed may have left its socket behind
+    QLocalServer::removeServer(name);
+    if (!m_server->listen(name)) {
+        qWarning().noquote() << "Failed to listen on" << name << "-" << m_server->errorString();
+        return false;
+    }
+
+    m_uptime.start();
+    qInfo().noquote() << "Accepting jobs on" << m_server->fullServerName();
+    return true;
+}
+
+QString JobServer::socketPath() const
+{
+    return m_server->fullServerName();
+}
+
+void JobServer::onNewConnection()
+{
+    while (auto socket = m_server->nextPendingConnection()) {
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket]() {
+            onReadyRead(socket);
+        });
+        connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+    }
+}
+
+void JobServer::onReadyRead(QLocalSocket *socket)
+{
+    while (socket->canReadLine()) {
+        const auto line = socket->readLine().trimmed();
+        if (!line.isEmpty())
+            handleMessage(socket, line);
+    }
+
+    if (socket->bytesAvailable() > MaxMessageSize) {
+        qWarning().noquote() << "Dropping client connection, message too large";
+        socket->abort();
+    }
+}
+
+void JobServer::handleMessage(QLocalSocket *socket, const QByteArray &line)
+{
+    QJsonObject response{{QStringLiteral("jsonrpc"), QStringLiteral("2.0")}};
+
+    QJsonParseError parseError;
+    const auto doc = QJsonDocument::fromJson(line, &parseError);
+    if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+        const bool isParseError = parseError.error != QJsonParseError::NoError;
+        response[QStringLiteral("id")] = QJsonValue::Null;
+        response[QStringLiteral("error")] = QJsonObject{
+            {QStringLiteral("code"), isParseError ? RpcParseError : RpcInvalidRequest},
+            {QStringLiteral("message"), isParseError ? parseError.errorString() : QStringLiteral("Invalid request")},
+        };
+        send(socket, response);
+        return;
+    }
+
+    const auto request = doc.object();
+    const auto method = request.value(QStringLiteral("method")).toString();
+    const auto params = request.value(QStringLiteral("params")).toObject();
+    const bool isNotification = !request.contains(QStringLiteral("id"));
+
+    RpcResult result;
+    if (method == "submit"_L1)
+        result = submit(socket, params);
+    else if (method == "cancel"_L1)
+        result = cancel(params);
+    else if (method == "status"_L1)
+        result = status();
+    else
+        result = std::unexpected(RpcError{RpcMethodNotFound, QStringLiteral("Unknown method: %1").arg(method)});
+
+    if (isNotification)
+        return;
+
+    response[QStringLiteral("id")] = request.value(QStringLiteral("id"));
+    if (result)
+        response[QStringLiteral("result")] = result.value();
+    else
+        response[QStringLiteral("error")] = QJsonObject{
+            {QStringLiteral("code"), result.error().code},
+            {QStringLiteral("message"), result.error().message},
+        };
+    send(socket, response);
+}
+
+JobServer::RpcResult JobServer::submit(QLocalSocket *socket, const QJsonObject &params)
+{
+    const auto input = params.value(QStringLiteral("input")).toString();
+    if (input.isEmpty())
+        return std::unexpected(RpcError{RpcInvalidParams, QStringLiteral("No input file given")});
+    const QFileInfo inputInfo(input);
+    if (!inputInfo.isFile())
+        return std::unexpected(RpcError{RpcInvalidParams, QStringLiteral("Input file does not exist: %1").arg(input)});
+
+    std::expected<ImageMetadata, QString> metadata = std::unexpected(QStringLiteral("No parameters given"));
+    if (params.value(QStringLiteral("params")).isObject())
+        metadata = MetadataJson::fromJson(params.value(QStringLiteral("params")).toObject());
+    else if (params.contains(QStringLiteral("paramsFile")))
+        metadata = MetadataJson::loadParameters(params.value(QStringLiteral("paramsFile")).toString());
+    if (!metadata)
+        return std::unexpected(RpcError{RpcInvalidParams, metadata.error()});
+
+    SaveRequest request;
+    request.sourcePath = inputInfo.absoluteFilePath();
+    request.destPath = params.value(QStringLiteral("output")).toString();
+    if (request.destPath.isEmpty())
+        request.destPath = inputInfo.absoluteDir().absoluteFilePath(inputInfo.completeBaseName() + ".ome.tiff"_L1);
+    request.metadata = metadata.value();
+    request.applyAsParameters = params.value(QStringLiteral("applyAsParameters")).toBool(true);
+    request.deleteSource = params.value(QStringLiteral("deleteSource")).toBool(false);
+    request.deduplicatePlanes = params.value(QStringLiteral("deduplicate")).toBool(false);
+    request.interleavedChannels = std::max(params.value(QStringLiteral("interleavedChannels")).toInt(1), 1);
+    request.framesPerSlice = std::max(params.value(QStringLiteral("framesPerSlice")).toInt(1), 1);
+
+    const auto binMode = params.value(QStringLiteral("frameBinning")).toString(QStringLiteral("average"));
+    if (binMode == "sum"_L1)
+        request.frameBinMode = FrameBinMode::Sum;
+    else if (binMode != "average"_L1)
+        return std::unexpected(RpcError{RpcInvalidParams, QStringLiteral("Unknown frame binning: %1").arg(binMode)});
+
+    const auto conversionName = params.value(QStringLiteral("pixelConversion")).toString(QStringLiteral("none"));
+    const auto conversion = pixelConversionFromName(conversionName);
+    if (!conversion)
+        return std::unexpected(
+            RpcError{RpcInvalidParams, QStringLiteral("Unknown pixel conversion: %1").arg(conversionName)});
+    request.pixelConversion = conversion.value();
+
+    const auto compressionName = params.value(QStringLiteral("compression")).toString(QStringLiteral("deflate"));
+    if (compressionName == "auto"_L1) {
+        const auto goal = params.contains(QStringLiteral("compressionGoal"))
+                              ? CompressionGoal::fromString(params.value(QStringLiteral("compressionGoal")).toString())
+                              : CompressionGoal::fromSettings();
+        if (!goal)
+            return std::unexpected(RpcError{RpcInvalidParams, goal.error()});
+        request.compressionGoal = goal.value();
+    } else {
+        const auto compression = tiffCompressionFromName(compressionName);
+        if (!compression)
+            return std::unexpected(
+                RpcError{RpcInvalidParams, QStringLiteral("Unknown compression: %1").arg(compressionName)});
+        if (!OMETiffImage::isCompressionAvailable(compression.value()))
+            return std::unexpected(RpcError{
+                RpcInvalidParams,
+                QStringLiteral("Compression %1 is not supported by this build").arg(compressionName)});
+        request.compression = compression.value();
+    }
+
+    if (Hdf5Exporter::hasHdf5Extension(request.destPath) && !Hdf5Exporter::isAvailable())
+        return std::unexpected(
+            RpcError{RpcInvalidParams, QStringLiteral("HDF5 output is not supported by this build")});
+    const auto hdf5Options = Hdf5ExportOptions::fromJson(
+        params.value(QStringLiteral("hdf5")).toObject(), Hdf5ExportOptions::fromSettings());
+    if (!hdf5Options)
+        return std::unexpected(RpcError{RpcInvalidParams, hdf5Options.error()});
+    request.hdf5Options = hdf5Options.value();
+
+    const auto id = m_nextJobId++;
+    auto job = m_queue->enqueue(request);
+    m_jobs.insert(id, job);
+    m_jobClients.insert(job, socket);
+
+    connect(job, &SaveJob::started, this, [this, id, job]() {
+        notify(m_jobClients.value(job), QStringLiteral("progress"), jobToJson(id, job));
+    });
+    connect(job, &SaveJob::progressChanged, this, [this, id, job]() {
+        notify(m_jobClients.value(job), QStringLiteral("progress"), jobToJson(id, job));
+    });
+    connect(job, &SaveJob::finished, this, [this, id, job](bool success, const QString &message) {
+        if (success) {
+            m_succeeded++;
+            m_bytesProcessed += job->statistics().bytesIn;
+        } else if (job->state() == SaveJob::State::Cancelled) {
+            m_cancelled++;
+        } else {
+            m_failed++;
+        }
+
+        auto info = jobToJson(id, job);
+        info[QStringLiteral("success")] = success;
+        info[QStringLiteral("message")] = message;
+        notify(m_jobClients.value(job), QStringLiteral("finished"), info);
+
+        m_jobs.remove(id);
+        m_jobClients.remove(job);
+        m_queue->removeFinished();
+    });
+
+    return QJsonObject{{QStringLiteral("job"), id}};
+}
+
+JobServer::RpcResult JobServer::cancel(const QJsonObject &params)
+{
+    const auto job = m_jobs.value(params.value(QStringLiteral("job")).toInt(-1));
+    if (job == nullptr)
+        return std::unexpected(RpcError{RpcInvalidParams, QStringLiteral("Unknown job")});
+
+    job->cancel();
+    return true;
+}
+
+QJsonObject JobServer::status() const
+{
+    double bytesPerSecond = 0;
+    QJsonArray jobs;
+    for (auto it = m_jobs.cbegin(); it != m_jobs.cend(); ++it) {
+        bytesPerSecond += it.value()->bytesPerSecond();
+        jobs.append(jobToJson(it.key(), it.value()));
+    }
+
+    const auto uptimeSecs = m_uptime.isValid() ? m_uptime.elapsed() / 1000.0 : 0.0;
+    const auto averageBytesPerSecond = uptimeSecs > 0 ? static_cast<double>(m_bytesProcessed) / uptimeSecs : 0.0;
+    return QJsonObject{
+        {QStringLiteral("queued"), m_queue->pendingCount()},
+        {QStringLiteral("running"), m_queue->runningCount()},
+        {QStringLiteral("maxConcurrentJobs"), m_queue->maxConcurrentJobs()},
+        {QStringLiteral("succeeded"), static_cast<qint64>(m_succeeded)},
+        {QStringLiteral("failed"), static_cast<qint64>(m_failed)},
+        {QStringLiteral("cancelled"), static_cast<qint64>(m_cancelled)},
+        {QStringLiteral("bytesProcessed"), static_cast<qint64>(m_bytesProcessed)},
+        {QStringLiteral("bytesPerSecond"), bytesPerSecond},
+        {QStringLiteral("averageBytesPerSecond"), averageBytesPerSecond},
+        {QStringLiteral("uptimeSecs"), uptimeSecs},
+        {QStringLiteral("jobs"), jobs},
+    };
+}
+
+QJsonObject JobServer::jobToJson(int id, const SaveJob *job)
+{
+    return QJsonObject{
+        {QStringLiteral("job"), id},
+        {QStringLiteral("input"), job->request().sourcePath},
+        {QStringLiteral("output"), job->request().destPath},
+        {QStringLiteral("state"), jobStateName(job->state())},
+        {QStringLiteral("planesDone"), job->planesDone()},
+        {QStringLiteral("planesTotal"), job->planesTotal()},
+        {QStringLiteral("bytesPerSecond"), job->bytesPerSecond()},
+        {QStringLiteral("remainingSecs"), job->remainingSecs()},
+    };
+}
+
+void JobServer::send(QLocalSocket *socket, const QJsonObject &message)
+{
+    if (socket == nullptr || socket->state() != QLocalSocket::ConnectedState)
+        return;
+
+    socket->write(QJsonDocument(message).toJson(QJsonDocument::Compact));
+    socket->write("\n");
+}
+
+void JobServer::notify(QLocalSocket *socket, const QString &method, const QJsonObject &params)
+{
+    send(socket,
+         QJsonObject{
+             {QStringLiteral("jsonrpc"), QStringLiteral("2.0")},
+             {QStringLiteral("method"), method},
+             {QStringLiteral("params"), params},
+         });
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QPointer>
+#include <expected>
+#include <memory>
+
+class QLocalServer;
+class QLocalSocket;
+class SaveJob;
+class SaveQueue;
+
+/**
+ * @brief Accepts rewrite jobs from other programs over a local socket.
+ *
+ * Clients send JSON-RPC 2.0 requests, one JSON document per line, and receive the
+ * responses the same way. The available methods are:
+ *
+ *  - submit: queue a job. Takes "input", and optionally "output", "params" (an object
+ *    in the MetadataJson format), "paramsFile", "interleavedChannels", "applyAsParameters"
+ *    (default true), "deleteSource", "framesPerSlice" and "frameBinning" ("average" or "sum",
+ *    see OMETiffImage::setFrameBinning) and "pixelConversion" ("none", "uint16", "uint8" or
+ *    "offset-uint16", see OMETiffImage::setPixelConversion) and "compression" ("deflate", "zstd"
+ *    or "auto"). An "output" ending in .nwb, .h5 or .hdf5 is written as HDF5, with the chunking
+ *    and compression given in "hdf5" (see Hdf5ExportOptions::fromJson). With "auto", the
+ *    compression of either format is chosen from sampled planes for the "compressionGoal"
+ *    (see CompressionGoal::fromString), and the decision is recorded in the job report.
+ *    With "deduplicate" (default false), identical OME-TIFF planes share their pixel data
+ *    (see OMETiffImage::setDeduplicatePlanes). Returns the numeric job ID.
+ *  - cancel: cancel the job with the given "job" ID.
+ *  - status: queue depth, completed job counts and throughput of the server.
+ *
+ * The client that submitted a job receives "progress" and "finished" notifications
+ * for it. All jobs share the worker pool of one SaveQueue.
+ */
+class JobServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit JobServer(QObject *parent = nullptr);
+    ~JobServer() override;
+
+    void setMaxConcurrentJobs(int count);
+
+    /**
+     * @brief Start listening on the local socket with the given name.
+     * @return false if the socket could not be created.
+     */
+    bool listen(const QString &name);
+
+    [[nodiscard]] QString socketPath() const;
+
+private:
+    struct RpcError {
+        int code;
+        QString message;
+    };
+    using RpcResult = std::expected<QJsonValue, RpcError>;
+
+    void onNewConnection();
+    void onReadyRead(QLocalSocket *socket);
+    void handleMessage(QLocalSocket *socket, const QByteArray &line);
+    RpcResult submit(QLocalSocket *socket, const QJsonObject &params);
+    RpcResult cancel(const QJsonObject &params);
+    [[nodiscard]] QJsonObject status() const;
+    [[nodiscard]] static QJsonObject jobToJson(int id, const SaveJob *job);
+    static void send(QLocalSocket *socket, const QJsonObject &message);
+    static void notify(QLocalSocket *socket, const QString &method, const QJsonObject &params);
+
+    QLocalServer *m_server;
+    std::unique_ptr<SaveQueue> m_queue;
+
+    int m_nextJobId = 1;
+    QHash<int, SaveJob *> m_jobs;
+    QHash<SaveJob *, QPointer<QLocalSocket>> m_jobClients;
+
+    QElapsedTimer m_uptime;
+    quint64 m_succeeded = 0;
+    quint64 m_failed = 0;
+    quint64 m_cancelled = 0;
+    quint64 m_bytesProcessed = 0;
+};
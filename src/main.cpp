@@ -7,19 +7,196 @@
 #include "mainwindow.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
 #include <QIcon>
+#include <QSettings>
 #include <QStyleHints>
+#include <cstring>
+#include <memory>
+
+#include "config.h"
+#include "jobserver.h"
+#include "perftrace.h"
+#include "saveestimator.h"
+#include "watchservice.h"
+
+/**
+ * Check for an option before the application object exists, which is needed
+ * to decide whether we need a GUI at all.
+ */
+static bool hasOption(int argc, char *argv[], const char *name)
+{
+    const auto nameLen = std::strlen(name);
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], name, nameLen) == 0 && (argv[i][nameLen] == '\0' || argv[i][nameLen] == '='))
+            return true;
+    }
+
+    return false;
+}
+
+static int runWatchService(const QCommandLineParser &parser)
+{
+    WatchService service;
+    service.setParameterFile(parser.value(QStringLiteral("params")));
+    if (parser.isSet(QStringLiteral("jobs")))
+        service.setMaxConcurrentJobs(parser.value(QStringLiteral("jobs")).toInt());
+
+    if (parser.isSet(QStringLiteral("follow"))) {
+        QObject::connect(&service, &WatchService::followFinished, [](bool success) {
+            QCoreApplication::exit(success ? 0 : 1);
+        });
+        const auto slices = parser.isSet(QStringLiteral("slices")) ? parser.value(QStringLiteral("slices")).toInt() : 1;
+        if (!service.follow(parser.value(QStringLiteral("follow")), slices))
+            return 1;
+        return QCoreApplication::exec();
+    }
+
+    if (!service.start(parser.values(QStringLiteral("watch")))) {
+        qCritical().noquote() << "None of the given directories can be watched.";
+        return 1;
+    }
+
+    return QCoreApplication::exec();
+}
+
+static int runJobServer(const QCommandLineParser &parser)
+{
+    JobServer server;
+    if (parser.isSet(QStringLiteral("jobs")))
+        server.setMaxConcurrentJobs(parser.value(QStringLiteral("jobs")).toInt());
+
+    const auto socketName = parser.isSet(QStringLiteral("socket")) ? parser.value(QStringLiteral("socket"))
+                                                                   : QStringLiteral("omerewriter");
+    if (!server.listen(socketName))
+        return 1;
+
+    return QCoreApplication::exec();
+}
+
+static int runEstimate(const QCommandLineParser &parser)
+{
+    const auto sourcePath = parser.value(QStringLiteral("estimate"));
+    OMETiffImage image;
+    if (!image.open(sourcePath)) {
+        qCritical().noquote() << "Unable to open" << sourcePath;
+        return 1;
+    }
+
+    SaveRequest request;
+    request.sourcePath = sourcePath;
+    if (parser.isSet(QStringLiteral("output"))) {
+        request.destPath = parser.value(QStringLiteral("output"));
+    } else {
+        const QFileInfo fi(sourcePath);
+        request.destPath = OMETiffImage::hasOmeTiffExtension(sourcePath)
+                               ? sourcePath
+                               : fi.absoluteDir().absoluteFilePath(fi.completeBaseName() + QStringLiteral(".ome.tiff"));
+    }
+    request.hdf5Options = Hdf5ExportOptions::fromSettings();
+
+    // the same compression the GUI would save with
+    QSettings settings("OMERewriter", "OMERewriter");
+    const auto compressionName = settings.value("saving/compression").toString();
+    if (compressionName == QStringLiteral("auto"))
+        request.compressionGoal = CompressionGoal::fromSettings();
+    else
+        request.compression = tiffCompressionFromName(compressionName).value_or(TiffCompression::Deflate);
+
+    const auto estimate = SaveEstimator(image, request).estimate();
+    if (!estimate) {
+        qCritical().noquote() << estimate.error();
+        return 1;
+    }
+
+    qInfo().noquote() << QStringLiteral("Estimate for writing %1:").arg(request.destPath);
+    qInfo().noquote() << estimate->summary();
+    if (!estimate->fitsOnVolume()) {
+        qCritical().noquote() << "The destination volume does not have enough free space.";
+        return 2;
+    }
+
+    return 0;
+}
 
 int main(int argc, char *argv[])
 {
-    QApplication a(argc, argv);
-    QApplication::setApplicationName(QStringLiteral("OMERewriter"));
-    QApplication::setWindowIcon(QIcon(QStringLiteral(":/icons/appicon")));
+    // Service modes run without a GUI, e.g. on an acquisition PC or a server
+    const bool serve = hasOption(argc, argv, "--serve");
+    const bool estimate = hasOption(argc, argv, "--estimate");
+    const bool headless = serve || estimate || hasOption(argc, argv, "--watch") || hasOption(argc, argv, "--follow");
+
+    std::unique_ptr<QCoreApplication> app(
+        headless ? new QCoreApplication(argc, argv) : new QApplication(argc, argv));
+    QCoreApplication::setApplicationName(QStringLiteral("OMERewriter"));
+    QCoreApplication::setApplicationVersion(QStringLiteral(PROJECT_VERSION));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("View and rewrite OME-TIFF metadata"));
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addOptions({
+        {QStringLiteral("watch"),
+         QStringLiteral("Convert finished acquisitions in <directory> without showing a window. "
+                        "Can be given multiple times."),
+         QStringLiteral("directory")},
+        {QStringLiteral("follow"),
+         QStringLiteral("Convert <file> while it is still being written, finishing when it stops growing."),
+         QStringLiteral("file")},
+        {QStringLiteral("slices"),
+         QStringLiteral("Number of Z slices per volume of a followed recording."),
+         QStringLiteral("count")},
+        {QStringLiteral("serve"),
+         QStringLiteral("Accept rewrite jobs as JSON-RPC requests on a local socket, without showing a window.")},
+        {QStringLiteral("socket"),
+         QStringLiteral("Name of the local socket to accept jobs on (default: omerewriter)."),
+         QStringLiteral("name")},
+        {QStringLiteral("params"),
+         QStringLiteral("Parameter set to convert all files with, instead of the matching saved one."),
+         QStringLiteral("file")},
+        {QStringLiteral("jobs"), QStringLiteral("Maximum number of parallel conversions."), QStringLiteral("count")},
+        {QStringLiteral("estimate"),
+         QStringLiteral("Estimate size, duration and disk space of converting <file>, from a sample of its planes."),
+         QStringLiteral("file")},
+        {QStringLiteral("output"),
+         QStringLiteral("Destination to estimate the conversion for (default: an OME-TIFF next to the file)."),
+         QStringLiteral("file")},
+    });
+    parser.process(*app);
+
+    // OMEREWRITER_TRACE=<file> records a performance trace of the whole session
+    const auto traceFile = qEnvironmentVariable("OMEREWRITER_TRACE");
+    if (!traceFile.isEmpty())
+        PerfTrace::setEnabled(true);
+
+    int ret;
+    if (estimate) {
+        ret = runEstimate(parser);
+    } else if (serve) {
+        ret = runJobServer(parser);
+    } else if (headless) {
+        ret = runWatchService(parser);
+    } else {
+        QApplication::setWindowIcon(QIcon(QStringLiteral(":/icons/appicon")));
+
+        // prefer dark color scheme
+        QApplication::styleHints()->setColorScheme(Qt::ColorScheme::Dark);
+
+        MainWindow w;
+        w.show();
+        ret = QApplication::exec();
+    }
 
-    // prefer dark color scheme
-    a.styleHints()->setColorScheme(Qt::ColorScheme::Dark);
+    if (!traceFile.isEmpty()) {
+        const auto result = PerfTrace::exportChromeTrace(traceFile);
+        if (result)
+            qInfo().noquote() << "Wrote" << result.value() << "trace events to" << traceFile;
+        else
+            qWarning().noquote() << result.error();
+    }
 
-    MainWindow w;
-    w.show();
-    return a.exec();
+    return ret;
 }
@@ -9,94 +9,67 @@
 #include "config.h"
 
 #include <QFileDialog>
+#include <QInputDialog>
 #include <QMessageBox>
-#include <QProgressDialog>
-#include <QTemporaryDir>
-#include <QThread>
+#include <QCloseEvent>
+#include <QDir>
+#include <QDockWidget>
 #include <QSettings>
+#include <QRegularExpression>
 #include <QDebug>
-#include <atomic>
 
 #include "ometiffimage.h"
 #include "microscopeparamswidget.h"
 #include "metadatajson.h"
 #include "savedparamsmanager.h"
+#include "perftrace.h"
+#include "saveestimator.h"
+#include "savejob.h"
+#include "savequeue.h"
+#include "savequeuewidget.h"
+#include "batchapplydialog.h"
+#include "hdf5exporter.h"
+#include "rawbinarydialog.h"
+#include "catalog.h"
+#include "catalogdialog.h"
+#include "catalogscanner.h"
 #include "rangeslider.h"
 #include "utils.h"
 
-/**
- * @brief Worker class for saving OME-TIFF files in a background thread
- */
-class TiffSaveWorker : public QObject
-{
-    Q_OBJECT
-
-public:
-    TiffSaveWorker(
-        OMETiffImage *tiffImage,
-        const QString &outputPath,
-        const ImageMetadata &metadata,
-        QObject *parent = nullptr)
-        : QObject(parent),
-          m_tiffImage(tiffImage),
-          m_outputPath(outputPath),
-          m_metadata(metadata),
-          m_cancelled(false)
-    {
-    }
-
-    void cancel()
-    {
-        m_cancelled.store(true);
-    }
-
-public slots:
-    void doSave()
-    {
-        auto result = m_tiffImage->saveWithMetadata(
-            m_outputPath,
-            m_metadata,
-            [this](OMETiffImage::dimension_size_type current, OMETiffImage::dimension_size_type total) {
-                emit progressChanged(current, total);
-                return !m_cancelled.load();
-            });
-
-        if (result)
-            emit finished(true, QString());
-        else
-            emit finished(false, result.error());
-    }
-
-signals:
-    void progressChanged(uint current, uint total);
-    void finished(bool success, const QString &errorMessage);
-
-private:
-    OMETiffImage *m_tiffImage;
-    QString m_outputPath;
-    ImageMetadata m_metadata;
-    std::atomic_bool m_cancelled;
-};
-
-#include "mainwindow.moc"
-
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent),
       ui(new Ui::MainWindow),
       m_tiffImage(std::make_unique<OMETiffImage>(this)),
-      m_savedParamsManager(std::make_unique<SavedParamsManager>(this))
+      m_savedParamsManager(std::make_unique<SavedParamsManager>(this)),
+      m_saveQueue(std::make_unique<SaveQueue>(this))
 {
     ui->setupUi(this);
+
+    // Save queue panel, jobs are added to it by startSaveJob()
+    auto saveQueueDock = new QDockWidget(QStringLiteral("Save Queue"), this);
+    saveQueueDock->setObjectName(QStringLiteral("saveQueueDockWidget"));
+    saveQueueDock->setWidget(new SaveQueueWidget(m_saveQueue.get(), saveQueueDock));
+    addDockWidget(Qt::BottomDockWidgetArea, saveQueueDock);
+    saveQueueDock->hide();
+    connect(m_saveQueue.get(), &SaveQueue::jobAdded, saveQueueDock, &QDockWidget::show);
+
     updateThemeIcons();
     connect(qApp, &QApplication::paletteChanged, this, &MainWindow::updateThemeIcons);
 
     // Menu actions
     ui->menuView->addAction(ui->viewDockWidget->toggleViewAction());
+    ui->menuView->addAction(saveQueueDock->toggleViewAction());
     connect(ui->actionOpen, &QAction::triggered, this, &MainWindow::onOpenFile);
+    connect(ui->actionOpenFolder, &QAction::triggered, this, &MainWindow::onOpenFolder);
     connect(ui->actionSave, &QAction::triggered, this, &MainWindow::onSaveFile);
     connect(ui->actionSaveAs, &QAction::triggered, this, &MainWindow::onSaveFileAs);
+    connect(ui->actionEstimateSave, &QAction::triggered, this, &MainWindow::onEstimateSave);
     connect(ui->actionLoadParams, &QAction::triggered, this, &MainWindow::onLoadParamsClicked);
+    connect(ui->actionBatchApply, &QAction::triggered, this, &MainWindow::onBatchApplyClicked);
+    connect(ui->actionCatalog, &QAction::triggered, this, &MainWindow::onCatalogClicked);
     connect(ui->actionAbout, &QAction::triggered, this, &MainWindow::onAbout);
+    connect(ui->actionRecordTrace, &QAction::toggled, this, &MainWindow::onRecordTraceToggled);
+    connect(ui->actionPerformanceHud, &QAction::toggled, ui->imageView, &ImageViewWidget::setPerformanceHudVisible);
     connect(ui->btnLoadTiff, &QPushButton::clicked, this, &MainWindow::onOpenFile);
     connect(ui->btnQuickSave, &QPushButton::clicked, this, &MainWindow::quickSaveFile);
 
@@ -131,17 +104,80 @@ MainWindow::MainWindow(QWidget *parent)
         QOverload<int>::of(&QSpinBox::valueChanged),
         this,
         &MainWindow::onInterleavedChannelsChanged);
+    connect(
+        ui->spinFramesPerSlice,
+        QOverload<int>::of(&QSpinBox::valueChanged),
+        this,
+        &MainWindow::onFrameBinningChanged);
+    connect(ui->comboFrameBinMode, &QComboBox::currentIndexChanged, this, &MainWindow::onFrameBinningChanged);
+    connect(
+        ui->comboPixelConversion, &QComboBox::currentIndexChanged, this, &MainWindow::onPixelConversionChanged);
 
     // Default state
     setNavigationEnabled(false);
     ui->groupTiffInterpretation->setEnabled(false);
-
-    // we currently hide the view menu, as it isn't used yet
-    ui->menuView->menuAction()->setVisible(false);
+    ui->groupOutput->setEnabled(false);
 
     // Set default range for interleave count (1 = no interleaving)
     ui->spinCInterleaveCount->setRange(1, 32);
     ui->spinCInterleaveCount->setValue(1);
+    ui->spinFramesPerSlice->setRange(1, 1000);
+    ui->spinFramesPerSlice->setValue(1);
+
+    // Keep recently viewed planes around, so scrubbing back and forth does not hit the disk
+    {
+        QSettings settings("OMERewriter", "OMERewriter");
+        const auto cacheSizeMiB = settings.value("viewer/planeCacheSizeMiB", 256).toULongLong();
+        m_tiffImage->setPlaneCacheSize(cacheSizeMiB * 1024 * 1024);
+    }
+
+    // The compression of written files is a preference, and Zstandard depends on how libtiff was built
+    {
+        QSettings settings("OMERewriter", "OMERewriter");
+        ui->comboCompression->setItemData(0, tiffCompressionName(TiffCompression::Deflate));
+        ui->comboCompression->setItemData(1, tiffCompressionName(TiffCompression::Zstd));
+        ui->comboCompression->setItemData(2, QStringLiteral("auto"));
+        if (!OMETiffImage::isCompressionAvailable(TiffCompression::Zstd))
+            ui->comboCompression->removeItem(1);
+        const auto index = ui->comboCompression->findData(settings.value("saving/compression").toString());
+        if (index >= 0)
+            ui->comboCompression->setCurrentIndex(index);
+        connect(ui->comboCompression, &QComboBox::currentIndexChanged, this, [this](int index) {
+            QSettings settings("OMERewriter", "OMERewriter");
+            settings.setValue("saving/compression", ui->comboCompression->itemData(index).toString());
+        });
+
+        ui->checkDeduplicate->setChecked(settings.value("saving/deduplicatePlanes", false).toBool());
+        connect(ui->checkDeduplicate, &QCheckBox::toggled, this, [](bool checked) {
+            QSettings settings("OMERewriter", "OMERewriter");
+            settings.setValue("saving/deduplicatePlanes", checked);
+        });
+    }
+
+    // Catalog of all files that were opened, written, or found in the scanned directories
+    {
+        auto catalog = std::make_unique<Catalog>();
+        const auto r = catalog->open();
+        if (r)
+            m_catalog = std::move(catalog);
+        else
+            qWarning().noquote() << r.error();
+    }
+    m_catalogScanner = std::make_unique<CatalogScanner>(Catalog::defaultPath(), this);
+    ui->actionCatalog->setEnabled(m_catalog != nullptr);
+    connect(m_saveQueue.get(), &SaveQueue::jobAdded, this, [this](SaveJob *job) {
+        connect(job, &SaveJob::finished, this, [this, job](bool success) {
+            if (success)
+                recordInCatalog(job->request().destPath, &job->request().metadata);
+        });
+    });
+
+    // Pick up files that were added or changed while we were not running
+    if (m_catalog)
+        m_catalogScanner->start();
+
+    // Tracing may already have been enabled from the environment
+    ui->actionRecordTrace->setChecked(PerfTrace::isEnabled());
 
     // Initialize saved params list
     updateSavedParamsList();
@@ -156,19 +192,116 @@ MainWindow::~MainWindow()
     delete ui;
 }
 
+void MainWindow::closeEvent(QCloseEvent *event)
+{
+    const auto activeJobs = m_saveQueue->runningCount() + m_saveQueue->pendingCount();
+    if (activeJobs > 0) {
+        const auto reply = QMessageBox::question(
+            this,
+            QStringLiteral("Save in Progress"),
+            QStringLiteral("%1 file(s) are still being saved. Cancel saving and quit anyway?").arg(activeJobs),
+            QMessageBox::Yes | QMessageBox::No,
+            QMessageBox::No);
+        if (reply != QMessageBox::Yes) {
+            event->ignore();
+            return;
+        }
+
+        m_saveQueue->cancelAll();
+    }
+
+    QMainWindow::closeEvent(event);
+}
+
 bool MainWindow::openFile(const QString &filename)
 {
     if (filename.isEmpty())
         return false;
 
-    if (!m_tiffImage->open(filename)) {
+    // headerless binary data needs its shape from the user
+    if (RawBinaryDialog::hasRawBinaryExtension(filename))
+        return openRawBinary(filename);
+
+    // long ScanImage recordings are split into multiple files, which belong into one dataset
+    auto series = OMETiffImage::findSeriesFiles(filename);
+    if (series.size() > 1) {
+        const auto answer = QMessageBox::question(
+            this,
+            QStringLiteral("Multi-File Recording"),
+            QStringLiteral("'%1' is part of a recording that was split into %2 files.\n\n"
+                           "Do you want to open all of them as one image?")
+                .arg(QFileInfo(filename).fileName())
+                .arg(series.size()),
+            QMessageBox::Yes | QMessageBox::No,
+            QMessageBox::Yes);
+        if (answer != QMessageBox::Yes)
+            series = {filename};
+    }
+
+    if (!m_tiffImage->openSeries(series)) {
         QMessageBox::critical(this, QStringLiteral("Error"), QStringLiteral("Failed to open file:\n%1").arg(filename));
         return false;
     }
 
+    const QFileInfo fileInfo(m_tiffImage->filename());
+    const auto metadata = showOpenedImage(fileInfo.fileName());
+
+    if (m_catalog) {
+        CatalogEntry entry;
+        entry.path = fileInfo.absoluteFilePath();
+        entry.fileSize = fileInfo.size();
+        entry.modified = fileInfo.lastModified();
+        entry.isOmeTiff = m_tiffImage->isOmeTiff();
+        entry.metadata = metadata;
+        const auto r = m_catalog->addEntry(entry);
+        if (!r)
+            qWarning().noquote() << r.error();
+    }
+
+    return true;
+}
+
+bool MainWindow::openRawBinary(const QString &filename)
+{
+    RawBinaryDialog dialog(filename, this);
+    if (dialog.exec() != QDialog::Accepted)
+        return false;
+
+    const auto r = m_tiffImage->openRawBinary(filename, dialog.layout());
+    if (!r) {
+        QMessageBox::critical(
+            this, QStringLiteral("Error"), QStringLiteral("Failed to open file:\n%1\n\n%2").arg(filename, r.error()));
+        return false;
+    }
+
+    showOpenedImage(QFileInfo(filename).fileName());
+    return true;
+}
+
+bool MainWindow::openFolder(const QString &dirPath, const QString &pattern)
+{
+    if (!m_tiffImage->openFolder(dirPath, pattern)) {
+        QMessageBox::critical(
+            this,
+            QStringLiteral("Error"),
+            QStringLiteral("Failed to open the TIFF files in folder:\n%1\n\n"
+                           "Please check that the file name pattern assigns every file a unique position.")
+                .arg(dirPath));
+        return false;
+    }
+
+    showOpenedImage(QDir(dirPath).dirName());
+    return true;
+}
+
+ImageMetadata MainWindow::showOpenedImage(const QString &name)
+{
     // Update window title
-    QFileInfo fileInfo(filename);
-    setWindowTitle(QStringLiteral("OMERewriter - %1").arg(fileInfo.fileName()));
+    const auto fileCount = m_tiffImage->seriesFiles().size();
+    if (fileCount > 1)
+        setWindowTitle(QStringLiteral("OMERewriter - %1 (%2 files)").arg(name).arg(fileCount));
+    else
+        setWindowTitle(QStringLiteral("OMERewriter - %1").arg(name));
 
     // Update slider ranges based on the opened file
     updateSliderRanges();
@@ -177,6 +310,12 @@ bool MainWindow::openFile(const QString &filename)
     ui->spinCInterleaveCount->blockSignals(true);
     ui->spinCInterleaveCount->setValue(1);
     ui->spinCInterleaveCount->blockSignals(false);
+    ui->spinFramesPerSlice->blockSignals(true);
+    ui->spinFramesPerSlice->setValue(1);
+    ui->spinFramesPerSlice->blockSignals(false);
+    ui->comboPixelConversion->blockSignals(true);
+    ui->comboPixelConversion->setCurrentIndex(0);
+    ui->comboPixelConversion->blockSignals(false);
 
     // Reset position to origin
     m_currentZ = 0;
@@ -191,7 +330,7 @@ bool MainWindow::openFile(const QString &filename)
     // Load and display metadata in the params widget
     ImageMetadata metadata = m_tiffImage->extractMetadata(0);
     if (metadata.imageName.isEmpty())
-        metadata.imageName = fileInfo.fileName();
+        metadata.imageName = name;
 
     // Initialize contrast slider BEFORE displaying the image
     updateContrastSliderRange(metadata);
@@ -203,7 +342,7 @@ bool MainWindow::openFile(const QString &filename)
 
     // Update status bar
     statusBar()->showMessage(QStringLiteral("Loaded: %1 - Size: %2x%3, Z:%4 T:%5 C:%6")
-                                 .arg(fileInfo.fileName())
+                                 .arg(name)
                                  .arg(m_tiffImage->sizeX())
                                  .arg(m_tiffImage->sizeY())
                                  .arg(m_tiffImage->sizeZ())
@@ -212,11 +351,13 @@ bool MainWindow::openFile(const QString &filename)
 
     ui->actionSave->setEnabled(true);
     ui->actionSaveAs->setEnabled(true);
+    ui->actionEstimateSave->setEnabled(true);
 
     // we only allow rewriting / deinterleave if we *didn't* load an OME-TIFF
     ui->groupTiffInterpretation->setEnabled(!m_tiffImage->isOmeTiff());
+    ui->groupOutput->setEnabled(true);
 
-    return true;
+    return metadata;
 }
 
 void MainWindow::onOpenFile()
@@ -229,7 +370,7 @@ void MainWindow::onOpenFile()
         lastDir,
         QStringLiteral(
             "All TIFF Files (*.ome.tiff *.ome.tif *.tiff *.tif);;OME-TIFF Files (*.ome.tiff *.ome.tif);;TIFF Files "
-            "(*.tiff *.tif);;All Files (*)"));
+            "(*.tiff *.tif);;Raw Binary Files (*.bin *.dat *.raw);;All Files (*)"));
 
     if (!filename.isEmpty()) {
         setLastDirectory("openTiff", filename);
@@ -237,6 +378,32 @@ void MainWindow::onOpenFile()
     }
 }
 
+void MainWindow::onOpenFolder()
+{
+    const auto lastDir = getLastDirectory("openFolder", getLastDirectory("openTiff"));
+    const auto dirPath = QFileDialog::getExistingDirectory(this, QStringLiteral("Open Folder of TIFF Files"), lastDir);
+    if (dirPath.isEmpty())
+        return;
+    setLastDirectory("openFolder", dirPath);
+
+    QSettings settings("OMERewriter", "OMERewriter");
+    bool ok = false;
+    const auto pattern = QInputDialog::getText(
+        this,
+        QStringLiteral("File Name Pattern"),
+        QStringLiteral("Regular expression matching the file names, with named groups for the Z, C and T positions,\n"
+                       "e.g. img_c(?<c>\\d+)_z(?<z>\\d+)\\.tif\n\n"
+                       "Leave empty to open all files as a Z stack, in file name order."),
+        QLineEdit::Normal,
+        settings.value("openFolder/pattern").toString(),
+        &ok);
+    if (!ok)
+        return;
+    settings.setValue("openFolder/pattern", pattern);
+
+    openFolder(dirPath, pattern);
+}
+
 void MainWindow::updateSliderRanges()
 {
     if (!m_tiffImage->isOpen())
@@ -329,6 +496,7 @@ void MainWindow::updateImage()
         return;
     }
 
+    ui->imageView->setReadStatistics(m_tiffImage->readStatistics());
     ui->imageView->showImage(image);
 }
 
@@ -359,100 +527,110 @@ void MainWindow::onSliderCChanged(int value)
     updateImage();
 }
 
-void MainWindow::saveCurrentFile(bool quicksave)
+SaveRequest MainWindow::currentFileRequest(bool quicksave) const
 {
-    if (!m_tiffImage->isOpen()) {
-        QMessageBox::warning(this, QStringLiteral("Warning"), QStringLiteral("No file is currently open."));
-        return;
-    }
-
     // The quicksave action does not delete the source image if it wasn't an OME-TIFF,
     // but instead saves a new OME-TIFF alongside it.
     // The regular save action replaces the original file.
     // On quicksave, we also immediately load the saved file.
 
     QFileInfo fi(m_tiffImage->filename());
-    const auto tiffBasename = fi.baseName();
+    auto tiffBasename = fi.isDir() ? fi.fileName() : fi.completeBaseName();
     const auto tiffDir = fi.absoluteDir();
 
+    // a multi-file series is saved without the number of its first file
+    if (!m_tiffImage->seriesFiles().isEmpty() && !fi.isDir())
+        tiffBasename.remove(QRegularExpression(QStringLiteral("_\\d+$")));
+
     const auto wasOmeTiff = m_tiffImage->isOmeTiff();
     const auto origFilename = m_tiffImage->filename();
 
-    QString destFilename;
-    if (wasOmeTiff) {
-        destFilename = m_tiffImage->filename();
-    } else {
-        // For raw TIFF, we save the modified OME-TIFF alongside the original, with a modified name
-        destFilename = tiffDir.absoluteFilePath(tiffBasename + ".ome.tiff");
-
-        if (QFile::exists(destFilename)) {
-            auto result = QMessageBox::question(
-                this,
-                QStringLiteral("File Exists"),
-                QStringLiteral("A file named '%1' already exists. Do you want to overwrite it?").arg(destFilename),
-                QMessageBox::Yes | QMessageBox::No,
-                QMessageBox::No);
-            if (result != QMessageBox::Yes)
-                return;
-        }
-    }
+    // For raw TIFF, we save the modified OME-TIFF alongside the original, with a modified name
+    const auto destFilename = wasOmeTiff ? origFilename : tiffDir.absoluteFilePath(tiffBasename + ".ome.tiff");
+
+    SaveRequest request;
+    request.sourcePath = origFilename;
+    request.seriesFiles = m_tiffImage->seriesFiles();
+    request.folderPattern = m_tiffImage->folderPattern();
+    if (m_tiffImage->isRawBinary())
+        request.rawBinaryLayout = m_tiffImage->rawBinaryLayout();
+    request.interleavedChannels = m_tiffImage->interleavedChannelCount();
+    request.framesPerSlice = m_tiffImage->frameBinning();
+    request.frameBinMode = m_tiffImage->frameBinMode();
+    request.pixelConversion = m_tiffImage->pixelConversion();
+    setRequestCompression(request);
+    request.metadata = ui->imageMetaWidget->getMetadata();
+    request.destPath = destFilename;
+
+    // For regular save of raw TIFF, we delete the original file after saving the new OME-TIFF.
+    // A folder may hold more than this image, so its files are only deleted when confirmed.
+    request.deleteSource = !wasOmeTiff && !quicksave && request.folderPattern.isEmpty();
+
+    return request;
+}
 
-    // Create a temporary directory in the same location as the destination
-    // This ensures: 1) disk space available, 2) same filesystem for atomic move
-    // 3) correct filename in OME-XML metadata (no temp filename warnings)
-    QTemporaryDir tempDir(tiffDir.absoluteFilePath("_temp-omewrite"));
-    if (!tempDir.isValid()) {
-        QMessageBox::critical(this, QStringLiteral("Error"), QStringLiteral("Failed to create temporary directory."));
+void MainWindow::saveCurrentFile(bool quicksave)
+{
+    if (!m_tiffImage->isOpen()) {
+        QMessageBox::warning(this, QStringLiteral("Warning"), QStringLiteral("No file is currently open."));
         return;
     }
-    tempDir.setAutoRemove(true);
 
-    // Write to temp directory using the final filename
-    // This way the OME-XML metadata will contain the correct filename
-    QFileInfo destFi(destFilename);
-    QString tempFile = tempDir.filePath(destFi.fileName());
+    auto request = currentFileRequest(quicksave);
+    if (!m_tiffImage->isOmeTiff() && QFile::exists(request.destPath)) {
+        auto result = QMessageBox::question(
+            this,
+            QStringLiteral("File Exists"),
+            QStringLiteral("A file named '%1' already exists. Do you want to overwrite it?").arg(request.destPath),
+            QMessageBox::Yes | QMessageBox::No,
+            QMessageBox::No);
+        if (result != QMessageBox::Yes)
+            return;
+    }
 
-    ImageMetadata metadata = ui->imageMetaWidget->getMetadata();
+    if (!quicksave && !request.folderPattern.isEmpty()) {
+        const auto result = QMessageBox::question(
+            this,
+            QStringLiteral("Delete Source Files"),
+            QStringLiteral("Do you also want to delete the %1 files of '%2' once they have been saved to '%3'?")
+                .arg(request.seriesFiles.size())
+                .arg(QFileInfo(request.sourcePath).fileName(), QFileInfo(request.destPath).fileName()),
+            QMessageBox::Yes | QMessageBox::No,
+            QMessageBox::No);
+        request.deleteSource = result == QMessageBox::Yes;
+    }
 
-    bool success = performSaveWithProgress(tempFile, metadata);
-    if (!success)
+    startSaveJob(request, false);
+}
+
+void MainWindow::onEstimateSave()
+{
+    if (!m_tiffImage->isOpen()) {
+        QMessageBox::warning(this, QStringLiteral("Warning"), QStringLiteral("No file is currently open."));
         return;
+    }
 
-    // Close the original file
-    m_tiffImage->close();
+    // sampling reads a few planes, which is quick enough to not need a job of its own
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    const auto estimate = SaveEstimator(*m_tiffImage, currentFileRequest(false)).estimate();
+    QApplication::restoreOverrideCursor();
 
-    // Move from temp directory to final destination
-    QFile::remove(destFilename);
-    if (QFile::rename(tempFile, destFilename)) {
-        // Reopen the file
-        if (openFile(destFilename)) {
-            ui->imageMetaWidget->resetModified();
-            statusBar()->showMessage(QStringLiteral("Saved: %1").arg(destFilename), 5000);
-        } else {
-            QMessageBox::critical(this, QStringLiteral("Error"), QStringLiteral("Failed to reopen the saved file."));
-        }
-    } else {
-        QMessageBox::critical(this, QStringLiteral("Error"), QStringLiteral("Failed to replace the original file."));
-        // Try to recover by opening the temp file
-        if (QFile::exists(tempFile))
-            openFile(tempFile);
-    }
-
-    if (!wasOmeTiff && !quicksave) {
-        // For regular save of raw TIFF, we delete the original file after saving the new OME-TIFF
-        if (QFile::exists(origFilename)) {
-            if (QFile::remove(origFilename)) {
-                statusBar()->showMessage(
-                    QStringLiteral("Original file '%1' has been deleted.").arg(origFilename), 5000);
-            } else {
-                QMessageBox::warning(
-                    this,
-                    QStringLiteral("Warning"),
-                    QStringLiteral("Failed to delete original file '%1'. Please check if it can be deleted manually.")
-                        .arg(origFilename));
-            }
-        }
+    if (!estimate) {
+        QMessageBox::warning(
+            this,
+            QStringLiteral("Estimate Failed"),
+            QStringLiteral("Unable to estimate the save: %1").arg(estimate.error()));
+        return;
     }
+
+    if (estimate->fitsOnVolume())
+        QMessageBox::information(this, QStringLiteral("Save Estimate"), estimate->summary());
+    else
+        QMessageBox::warning(
+            this,
+            QStringLiteral("Save Estimate"),
+            QStringLiteral("The destination volume does not have enough free space for this file.\n\n%1")
+                .arg(estimate->summary()));
 }
 
 void MainWindow::onSaveFile()
@@ -472,46 +650,46 @@ void MainWindow::onSaveFileAs()
         return;
     }
 
+    auto filters = QStringLiteral("OME-TIFF Files (*.ome.tiff *.ome.tif);;");
+    if (Hdf5Exporter::isAvailable())
+        filters += QStringLiteral("NWB / HDF5 Files (*.nwb *.h5 *.hdf5);;");
+    filters += QStringLiteral("All Files (*)");
+
     const auto lastDir = getLastDirectory("saveTiff", getLastDirectory("openTiff"));
-    QString filename = QFileDialog::getSaveFileName(
-        this,
-        QStringLiteral("Save OME-TIFF As"),
-        lastDir,
-        QStringLiteral("OME-TIFF Files (*.ome.tiff *.ome.tif);;All Files (*)"));
+    QString filename = QFileDialog::getSaveFileName(this, QStringLiteral("Save Image As"), lastDir, filters);
 
     if (filename.isEmpty())
         return;
     setLastDirectory("saveTiff", filename);
 
     // Ensure proper extension
-    if (!filename.endsWith(".ome.tiff", Qt::CaseInsensitive) && !filename.endsWith(".ome.tif", Qt::CaseInsensitive))
+    const bool toHdf5 = Hdf5Exporter::isAvailable() && Hdf5Exporter::hasHdf5Extension(filename);
+    if (!toHdf5 && !filename.endsWith(".ome.tiff", Qt::CaseInsensitive)
+        && !filename.endsWith(".ome.tif", Qt::CaseInsensitive))
         filename += ".ome.tiff";
 
-    ImageMetadata metadata = ui->imageMetaWidget->getMetadata();
-
-    bool success = performSaveWithProgress(filename, metadata);
-    if (!success)
-        return;
-
-    ui->imageMetaWidget->resetModified();
-    statusBar()->showMessage(QStringLiteral("Saved as: %1").arg(filename), 5000);
-
-    // Ask if user wants to open the newly saved file
-    auto result = QMessageBox::question(
-        this,
-        QStringLiteral("Open Saved File"),
-        QStringLiteral("Do you want to open the newly saved file?"),
-        QMessageBox::Yes | QMessageBox::No,
-        QMessageBox::Yes);
-
-    if (result == QMessageBox::Yes) {
-        m_tiffImage->close();
-        openFile(filename);
-    }
+    SaveRequest request;
+    request.sourcePath = m_tiffImage->filename();
+    request.seriesFiles = m_tiffImage->seriesFiles();
+    request.folderPattern = m_tiffImage->folderPattern();
+    if (m_tiffImage->isRawBinary())
+        request.rawBinaryLayout = m_tiffImage->rawBinaryLayout();
+    request.interleavedChannels = m_tiffImage->interleavedChannelCount();
+    request.framesPerSlice = m_tiffImage->frameBinning();
+    request.frameBinMode = m_tiffImage->frameBinMode();
+    request.pixelConversion = m_tiffImage->pixelConversion();
+    setRequestCompression(request);
+    request.metadata = ui->imageMetaWidget->getMetadata();
+    request.destPath = filename;
+    request.hdf5Options = Hdf5ExportOptions::fromSettings();
+
+    startSaveJob(request, true);
 }
 
 void MainWindow::onMetadataModified()
 {
+    m_metadataEdits++;
+
     // Update window title to indicate unsaved changes
     QString title = windowTitle();
     if (!title.endsWith(" *"))
@@ -561,10 +739,58 @@ void MainWindow::onInterleavedChannelsChanged(int count)
                                  .arg(m_tiffImage->sizeT())
                                  .arg(m_tiffImage->sizeC()));
 
+    // The frames per slice may no longer fit the new interpretation
+    if (!m_tiffImage->setFrameBinning(m_tiffImage->frameBinning(), m_tiffImage->frameBinMode())) {
+        m_tiffImage->setFrameBinning(1);
+        ui->spinFramesPerSlice->blockSignals(true);
+        ui->spinFramesPerSlice->setValue(1);
+        ui->spinFramesPerSlice->blockSignals(false);
+    }
+
     // Update display
     updateImage();
 }
 
+void MainWindow::onFrameBinningChanged()
+{
+    if (!m_tiffImage->isOpen() || m_tiffImage->isOmeTiff())
+        return;
+
+    const auto mode = ui->comboFrameBinMode->currentIndex() == 1 ? FrameBinMode::Sum : FrameBinMode::Average;
+    const auto frames = static_cast<OMETiffImage::dimension_size_type>(ui->spinFramesPerSlice->value());
+    auto r = m_tiffImage->setFrameBinning(frames, mode);
+    if (!r) {
+        QMessageBox::warning(this, QStringLiteral("Invalid Frames per Slice"), r.error());
+        ui->spinFramesPerSlice->blockSignals(true);
+        ui->spinFramesPerSlice->setValue(static_cast<int>(m_tiffImage->frameBinning()));
+        ui->spinFramesPerSlice->blockSignals(false);
+        return;
+    }
+
+    if (frames > 1)
+        statusBar()->showMessage(
+            QStringLiteral("Every %1 frames of a slice will be %2 into one plane when saving")
+                .arg(frames)
+                .arg(mode == FrameBinMode::Sum ? QStringLiteral("summed") : QStringLiteral("averaged")),
+            5000);
+}
+
+void MainWindow::onPixelConversionChanged()
+{
+    if (!m_tiffImage->isOpen())
+        return;
+
+    // the combo box entries are in the order of the enum values
+    const auto conversion = static_cast<PixelConversion>(ui->comboPixelConversion->currentIndex());
+    auto r = m_tiffImage->setPixelConversion(conversion);
+    if (!r) {
+        QMessageBox::warning(this, QStringLiteral("Invalid Pixel Type Conversion"), r.error());
+        ui->comboPixelConversion->blockSignals(true);
+        ui->comboPixelConversion->setCurrentIndex(static_cast<int>(m_tiffImage->pixelConversion()));
+        ui->comboPixelConversion->blockSignals(false);
+    }
+}
+
 void MainWindow::resetSliderValues()
 {
     ui->sliderZ->blockSignals(true);
@@ -589,65 +815,109 @@ void MainWindow::resetSliderValues()
     ui->spinBoxC->blockSignals(false);
 }
 
-bool MainWindow::performSaveWithProgress(const QString &filename, const ImageMetadata &metadata)
+void MainWindow::setRequestCompression(SaveRequest &request) const
 {
-    // Create worker and thread
-    auto thread = new QThread(this);
-    auto worker = new TiffSaveWorker(m_tiffImage.get(), filename, metadata);
-    worker->moveToThread(thread);
-
-    // Create progress dialog
-    auto progressDlg = new QProgressDialog(
-        QStringLiteral("Saving TIFF planes..."), QStringLiteral("Cancel"), 0, 100, this);
-    progressDlg->setWindowTitle(QStringLiteral("Saving OME-TIFF file..."));
-    progressDlg->setMinimumWidth(400);
-    progressDlg->setWindowModality(Qt::WindowModal);
-    progressDlg->setMinimumDuration(0);
-    progressDlg->setValue(0);
-
-    bool success = false;
-    QString errorMessage;
-
-    connect(thread, &QThread::started, worker, &TiffSaveWorker::doSave);
-    connect(worker, &TiffSaveWorker::progressChanged, this, [progressDlg](int current, int total) {
-        if (total <= 0)
-            return;
+    const auto name = ui->comboCompression->currentData().toString();
+    if (name == QStringLiteral("auto"))
+        request.compressionGoal = CompressionGoal::fromSettings();
+    else
+        request.compression = tiffCompressionFromName(name).value_or(TiffCompression::Deflate);
+    request.deduplicatePlanes = ui->checkDeduplicate->isChecked();
+}
 
-        int percentage = (current * 100) / total;
-        progressDlg->setValue(percentage);
-        progressDlg->setLabelText(QStringLiteral("Writing plane %1 of %2").arg(current + 1).arg(total));
-    });
+void MainWindow::startSaveJob(const SaveRequest &request, bool askToOpenResult)
+{
+    auto job = m_saveQueue->enqueue(request);
+    auto viewerClosed = closeViewerOnCommit(job);
+    const auto editsWhenQueued = m_metadataEdits;
 
     connect(
-        worker,
-        &TiffSaveWorker::finished,
+        job,
+        &SaveJob::finished,
         this,
-        [&success, &errorMessage, progressDlg, worker, thread](bool ok, const QString &error) {
-            success = ok;
-            errorMessage = error;
-            progressDlg->setValue(progressDlg->maximum());
-            progressDlg->close();
-            thread->quit();
-        });
+        [this, job, viewerClosed, askToOpenResult, editsWhenQueued](bool success, const QString &message) {
+            const auto request = job->request();
+            const bool editedWhileSaving = m_metadataEdits != editsWhenQueued;
+
+            if (!success) {
+                // Try to recover the view if we had to close it, none of the edits were saved
+                if (*viewerClosed)
+                    reopenAfterSave(
+                        QFile::exists(request.destPath) ? request.destPath : request.sourcePath,
+                        ui->imageMetaWidget->isModified());
+                QMessageBox::critical(
+                    this,
+                    QStringLiteral("Failed to save TIFF file"),
+                    message.isEmpty() ? "Unknown error!" : message);
+                return;
+            }
 
-    connect(progressDlg, &QProgressDialog::canceled, worker, &TiffSaveWorker::cancel, Qt::DirectConnection);
+            // Only touch the view if it still shows the file that was saved
+            const bool viewingSource = m_tiffImage->isOpen() && m_tiffImage->filename() == request.sourcePath;
+            if (Hdf5Exporter::hasHdf5Extension(request.destPath)) {
+                // HDF5 exports can not be viewed, show the source again if the viewer had to let go of it
+                if (*viewerClosed && QFile::exists(request.sourcePath))
+                    reopenAfterSave(request.sourcePath, editedWhileSaving);
+            } else if (*viewerClosed || viewingSource) {
+                bool openResult = true;
+                if (askToOpenResult && !*viewerClosed) {
+                    if (!editedWhileSaving)
+                        ui->imageMetaWidget->resetModified();
+                    openResult = QMessageBox::question(
+                                     this,
+                                     QStringLiteral("Open Saved File"),
+                                     QStringLiteral("Do you want to open the newly saved file?"),
+                                     QMessageBox::Yes | QMessageBox::No,
+                                     QMessageBox::Yes)
+                                 == QMessageBox::Yes;
+                }
+
+                if (openResult) {
+                    m_tiffImage->close();
+                    reopenAfterSave(request.destPath, editedWhileSaving);
+                }
+            }
+
+            statusBar()->showMessage(
+                (askToOpenResult ? QStringLiteral("Saved as: %1") : QStringLiteral("Saved: %1")).arg(request.destPath),
+                5000);
+            if (!message.isEmpty())
+                QMessageBox::warning(this, QStringLiteral("Warning"), message);
+        });
+}
 
-    // cleanup everything later
-    connect(thread, &QThread::finished, thread, &QThread::deleteLater);
-    connect(thread, &QThread::finished, worker, &QObject::deleteLater);
-    connect(thread, &QThread::finished, progressDlg, &QObject::deleteLater);
+bool MainWindow::reopenAfterSave(const QString &filename, bool keepEdits)
+{
+    // Metadata edits the save did not include are applied on top of the reloaded metadata
+    const auto edits = ui->imageMetaWidget->getMetadata();
+    if (!openFile(filename))
+        return false;
 
-    thread->start();
-    while (thread->isRunning()) {
-        QApplication::processEvents();
-        QThread::msleep(10);
+    if (keepEdits) {
+        ui->imageMetaWidget->setMetadata(MetadataJson::applyParameters(edits, ui->imageMetaWidget->getMetadata()));
+        ui->imageMetaWidget->markModified();
+        statusBar()->showMessage(QStringLiteral("Kept metadata changes that were not saved yet"), 5000);
+    } else {
+        ui->imageMetaWidget->resetModified();
     }
 
-    if (!success)
-        QMessageBox::critical(
-            this, QStringLiteral("Failed to save TIFF file"), errorMessage.isEmpty() ? "Unknown error!" : errorMessage);
+    return true;
+}
 
-    return success;
+std::shared_ptr<bool> MainWindow::closeViewerOnCommit(SaveJob *job)
+{
+    // The viewer must let go of files that are about to be replaced or deleted
+    auto viewerClosed = std::make_shared<bool>(false);
+    connect(job, &SaveJob::aboutToCommit, this, [this, viewerClosed](const QString &dest, const QString &source) {
+        const auto current = m_tiffImage->filename();
+        if (current.isEmpty() || (current != dest && current != source))
+            return;
+
+        m_tiffImage->close();
+        *viewerClosed = true;
+    });
+
+    return viewerClosed;
 }
 
 void MainWindow::onSaveParamsClicked()
@@ -687,7 +957,8 @@ void MainWindow::onLoadParamsClicked()
         this,
         QStringLiteral("Load Microscope Parameters"),
         lastDir,
-        QStringLiteral("JSON Files (*.json);;All Files (*)"));
+        QStringLiteral("Parameter Sources (*.json *.ome.tif *.ome.tiff);;JSON Files (*.json);;"
+                       "OME-TIFF Files (*.ome.tif *.ome.tiff);;All Files (*)"));
 
     if (filename.isEmpty())
         return;
@@ -740,6 +1011,51 @@ void MainWindow::onRemoveParamsFromListClicked()
     m_savedParamsManager->removeFile(files[selectedRow]);
 }
 
+void MainWindow::onBatchApplyClicked()
+{
+    auto dialog = new BatchApplyDialog(m_saveQueue.get(), m_savedParamsManager->getFiles(), this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+
+    connect(dialog, &BatchApplyDialog::jobQueued, this, [this](SaveJob *job) {
+        auto viewerClosed = closeViewerOnCommit(job);
+        const auto editsWhenQueued = m_metadataEdits;
+        connect(job, &SaveJob::finished, this, [this, job, viewerClosed, editsWhenQueued](bool success) {
+            if (!*viewerClosed)
+                return;
+
+            // Show the updated file again, or the original if it could not be written
+            const auto &request = job->request();
+            reopenAfterSave(
+                success && QFile::exists(request.destPath) ? request.destPath : request.sourcePath,
+                m_metadataEdits != editsWhenQueued);
+        });
+    });
+
+    // Offer the file that is currently open as a starting point
+    if (m_tiffImage->isOpen())
+        dialog->addFiles({m_tiffImage->filename()});
+
+    dialog->show();
+}
+
+void MainWindow::onCatalogClicked()
+{
+    auto dialog = new CatalogDialog(m_catalog.get(), m_catalogScanner.get(), this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    connect(dialog, &CatalogDialog::openFileRequested, this, &MainWindow::openFile);
+    dialog->show();
+}
+
+void MainWindow::recordInCatalog(const QString &path, const ImageMetadata *params)
+{
+    if (!m_catalog)
+        return;
+
+    const auto r = m_catalog->recordFile(path, params);
+    if (!r)
+        qWarning().noquote() << "Failed to add" << path << "to the catalog:" << r.error();
+}
+
 void MainWindow::updateSavedParamsList()
 {
     ui->listSavedParams->clear();
@@ -767,51 +1083,30 @@ void MainWindow::loadParametersFromFile(const QString &filePath)
         return;
     }
 
-    auto result = MetadataJson::loadFromFile(filePath);
+    const auto result = MetadataJson::loadParameters(filePath);
     if (!result) {
         QMessageBox::critical(
             this, QStringLiteral("Load Failed"), QStringLiteral("Failed to load parameters:\n%1").arg(result.error()));
         return;
     }
 
-    auto loadedMeta = result.value();
-
-    // Preserve the current image dimensions and name
+    // Dimensions and name are kept from the current image, but the user should know if channels differ
     const auto currentMeta = ui->imageMetaWidget->getMetadata();
-    loadedMeta.sizeX = currentMeta.sizeX;
-    loadedMeta.sizeY = currentMeta.sizeY;
-    loadedMeta.sizeZ = currentMeta.sizeZ;
-    loadedMeta.sizeC = currentMeta.sizeC;
-    loadedMeta.sizeT = currentMeta.sizeT;
-    loadedMeta.pixelType = currentMeta.pixelType;
-    loadedMeta.dataSizeBytes = currentMeta.dataSizeBytes;
-    loadedMeta.imageName = currentMeta.imageName;
-
-    // Adjust channels to match current image
-    if (loadedMeta.channels.size() != currentMeta.channels.size()) {
+    if (result->channels.size() != currentMeta.channels.size()) {
         QMessageBox::warning(
             this,
             QStringLiteral("Channel Count Mismatch"),
             QStringLiteral(
                 "The loaded parameters have %1 channel(s), but the current image has %2 channel(s).\n"
                 "Only the overlapping channels will be updated.")
-                .arg(loadedMeta.channels.size())
+                .arg(result->channels.size())
                 .arg(currentMeta.channels.size()));
-
-        // Resize to match current image
-        if (loadedMeta.channels.size() > currentMeta.channels.size()) {
-            loadedMeta.channels.resize(currentMeta.channels.size());
-        } else {
-            // Keep existing channel data for channels beyond what's loaded
-            size_t loadedSize = loadedMeta.channels.size();
-            loadedMeta.channels.resize(currentMeta.channels.size());
-            for (size_t i = loadedSize; i < currentMeta.channels.size(); ++i)
-                loadedMeta.channels[i] = currentMeta.channels[i];
-        }
     }
+    const auto loadedMeta = MetadataJson::applyParameters(result.value(), currentMeta);
 
-    // Apply loaded metadata
+    // Apply loaded metadata, which has not been saved to the image yet
     ui->imageMetaWidget->setMetadata(loadedMeta);
+    ui->imageMetaWidget->markModified();
 
     QFileInfo fileInfo(filePath);
     statusBar()->showMessage(QStringLiteral("Parameters loaded from: %1").arg(fileInfo.fileName()), 5000);
@@ -831,6 +1126,7 @@ void MainWindow::saveWindowState()
 
     settings.setValue("window/geometry", saveGeometry());
     settings.setValue("window/state", saveState());
+    settings.setValue("viewer/showPerformanceHud", ui->actionPerformanceHud->isChecked());
 
     settings.sync();
 }
@@ -850,6 +1146,8 @@ void MainWindow::restoreWindowState()
 
     // ensure the dock widget is never accidentally hidden
     ui->viewDockWidget->setVisible(true);
+
+    ui->actionPerformanceHud->setChecked(settings.value("viewer/showPerformanceHud", false).toBool());
 }
 
 QString MainWindow::getLastDirectory(const QString &key, const QString &defaultDir) const
@@ -880,6 +1178,36 @@ void MainWindow::setLastDirectory(const QString &key, const QString &filePath)
     }
 }
 
+void MainWindow::onRecordTraceToggled(bool enabled)
+{
+    if (enabled) {
+        PerfTrace::clear();
+        PerfTrace::setEnabled(true);
+        statusBar()->showMessage(QStringLiteral("Recording performance trace..."), 5000);
+        return;
+    }
+
+    PerfTrace::setEnabled(false);
+    const auto fileName = QFileDialog::getSaveFileName(
+        this,
+        QStringLiteral("Save Performance Trace"),
+        QDir(getLastDirectory("saveTrace", QDir::homePath())).filePath("omerewriter-trace.json"),
+        QStringLiteral("Chrome Trace Files (*.json);;All Files (*)"));
+    if (fileName.isEmpty())
+        return;
+    setLastDirectory("saveTrace", fileName);
+
+    const auto result = PerfTrace::exportChromeTrace(fileName);
+    if (!result) {
+        QMessageBox::critical(this, QStringLiteral("Failed to save trace"), result.error());
+        return;
+    }
+
+    statusBar()->showMessage(
+        QStringLiteral("Saved %1 trace events to %2 (open with ui.perfetto.dev)").arg(result.value()).arg(fileName),
+        8000);
+}
+
 void MainWindow::onAbout()
 {
     QMessageBox::about(
@@ -7,13 +7,16 @@
 #pragma once
 
 #include <QMainWindow>
-#include <QThread>
-#include <QProgressDialog>
 #include <memory>
 
+class Catalog;
+class CatalogScanner;
 class OMETiffImage;
 class SavedParamsManager;
+class SaveJob;
+class SaveQueue;
 struct ImageMetadata;
+struct SaveRequest;
 
 QT_BEGIN_NAMESPACE
 namespace Ui
@@ -30,10 +33,15 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow() override;
 
+protected:
+    void closeEvent(QCloseEvent *event) override;
+
 private slots:
     void onOpenFile();
+    void onOpenFolder();
     void onSaveFile();
     void onSaveFileAs();
+    void onEstimateSave();
     void quickSaveFile();
     void updateImage();
     void onSliderZChanged(int value);
@@ -41,22 +49,35 @@ private slots:
     void onSliderCChanged(int value);
     void onMetadataModified();
     void onInterleavedChannelsChanged(int count);
+    void onFrameBinningChanged();
+    void onPixelConversionChanged();
 
     void onSaveParamsClicked();
     void onLoadParamsClicked();
     void onQuickLoadParamsClicked();
     void onRemoveParamsFromListClicked();
+    void onBatchApplyClicked();
+    void onCatalogClicked();
 
+    void onRecordTraceToggled(bool enabled);
     void onAbout();
 
 private:
     bool openFile(const QString &filename);
+    bool openRawBinary(const QString &filename);
+    bool openFolder(const QString &dirPath, const QString &pattern);
+    ImageMetadata showOpenedImage(const QString &name);
     void resetSliderValues();
     void updateSliderRanges();
     void setNavigationEnabled(bool enabled);
     void updateContrastSliderRange(const ImageMetadata &metadata);
+    [[nodiscard]] SaveRequest currentFileRequest(bool quicksave) const;
     void saveCurrentFile(bool quicksave);
-    bool performSaveWithProgress(const QString &filename, const ImageMetadata &metadata);
+    void setRequestCompression(SaveRequest &request) const;
+    void startSaveJob(const SaveRequest &request, bool askToOpenResult);
+    std::shared_ptr<bool> closeViewerOnCommit(SaveJob *job);
+    bool reopenAfterSave(const QString &filename, bool keepEdits);
+    void recordInCatalog(const QString &path, const ImageMetadata *params);
     void updateSavedParamsList();
     void loadParametersFromFile(const QString &filePath);
 
@@ -70,6 +91,12 @@ private:
     Ui::MainWindow *ui;
     std::unique_ptr<OMETiffImage> m_tiffImage;
     std::unique_ptr<SavedParamsManager> m_savedParamsManager;
+    std::unique_ptr<SaveQueue> m_saveQueue;
+    std::unique_ptr<Catalog> m_catalog;
+    std::unique_ptr<CatalogScanner> m_catalogScanner;
+
+    // Number of metadata edits so far, to tell whether the widgets changed while a save was running
+    quint64 m_metadataEdits = 0;
 
     // Current position in the image stack
     int m_currentZ = 0;
@@ -155,4 +155,40 @@ std::expected<ImageMetadata, QString> loadFromFile(const QString &filename)
     return result;
 }
 
+std::expected<ImageMetadata, QString> loadParameters(const QString &filename)
+{
+    // Parameters can also be copied from an existing OME-TIFF, for which we only need to scan its header
+    if (OMETiffImage::hasOmeTiffExtension(filename))
+        return OMETiffImage::inspectFile(filename);
+    return loadFromFile(filename);
+}
+
+ImageMetadata applyParameters(const ImageMetadata &params, const ImageMetadata &image)
+{
+    auto result = params;
+
+    // Preserve the image dimensions and name
+    result.sizeX = image.sizeX;
+    result.sizeY = image.sizeY;
+    result.sizeZ = image.sizeZ;
+    result.sizeC = image.sizeC;
+    result.sizeT = image.sizeT;
+    result.pixelType = image.pixelType;
+    result.dataSizeBytes = image.dataSizeBytes;
+    result.imageName = image.imageName;
+
+    // Adjust channels to match the image
+    if (result.channels.size() > image.channels.size()) {
+        result.channels.resize(image.channels.size());
+    } else {
+        // Keep existing channel data for channels beyond what's loaded
+        const auto loadedSize = result.channels.size();
+        result.channels.resize(image.channels.size());
+        for (size_t i = loadedSize; i < image.channels.size(); ++i)
+            result.channels[i] = image.channels[i];
+    }
+
+    return result;
+}
+
 } // namespace MetadataJson
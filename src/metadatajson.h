@@ -43,4 +43,23 @@ std::expected<bool, QString> saveToFile(const ImageMetadata &metadata, const QSt
  */
 std::expected<ImageMetadata, QString> loadFromFile(const QString &filename);
 
+/**
+ * @brief Load a parameter set from a JSON file, or copy it from the header of an OME-TIFF
+ * @param filename Path to the JSON or OME-TIFF file
+ * @return ImageMetadata on success, error message on failure
+ */
+std::expected<ImageMetadata, QString> loadParameters(const QString &filename);
+
+/**
+ * @brief Apply a loaded parameter set to the metadata of an image
+ *
+ * Dimensions, pixel type and name are always kept from the image. If the channel
+ * counts differ, only the overlapping channels are taken from the parameter set.
+ *
+ * @param params The loaded parameter set
+ * @param image Current metadata of the image
+ * @return The metadata to write to the image
+ */
+ImageMetadata applyParameters(const ImageMetadata &params, const ImageMetadata &image);
+
 } // namespace MetadataJson
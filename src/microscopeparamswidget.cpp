@@ -275,6 +275,12 @@ void MicroscopeParamsWidget::resetModified()
     m_modified = false;
 }
 
+void MicroscopeParamsWidget::markModified()
+{
+    m_modified = true;
+    emit metadataModified();
+}
+
 void MicroscopeParamsWidget::onChannelSelectionChanged(int row)
 {
     if (m_updatingUI || row < 0)
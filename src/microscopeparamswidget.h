@@ -50,6 +50,11 @@ public:
      */
     void resetModified();
 
+    /**
+     * @brief Mark the metadata as modified, e.g. after restoring changes that were not saved yet
+     */
+    void markModified();
+
 signals:
     /**
      * @brief Emitted when user modifies any metadata field
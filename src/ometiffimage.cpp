@@ -6,16 +6,38 @@
 
 #include "ometiffimage.h"
 
+#include <QCache>
+#include <QCollator>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QDir>
+#include <QFile>
 #include <QFileInfo>
+#include <QMap>
+#include <QRegularExpression>
+#include <QSysInfo>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <algorithm>
+#include <array>
 #include <cstring>
+#include <deque>
+#include <limits>
+#include <numeric>
+#include <tuple>
+#include <set>
+#include <stdexcept>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <type_traits>
+#include <unordered_map>
 
 #include <ome/files/in/OMETIFFReader.h>
 #include <ome/files/in/TIFFReader.h>
 #include <ome/files/out/OMETIFFWriter.h>
 #include <ome/files/PixelBuffer.h>
+#include <ome/files/PixelProperties.h>
 #include <ome/files/VariantPixelBuffer.h>
 #include <ome/files/CoreMetadata.h>
 #include <ome/files/MetadataTools.h>
@@ -25,15 +47,55 @@
 #include <ome/files/tiff/Tags.h>
 #include <ome/xml/meta/Convert.h>
 #include <ome/xml/meta/OMEXMLMetadata.h>
+#include <ome/xml/meta/OMEXMLMetadataRoot.h>
+#include <ome/xml/model/Channel.h>
+#include <ome/xml/model/Image.h>
+#include <ome/xml/model/Instrument.h>
+#include <ome/xml/model/Objective.h>
+#include <ome/xml/model/ObjectiveSettings.h>
+#include <ome/xml/model/Pixels.h>
 #include <ome/xml/model/primitives/Quantity.h>
 
 #include "ome/xml/meta/DummyMetadata.h"
 
+#include "deflatecodec.h"
+
+#include "omexmlscanner.h"
+#include "perftrace.h"
+#include "tiffdeduplicator.h"
+#include "tiffstripreader.h"
+
 using ome::files::dimension_size_type;
 using ome::files::PixelBuffer;
 using ome::files::VariantPixelBuffer;
 typedef ome::xml::model::enums::PixelType PT;
 
+// Maximum number of files of a multi-file series that are kept open at the same time
+static constexpr size_t MaxOpenSeriesFiles = 32;
+
+// Maximum number of single-plane files of a folder source that are read at the same time
+static constexpr int MaxParallelFileReads = 16;
+
+static size_t bytesPerPixel(PT pixelType)
+{
+    switch (pixelType) {
+    case PT::UINT16:
+    case PT::INT16:
+        return 2;
+    case PT::UINT32:
+    case PT::INT32:
+    case PT::FLOAT:
+        return 4;
+    case PT::DOUBLE:
+    case PT::COMPLEXFLOAT:
+        return 8;
+    case PT::COMPLEXDOUBLE:
+        return 16;
+    default:
+        return 1;
+    }
+}
+
 /**
  * Ensure the OME-XML stored in the first IFD's ImageDescription tag of a freshly
  * written OME-TIFF starts with an XML declaration.
@@ -72,6 +134,349 @@ static void ensureXmlDeclaration(const std::string &path)
     tiff->writeDirectory(ifd);
 }
 
+using PlaneFileResult = std::expected<std::shared_ptr<VariantPixelBuffer>, QString>;
+
+/**
+ * Read the first plane of a TIFF file with a reader of its own, so that
+ * multiple files can be read in parallel.
+ */
+static PlaneFileResult readSinglePlaneFile(const QString &path)
+{
+    try {
+        ome::files::in::TIFFReader reader;
+        reader.setId(path.toStdString());
+        auto buf = std::make_shared<VariantPixelBuffer>();
+        reader.openBytes(0, *buf);
+        reader.close();
+        return buf;
+    } catch (const std::exception &e) {
+        return std::unexpected(QStringLiteral("Failed to read %1: %2").arg(path, e.what()));
+    }
+}
+
+/**
+ * Type that frames are summed up in, wide enough to not overflow for any realistic number of frames.
+ */
+template<typename T>
+using AccumulatorType = std::conditional_t<
+    std::is_floating_point_v<T>,
+    double,
+    std::conditional_t<(sizeof(T) < 4), std::conditional_t<std::is_signed_v<T>, int32_t, uint32_t>, int64_t>>;
+
+// The loops below are kept free of branches and aliasing, so that the compiler
+// turns them into widening SIMD adds & divisions.
+
+template<typename T, typename Acc>
+static void accumulatePlane(const T *__restrict src, Acc *__restrict acc, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        acc[i] += static_cast<Acc>(src[i]);
+}
+
+template<typename Acc, typename Out>
+static void storeAverage(const Acc *__restrict acc, Out *__restrict dst, size_t count, Acc frames)
+{
+    if constexpr (std::is_floating_point_v<Acc>) {
+        for (size_t i = 0; i < count; ++i)
+            dst[i] = static_cast<Out>(acc[i] / frames);
+    } else if constexpr (std::is_unsigned_v<Acc>) {
+        const Acc half = frames / 2;
+        for (size_t i = 0; i < count; ++i)
+            dst[i] = static_cast<Out>((acc[i] + half) / frames);
+    } else {
+        // integer division truncates towards zero, so we round half away from zero
+        const Acc half = frames / 2;
+        for (size_t i = 0; i < count; ++i)
+            dst[i] = static_cast<Out>((acc[i] < 0 ? acc[i] - half : acc[i] + half) / frames);
+    }
+}
+
+template<typename Acc, typename Out>
+static void storeSum(const Acc *__restrict acc, Out *__restrict dst, size_t count)
+{
+    if constexpr (std::is_floating_point_v<Out>) {
+        for (size_t i = 0; i < count; ++i)
+            dst[i] = static_cast<Out>(acc[i]);
+    } else {
+        // only 32-bit sums can exceed the output type, they saturate
+        constexpr auto lowest = static_cast<Acc>(std::numeric_limits<Out>::lowest());
+        constexpr auto highest = static_cast<Acc>(std::numeric_limits<Out>::max());
+        for (size_t i = 0; i < count; ++i)
+            dst[i] = static_cast<Out>(std::clamp(acc[i], lowest, highest));
+    }
+}
+
+/**
+ * Get the pixel type frames of the given type are written as after binning.
+ */
+static PT binnedPixelType(PT pixelType, FrameBinMode mode)
+{
+    if (mode == FrameBinMode::Average)
+        return pixelType;
+
+    switch (pixelType) {
+    case PT::INT8:
+        return PT::INT16;
+    case PT::UINT8:
+        return PT::UINT16;
+    case PT::INT16:
+        return PT::INT32;
+    case PT::UINT16:
+        return PT::UINT32;
+    default:
+        return pixelType;
+    }
+}
+
+/**
+ * Check whether the samples of a pixel type are plain real numbers, as the binning & conversion kernels expect.
+ */
+static bool isRealPixelType(PT pixelType)
+{
+    switch (pixelType) {
+    case PT::INT8:
+    case PT::UINT8:
+    case PT::INT16:
+    case PT::UINT16:
+    case PT::INT32:
+    case PT::UINT32:
+    case PT::FLOAT:
+    case PT::DOUBLE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+template<PT::enum_value InType, PT::enum_value OutType>
+static std::expected<bool, QString> binPlanesAs(
+    const std::function<PlaneFileResult()> &nextPlane,
+    ome::files::dimension_size_type frames,
+    FrameBinMode mode,
+    ome::files::dimension_size_type sizeX,
+    ome::files::dimension_size_type sizeY,
+    VariantPixelBuffer &out)
+{
+    using In = typename ome::files::PixelProperties<InType>::std_type;
+    using Out = typename ome::files::PixelProperties<OutType>::std_type;
+    using Acc = AccumulatorType<In>;
+
+    const auto count = static_cast<size_t>(sizeX * sizeY);
+    std::vector<Acc> acc(count, Acc(0));
+    for (ome::files::dimension_size_type f = 0; f < frames; ++f) {
+        const auto plane = nextPlane();
+        if (!plane)
+            return std::unexpected(plane.error());
+        const auto &pixels = std::get<std::shared_ptr<PixelBuffer<In>>>(plane.value()->vbuffer());
+        accumulatePlane(pixels->data(), acc.data(), count);
+    }
+
+    std::array<VariantPixelBuffer::size_type, ome::files::PixelBufferBase::dimensions> extents;
+    extents.fill(1);
+    extents[ome::files::DIM_SPATIAL_X] = sizeX;
+    extents[ome::files::DIM_SPATIAL_Y] = sizeY;
+    out.setBuffer(extents, PT(OutType));
+    auto dst = std::get<std::shared_ptr<PixelBuffer<Out>>>(out.vbuffer())->data();
+
+    if (mode == FrameBinMode::Average)
+        storeAverage(acc.data(), dst, count, static_cast<Acc>(frames));
+    else
+        storeSum(acc.data(), dst, count);
+    return true;
+}
+
+template<PT::enum_value InType, PT::enum_value SumType>
+static std::expected<bool, QString> binPlanesOf(
+    const std::function<PlaneFileResult()> &nextPlane,
+    ome::files::dimension_size_type frames,
+    FrameBinMode mode,
+    ome::files::dimension_size_type sizeX,
+    ome::files::dimension_size_type sizeY,
+    VariantPixelBuffer &out)
+{
+    if (mode == FrameBinMode::Sum)
+        return binPlanesAs<InType, SumType>(nextPlane, frames, mode, sizeX, sizeY, out);
+    return binPlanesAs<InType, InType>(nextPlane, frames, mode, sizeX, sizeY, out);
+}
+
+/**
+ * Combine the next @p frames planes into one, see OMETiffImage::setFrameBinning().
+ */
+static std::expected<bool, QString> binPlanes(
+    PT pixelType,
+    const std::function<PlaneFileResult()> &nextPlane,
+    ome::files::dimension_size_type frames,
+    FrameBinMode mode,
+    ome::files::dimension_size_type sizeX,
+    ome::files::dimension_size_type sizeY,
+    VariantPixelBuffer &out)
+{
+    switch (pixelType) {
+    case PT::INT8:
+        return binPlanesOf<PT::INT8, PT::INT16>(nextPlane, frames, mode, sizeX, sizeY, out);
+    case PT::UINT8:
+        return binPlanesOf<PT::UINT8, PT::UINT16>(nextPlane, frames, mode, sizeX, sizeY, out);
+    case PT::INT16:
+        return binPlanesOf<PT::INT16, PT::INT32>(nextPlane, frames, mode, sizeX, sizeY, out);
+    case PT::UINT16:
+        return binPlanesOf<PT::UINT16, PT::UINT32>(nextPlane, frames, mode, sizeX, sizeY, out);
+    case PT::INT32:
+        return binPlanesOf<PT::INT32, PT::INT32>(nextPlane, frames, mode, sizeX, sizeY, out);
+    case PT::UINT32:
+        return binPlanesOf<PT::UINT32, PT::UINT32>(nextPlane, frames, mode, sizeX, sizeY, out);
+    case PT::FLOAT:
+        return binPlanesOf<PT::FLOAT, PT::FLOAT>(nextPlane, frames, mode, sizeX, sizeY, out);
+    case PT::DOUBLE:
+        return binPlanesOf<PT::DOUBLE, PT::DOUBLE>(nextPlane, frames, mode, sizeX, sizeY, out);
+    default:
+        return std::unexpected(QStringLiteral("Frames of pixel type %1 can not be combined")
+                                   .arg(QString::fromStdString(std::string(pixelType))));
+    }
+}
+
+/**
+ * Get the libtiff name of a compression codec, as ome-files expects it.
+ */
+static std::string tiffCodecName(TiffCompression compression)
+{
+    switch (compression) {
+    case TiffCompression::Zstd:
+        return "ZSTD";
+    case TiffCompression::Deflate:
+        break;
+    }
+
+    // A warning is emitted for "Deflate", recommending to use "AdobeDeflate" instead for wider support,
+    // and claiming "Deflate" was legacy. So we just use "AdobeDeflate", it's the same algorithm.
+    return "AdobeDeflate";
+}
+
+/**
+ * Value type of a pixel buffer alternative of VariantPixelBuffer.
+ */
+template<typename T>
+struct BufferValueType;
+
+template<typename T>
+struct BufferValueType<std::shared_ptr<PixelBuffer<T>>> {
+    using type = T;
+};
+
+template<typename T>
+static void updateValueRange(const T *__restrict src, size_t count, double &minValue, double &maxValue)
+{
+    // NaN compares false, so std::min & std::max in this argument order skip it
+    auto lo = std::numeric_limits<T>::max();
+    auto hi = std::numeric_limits<T>::lowest();
+    for (size_t i = 0; i < count; ++i) {
+        lo = std::min(src[i], lo);
+        hi = std::max(src[i], hi);
+    }
+    minValue = std::min(minValue, static_cast<double>(lo));
+    maxValue = std::max(maxValue, static_cast<double>(hi));
+}
+
+template<typename In, typename Out>
+static void scalePixels(const In *__restrict src, Out *__restrict dst, size_t count, double offset, double scale)
+{
+    constexpr auto highest = static_cast<double>(std::numeric_limits<Out>::max());
+    for (size_t i = 0; i < count; ++i) {
+        auto v = (static_cast<double>(src[i]) - offset) * scale;
+        if constexpr (std::is_floating_point_v<In>)
+            v = v == v ? v : 0.0;
+        dst[i] = static_cast<Out>(std::clamp(v, 0.0, highest) + 0.5);
+    }
+}
+
+/**
+ * Get the pixel type a conversion writes.
+ */
+static PT convertedPixelType(PT pixelType, PixelConversion conversion)
+{
+    switch (conversion) {
+    case PixelConversion::ScaleToUInt16:
+    case PixelConversion::OffsetToUInt16:
+        return PT::UINT16;
+    case PixelConversion::ScaleToUInt8:
+        return PT::UINT8;
+    case PixelConversion::None:
+        break;
+    }
+
+    return pixelType;
+}
+
+/**
+ * Offset & scale that map a value range onto the pixel type of a conversion.
+ */
+static std::pair<double, double> conversionMapping(
+    PixelConversion conversion,
+    PT outPixelType,
+    double minValue,
+    double maxValue)
+{
+    if (conversion == PixelConversion::OffsetToUInt16)
+        return {std::min(minValue, 0.0), 1.0};
+
+    const auto highest = outPixelType == PT::UINT8 ? 255.0 : 65535.0;
+    return {minValue, maxValue > minValue ? highest / (maxValue - minValue) : 1.0};
+}
+
+/**
+ * Widen the minimum & maximum sample of a plane buffer to include its samples.
+ */
+static void updateValueRange(VariantPixelBuffer &buf, double &minValue, double &maxValue)
+{
+    std::visit(
+        [&](auto &pixels) {
+            using T = typename BufferValueType<std::decay_t<decltype(pixels)>>::type;
+            if constexpr (std::is_arithmetic_v<T> && !std::is_same_v<T, bool>)
+                updateValueRange(pixels->data(), pixels->num_elements(), minValue, maxValue);
+            else
+                throw std::logic_error("Value range of a non-real pixel type requested");
+        },
+        buf.vbuffer());
+}
+
+/**
+ * Write (sample - offset) * scale of every sample of a grayscale plane as @p outType, rounded and clamped.
+ */
+static void convertPixels(
+    VariantPixelBuffer &in,
+    PT outType,
+    double offset,
+    double scale,
+    ome::files::dimension_size_type sizeX,
+    ome::files::dimension_size_type sizeY,
+    VariantPixelBuffer &out)
+{
+    std::array<VariantPixelBuffer::size_type, ome::files::PixelBufferBase::dimensions> extents;
+    extents.fill(1);
+    extents[ome::files::DIM_SPATIAL_X] = sizeX;
+    extents[ome::files::DIM_SPATIAL_Y] = sizeY;
+    out.setBuffer(extents, outType);
+
+    const auto count = static_cast<size_t>(sizeX * sizeY);
+    std::visit(
+        [&](auto &pixels) {
+            using In = typename BufferValueType<std::decay_t<decltype(pixels)>>::type;
+            if constexpr (std::is_arithmetic_v<In> && !std::is_same_v<In, bool>) {
+                if (outType == PT::UINT8) {
+                    using Out = ome::files::PixelProperties<PT::UINT8>::std_type;
+                    const auto &dst = std::get<std::shared_ptr<PixelBuffer<Out>>>(out.vbuffer());
+                    scalePixels(pixels->data(), dst->data(), count, offset, scale);
+                } else {
+                    using Out = ome::files::PixelProperties<PT::UINT16>::std_type;
+                    const auto &dst = std::get<std::shared_ptr<PixelBuffer<Out>>>(out.vbuffer());
+                    scalePixels(pixels->data(), dst->data(), count, offset, scale);
+                }
+            } else {
+                throw std::logic_error("Conversion of a non-real pixel type requested");
+            }
+        },
+        in.vbuffer());
+}
+
 class OMETiffImage::Private
 {
 public:
@@ -86,6 +491,15 @@ public:
     // e.g., if interleavedChannels=2 and imageCount=10, we have 5 Z positions with 2 channels each
     dimension_size_type interleavedChannels = 1;
 
+    // Number of consecutive frames per slice that are combined into one plane on save
+    dimension_size_type binFrames = 1;
+    FrameBinMode binMode = FrameBinMode::Average;
+
+    // Pixel type conversion applied on save
+    PixelConversion pixelConversion = PixelConversion::None;
+    TiffCompression compression = TiffCompression::Deflate;
+    bool deduplicatePlanes = false;
+
     // Dimension sizes (raw from reader)
     dimension_size_type rawSizeX = 0;
     dimension_size_type rawSizeY = 0;
@@ -105,6 +519,263 @@ public:
     dimension_size_type imageCount = 0;
     dimension_size_type rgbChannelCount = 0;
 
+    // Recently read planes by raw plane index, the cost of an entry is its size in bytes
+    QCache<dimension_size_type, RawImage> planeCache{0};
+    PlaneReadStatistics readStats;
+
+    /**
+     * @brief A file of a multi-file series, and the range of raw planes it holds.
+     */
+    struct SeriesFile {
+        QString path;
+        dimension_size_type firstPlane = 0;
+        dimension_size_type planeCount = 0;
+        std::shared_ptr<ome::files::FormatReader> reader;
+    };
+
+    // Files of a multi-file series, empty if a single file is open.
+    // The reader of the first file is also used for metadata.
+    std::vector<SeriesFile> seriesFiles;
+
+    // Indices of series files that have an open reader, the most recently used one last
+    std::deque<size_t> openSeriesFiles;
+
+    // Decodes the strips of a single file with DeflateCodec, bypassing libtiff's zlib path.
+    // Only set up if libdeflate is in use and plane N is stored in directory N of the file.
+    std::unique_ptr<TiffStripReader> stripReader;
+
+    // Headerless binary file mapped into memory, read without any ome-files reader
+    std::unique_ptr<QFile> rawBinaryFile;
+    uchar *rawBinaryData = nullptr;
+    RawBinaryLayout rawBinaryLayout;
+
+    // Folder sources hold one plane per file, sorted into Z/C/T by a file name pattern
+    bool isFolder = false;
+    QString folderPattern;
+    dimension_size_type folderSizeZ = 0;
+    dimension_size_type folderSizeC = 0;
+    dimension_size_type folderSizeT = 0;
+
+    void touchSeriesFile(size_t index)
+    {
+        std::erase(openSeriesFiles, index);
+        openSeriesFiles.push_back(index);
+
+        while (openSeriesFiles.size() > MaxOpenSeriesFiles) {
+            auto &file = seriesFiles[openSeriesFiles.front()];
+            openSeriesFiles.pop_front();
+            if (file.reader != reader)
+                file.reader->close();
+            file.reader.reset();
+        }
+    }
+
+    [[nodiscard]] bool isOpen() const
+    {
+        return reader || rawBinaryData;
+    }
+
+    /**
+     * @brief Check whether the current interpretation allows combining the given number of frames.
+     */
+    [[nodiscard]] std::expected<bool, QString> checkFrameBinning(dimension_size_type frames) const
+    {
+        if (frames <= 1)
+            return true;
+        if (isOmeTiff)
+            return std::unexpected(QStringLiteral("Frames of OME-TIFF files can not be combined."));
+        if (rgbChannelCount > 1)
+            return std::unexpected(QStringLiteral("Frames can only be combined for grayscale images."));
+        if (!isRealPixelType(cachedPixelType))
+            return std::unexpected(QStringLiteral("Frames of pixel type %1 can not be combined.")
+                                       .arg(QString::fromStdString(std::string(cachedPixelType))));
+
+        const auto frameCount = sizeZ > 1 ? sizeZ : sizeT;
+        if (frameCount % frames != 0)
+            return std::unexpected(QStringLiteral("%1 frames per slice do not divide evenly into %2 %3 positions")
+                                       .arg(frames)
+                                       .arg(frameCount)
+                                       .arg(sizeZ > 1 ? QStringLiteral("Z") : QStringLiteral("T")));
+        return true;
+    }
+
+    /**
+     * @brief Check whether the current image can be saved with the given pixel type conversion.
+     */
+    [[nodiscard]] std::expected<bool, QString> checkPixelConversion(PixelConversion conversion) const
+    {
+        if (conversion == PixelConversion::None)
+            return true;
+        if (rgbChannelCount > 1)
+            return std::unexpected(QStringLiteral("The pixel type can only be converted for grayscale images."));
+        if (!isRealPixelType(cachedPixelType))
+            return std::unexpected(QStringLiteral("Pixel type %1 can not be converted.")
+                                       .arg(QString::fromStdString(std::string(cachedPixelType))));
+        return true;
+    }
+
+    /**
+     * @brief Copy a plane out of the mapped binary file, converting it to native byte order.
+     */
+    void readRawBinaryPlane(dimension_size_type plane, VariantPixelBuffer &buf) const
+    {
+        if (plane >= rawImageCount)
+            throw std::out_of_range("Plane index out of range for raw binary file");
+
+        const auto elementSize = bytesPerPixel(cachedPixelType);
+        const auto planeBytes = sizeX * sizeY * elementSize;
+        const auto src = rawBinaryData + rawBinaryLayout.headerBytes + plane * planeBytes;
+        const bool swapBytes = rawBinaryLayout.bigEndian != (QSysInfo::ByteOrder == QSysInfo::BigEndian);
+
+        std::array<VariantPixelBuffer::size_type, ome::files::PixelBufferBase::dimensions> extents;
+        extents.fill(1);
+        extents[ome::files::DIM_SPATIAL_X] = sizeX;
+        extents[ome::files::DIM_SPATIAL_Y] = sizeY;
+        buf.setBuffer(extents, cachedPixelType);
+
+        std::visit(
+            [&](auto &pixels) {
+                if (!pixels)
+                    return;
+                auto dst = reinterpret_cast<unsigned char *>(pixels->data());
+                std::memcpy(dst, src, planeBytes);
+                if (swapBytes && elementSize > 1) {
+                    for (size_t i = 0; i < planeBytes; i += elementSize)
+                        std::reverse(dst + i, dst + i + elementSize);
+                }
+            },
+            buf.vbuffer());
+    }
+
+    /**
+     * @brief Check whether plane N of the open OME-TIFF is stored in directory N of its only file.
+     */
+    [[nodiscard]] bool omePlanesMatchDirectories() const
+    {
+        auto meta = std::dynamic_pointer_cast<ome::xml::meta::OMEXMLMetadata>(reader->getMetadataStore());
+        if (!meta || reader->getUsedFiles().size() != 1)
+            return false;
+
+        // unset TiffData attributes throw, and have defaults in the OME schema
+        const auto valueOr = [](const auto &getter, dimension_size_type fallback) -> dimension_size_type {
+            try {
+                return static_cast<dimension_size_type>(getter());
+            } catch (const std::exception &) {
+                return fallback;
+            }
+        };
+
+        try {
+            const auto count = meta->getTiffDataCount(series);
+            dimension_size_type planes = 0;
+            for (decltype(count) i = 0; i < count; ++i) {
+                const auto ifd = valueOr([&] { return meta->getTiffDataIFD(series, i); }, 0);
+                const auto z = valueOr([&] { return meta->getTiffDataFirstZ(series, i); }, 0);
+                const auto c = valueOr([&] { return meta->getTiffDataFirstC(series, i); }, 0);
+                const auto t = valueOr([&] { return meta->getTiffDataFirstT(series, i); }, 0);
+                if (ifd != reader->getIndex(z, c, t))
+                    return false;
+                const auto defaultPlanes = count == 1 ? rawImageCount : 1;
+                planes += valueOr([&] { return meta->getTiffDataPlaneCount(series, i); }, defaultPlanes);
+            }
+            return count > 0 && planes == rawImageCount;
+        } catch (const std::exception &) {
+            return false;
+        }
+    }
+
+    /**
+     * @brief Decode planes of the open file with our own strip reader, if it can handle them.
+     */
+    void setupStripReader()
+    {
+        stripReader.reset();
+        if (DeflateCodec::backend() != DeflateCodec::Backend::Libdeflate || !reader || !seriesFiles.empty()
+            || rawRGBChannelCount > 1 || reader->getSeriesCount() != 1)
+            return;
+        if (isOmeTiff && !omePlanesMatchDirectories())
+            return;
+
+        auto strips = std::make_unique<TiffStripReader>(currentFilename);
+        auto r = strips->open();
+        if (r && strips->directoryCount() != rawImageCount)
+            r = std::unexpected(QStringLiteral("Directory count does not match the number of planes"));
+        if (r)
+            r = strips->directory(0).transform([](const auto &) {
+                return true;
+            });
+        if (!r) {
+            qDebug().noquote() << "Decoding planes with libtiff:" << r.error();
+            return;
+        }
+
+        stripReader = std::move(strips);
+    }
+
+    /**
+     * @brief Decode a plane with the strip reader.
+     * @return false if the plane has to be read with ome-files instead.
+     */
+    bool readStripPlane(dimension_size_type plane, VariantPixelBuffer &buf)
+    {
+        std::array<VariantPixelBuffer::size_type, ome::files::PixelBufferBase::dimensions> extents;
+        extents.fill(1);
+        extents[ome::files::DIM_SPATIAL_X] = sizeX;
+        extents[ome::files::DIM_SPATIAL_Y] = sizeY;
+        buf.setBuffer(extents, cachedPixelType);
+
+        std::expected<bool, QString> r = std::unexpected(QStringLiteral("No pixel buffer"));
+        std::visit(
+            [&](auto &pixels) {
+                if (pixels)
+                    r = stripReader->readDirectory(
+                        plane, pixels->data(), pixels->num_elements() * sizeof(*pixels->data()));
+            },
+            buf.vbuffer());
+        if (r)
+            return true;
+
+        // the file is stored in a way we can not decode, don't try again for every plane
+        qDebug().noquote() << "Decoding planes with libtiff:" << r.error();
+        stripReader.reset();
+        return false;
+    }
+
+    /**
+     * @brief Read a plane by its raw index, from whichever file of a series holds it.
+     */
+    void readRawPlane(dimension_size_type plane, VariantPixelBuffer &buf)
+    {
+        if (rawBinaryData) {
+            readRawBinaryPlane(plane, buf);
+            return;
+        }
+
+        if (seriesFiles.empty()) {
+            if (stripReader && series == 0 && readStripPlane(plane, buf))
+                return;
+            reader->openBytes(plane, buf);
+            return;
+        }
+
+        auto it = std::upper_bound(
+            seriesFiles.begin(), seriesFiles.end(), plane, [](dimension_size_type p, const SeriesFile &file) {
+                return p < file.firstPlane;
+            });
+        if (it == seriesFiles.begin() || plane >= std::prev(it)->firstPlane + std::prev(it)->planeCount)
+            throw std::out_of_range("Plane index out of range for multi-file series");
+        auto &file = *std::prev(it);
+
+        if (!file.reader) {
+            auto fileReader = std::make_shared<ome::files::in::TIFFReader>();
+            fileReader->setId(file.path.toStdString());
+            file.reader = fileReader;
+        }
+        touchSeriesFile(static_cast<size_t>(std::distance(seriesFiles.begin(), it) - 1));
+
+        file.reader->openBytes(plane - file.firstPlane, buf);
+    }
+
     void updateCachedDimensions()
     {
         if (!reader)
@@ -125,6 +796,18 @@ public:
 
         reader->setSeries(oldSeries);
 
+        // the planes of a multi-file series continue across files
+        if (!seriesFiles.empty()) {
+            rawImageCount = seriesFiles.back().firstPlane + seriesFiles.back().planeCount;
+            rawSizeZ = rawImageCount / std::max<dimension_size_type>(rawSizeC, 1);
+            rawSizeT = 1;
+        }
+        if (isFolder) {
+            rawSizeZ = folderSizeZ;
+            rawSizeC = folderSizeC;
+            rawSizeT = folderSizeT;
+        }
+
         applyInterleavingInterpretation();
     }
 
@@ -180,6 +863,10 @@ public:
             return z * interleavedChannels + c;
         }
 
+        // The reader of the first file only knows about its own planes, raw binaries have no reader
+        if (!seriesFiles.empty() || !reader)
+            return z + sizeZ * (c + sizeC * t);
+
         // For OME-TIFF or non-interleaved, use the reader's native indexing
         dimension_size_type oldSeries = reader->getSeries();
         reader->setSeries(series);
@@ -188,6 +875,48 @@ public:
         reader->setSeries(oldSeries);
         return index;
     }
+
+    /**
+     * @brief Raw planes to read, in the order they are written to the output.
+     *
+     * When frames are binned, every run of binFrames entries forms one output plane.
+     */
+    [[nodiscard]] std::vector<dimension_size_type> outputPlaneOrder() const
+    {
+        std::vector<dimension_size_type> planeOrder;
+        if (binFrames > 1) {
+            // Frames of a slice are consecutive Z positions, or time points for images without Z axis
+            const bool binZ = sizeZ > 1;
+            const auto outSizeZ = binZ ? sizeZ / binFrames : sizeZ;
+            const auto outSizeT = binZ ? sizeT : sizeT / binFrames;
+            planeOrder.reserve(sizeT * sizeC * sizeZ);
+            for (dimension_size_type t = 0; t < outSizeT; ++t) {
+                for (dimension_size_type c = 0; c < sizeC; ++c) {
+                    for (dimension_size_type z = 0; z < outSizeZ; ++z) {
+                        for (dimension_size_type f = 0; f < binFrames; ++f)
+                            planeOrder.push_back(
+                                binZ ? getPlaneIndex(z * binFrames + f, c, t) : getPlaneIndex(z, c, t * binFrames + f));
+                    }
+                }
+            }
+        } else if (!isOmeTiff && interleavedChannels > 1) {
+            // For interleaved raw TIFFs: write planes in the correct order for OME-TIFF
+            // OME-TIFF expects planes ordered by dimension order (XYZCT means Z varies fastest, then C, then T)
+            planeOrder.reserve(sizeT * sizeC * sizeZ);
+            for (dimension_size_type t = 0; t < sizeT; ++t) {
+                for (dimension_size_type c = 0; c < sizeC; ++c) {
+                    for (dimension_size_type z = 0; z < sizeZ; ++z)
+                        planeOrder.push_back(getPlaneIndex(z, c, t));
+                }
+            }
+        } else {
+            // For OME-TIFF or non-interleaved: copy planes directly
+            planeOrder.resize(seriesFiles.empty() && reader ? reader->getImageCount() : rawImageCount);
+            std::iota(planeOrder.begin(), planeOrder.end(), 0);
+        }
+
+        return planeOrder;
+    }
 };
 
 OMETiffImage::OMETiffImage(QObject *parent)
@@ -203,6 +932,7 @@ OMETiffImage::~OMETiffImage()
 
 bool OMETiffImage::open(const QString &filename)
 {
+    PERF_TRACE_SCOPE("OMETiffImage::open", "io");
     close();
 
     QFileInfo fileInfo(filename);
@@ -212,7 +942,7 @@ bool OMETiffImage::open(const QString &filename)
     }
 
     try {
-        if (filename.endsWith(".ome.tiff", Qt::CaseInsensitive) || filename.endsWith(".ome.tif", Qt::CaseInsensitive)) {
+        if (hasOmeTiffExtension(filename)) {
             auto omeReader = std::make_shared<ome::files::in::OMETIFFReader>();
 
             // Create an OMEXMLMetadata store for the reader to populate
@@ -233,6 +963,7 @@ bool OMETiffImage::open(const QString &filename)
         d->series = 0;
         d->resolution = 0;
         d->updateCachedDimensions();
+        d->setupStripReader();
 
         qDebug() << "Opened OME-TIFF:" << filename;
         qDebug().nospace() << "  Dimensions: X=" << d->sizeX << "Y=" << d->sizeY << "Z=" << d->sizeZ << "T=" << d->sizeT
@@ -248,6 +979,390 @@ bool OMETiffImage::open(const QString &filename)
     }
 }
 
+bool OMETiffImage::openSeries(const QStringList &filenames)
+{
+    if (filenames.size() == 1)
+        return open(filenames.first());
+    if (filenames.isEmpty())
+        return false;
+
+    PERF_TRACE_SCOPE("OMETiffImage::openSeries", "io");
+    close();
+
+    try {
+        dimension_size_type firstPlane = 0;
+        for (const auto &filename : filenames) {
+            if (hasOmeTiffExtension(filename)) {
+                qWarning().noquote() << "OME-TIFF files can not be opened as part of a series:" << filename;
+                close();
+                return false;
+            }
+
+            // reading the IFDs of every file once gives us the plane index of the whole series
+            auto reader = std::make_shared<ome::files::in::TIFFReader>();
+            reader->setId(filename.toStdString());
+            if (!d->reader) {
+                d->reader = reader;
+            } else if (
+                reader->getSizeX() != d->reader->getSizeX() || reader->getSizeY() != d->reader->getSizeY()
+                || reader->getPixelType() != d->reader->getPixelType()
+                || reader->getRGBChannelCount(0) != d->reader->getRGBChannelCount(0)) {
+                qWarning().noquote() << "Plane size or pixel type of" << filename
+                                     << "does not match the first file of the series";
+                close();
+                return false;
+            }
+
+            Private::SeriesFile file;
+            file.path = filename;
+            file.firstPlane = firstPlane;
+            file.planeCount = reader->getImageCount();
+            file.reader = reader;
+            firstPlane += file.planeCount;
+
+            d->seriesFiles.push_back(file);
+            d->touchSeriesFile(d->seriesFiles.size() - 1);
+        }
+
+        d->isOmeTiff = false;
+        d->currentFilename = filenames.first();
+        d->series = 0;
+        d->resolution = 0;
+        d->updateCachedDimensions();
+
+        qDebug().noquote() << "Opened series of" << filenames.size() << "files starting with" << filenames.first();
+        qDebug().nospace() << "  Dimensions: X=" << d->sizeX << "Y=" << d->sizeY << "Z=" << d->sizeZ << "T=" << d->sizeT
+                           << "C=" << d->sizeC;
+        qDebug() << "  Image count:" << d->imageCount;
+
+        return true;
+    } catch (const std::exception &e) {
+        qWarning().noquote() << "Failed to open TIFF series:" << e.what();
+        close();
+        return false;
+    }
+}
+
+bool OMETiffImage::openFolder(const QString &dirPath, const QString &pattern)
+{
+    PERF_TRACE_SCOPE("OMETiffImage::openFolder", "io");
+    close();
+
+    const QRegularExpression re(
+        QRegularExpression::anchoredPattern(pattern.isEmpty() ? QStringLiteral(".+") : pattern),
+        QRegularExpression::CaseInsensitiveOption);
+    if (!re.isValid()) {
+        qWarning().noquote() << "Invalid file name pattern:" << re.errorString();
+        return false;
+    }
+    const auto groups = re.namedCaptureGroups();
+    const bool hasZ = groups.contains(QStringLiteral("z"));
+    const bool hasC = groups.contains(QStringLiteral("c"));
+    const bool hasT = groups.contains(QStringLiteral("t"));
+
+    const QDir dir(dirPath);
+    auto names = dir.entryList({QStringLiteral("*.tif"), QStringLiteral("*.tiff")}, QDir::Files);
+    QCollator collator;
+    collator.setNumericMode(true);
+    std::sort(names.begin(), names.end(), collator);
+
+    // Without any position in the pattern, the files are a Z stack in natural name order
+    struct FolderFile {
+        QString path;
+        int z, c, t;
+    };
+    std::vector<FolderFile> files;
+    std::set<int> zValues, cValues, tValues;
+    for (const auto &name : std::as_const(names)) {
+        const auto m = re.match(name);
+        if (!m.hasMatch() || hasOmeTiffExtension(name))
+            continue;
+
+        FolderFile file{dir.absoluteFilePath(name), 0, 0, 0};
+        file.z = hasZ ? m.captured(QStringLiteral("z")).toInt() : (hasC || hasT ? 0 : static_cast<int>(files.size()));
+        file.c = hasC ? m.captured(QStringLiteral("c")).toInt() : 0;
+        file.t = hasT ? m.captured(QStringLiteral("t")).toInt() : 0;
+        zValues.insert(file.z);
+        cValues.insert(file.c);
+        tValues.insert(file.t);
+        files.push_back(file);
+    }
+
+    if (files.empty()) {
+        qWarning().noquote() << "No TIFF files matching the pattern in" << dirPath;
+        return false;
+    }
+
+    const auto rank = [](const std::set<int> &values, int value) {
+        return static_cast<dimension_size_type>(std::distance(values.begin(), values.find(value)));
+    };
+
+    // every Z/C/T position must be held by exactly one file, planes are ordered XYZCT
+    // like the reader of a single file would present them
+    std::vector<const FolderFile *> slots(zValues.size() * cValues.size() * tValues.size(), nullptr);
+    for (const auto &file : files) {
+        const auto plane = rank(zValues, file.z)
+                           + zValues.size() * (rank(cValues, file.c) + cValues.size() * rank(tValues, file.t));
+        if (slots[plane] != nullptr) {
+            qWarning().noquote() << QStringLiteral("%1 and %2 both hold position Z=%3 C=%4 T=%5")
+                                        .arg(QFileInfo(slots[plane]->path).fileName(), QFileInfo(file.path).fileName())
+                                        .arg(file.z)
+                                        .arg(file.c)
+                                        .arg(file.t);
+            return false;
+        }
+        slots[plane] = &file;
+    }
+    for (size_t plane = 0; plane < slots.size(); ++plane) {
+        if (slots[plane] != nullptr)
+            continue;
+        const auto valueAt = [](const std::set<int> &values, size_t index) {
+            return *std::next(values.begin(), static_cast<std::ptrdiff_t>(index));
+        };
+        const auto z = valueAt(zValues, plane % zValues.size());
+        const auto c = valueAt(cValues, plane / zValues.size() % cValues.size());
+        const auto t = valueAt(tValues, plane / (zValues.size() * cValues.size()));
+        qWarning().noquote()
+            << QStringLiteral("No file in %1 holds position Z=%2 C=%3 T=%4").arg(dirPath).arg(z).arg(c).arg(t);
+        return false;
+    }
+
+    try {
+        // only the first file is opened now, the others once their plane is needed
+        auto reader = std::make_shared<ome::files::in::TIFFReader>();
+        reader->setId(files.front().path.toStdString());
+        if (reader->getImageCount() != 1) {
+            qWarning().noquote() << "Folders can only be opened if every file holds a single plane";
+            return false;
+        }
+        d->reader = reader;
+
+        d->seriesFiles.resize(slots.size());
+        for (size_t plane = 0; plane < slots.size(); ++plane) {
+            auto &seriesFile = d->seriesFiles[plane];
+            seriesFile.path = slots[plane]->path;
+            seriesFile.firstPlane = plane;
+            seriesFile.planeCount = 1;
+            if (slots[plane] == &files.front()) {
+                seriesFile.reader = reader;
+                d->touchSeriesFile(plane);
+            }
+        }
+
+        d->isFolder = true;
+        d->folderPattern = pattern;
+        d->folderSizeZ = zValues.size();
+        d->folderSizeC = cValues.size();
+        d->folderSizeT = tValues.size();
+        d->isOmeTiff = false;
+        d->currentFilename = QDir::cleanPath(dir.absolutePath());
+        d->series = 0;
+        d->resolution = 0;
+        d->updateCachedDimensions();
+
+        qDebug().noquote() << "Opened folder" << d->currentFilename << "with" << files.size() << "files";
+        qDebug().nospace() << "  Dimensions: X=" << d->sizeX << "Y=" << d->sizeY << "Z=" << d->sizeZ << "T=" << d->sizeT
+                           << "C=" << d->sizeC;
+
+        return true;
+    } catch (const std::exception &e) {
+        qWarning().noquote() << "Failed to open TIFF folder:" << e.what();
+        close();
+        return false;
+    }
+}
+
+std::expected<bool, QString> OMETiffImage::openRawBinary(const QString &filename, const RawBinaryLayout &layout)
+{
+    PERF_TRACE_SCOPE("OMETiffImage::openRawBinary", "io");
+    close();
+
+    if (layout.sizeX <= 0 || layout.sizeY <= 0 || layout.sizeZ <= 0 || layout.sizeC <= 0 || layout.sizeT < 0
+        || layout.headerBytes < 0)
+        return std::unexpected(QStringLiteral("Invalid image shape for raw binary file"));
+
+    switch (layout.pixelType) {
+    case PT::INT8:
+    case PT::UINT8:
+    case PT::INT16:
+    case PT::UINT16:
+    case PT::INT32:
+    case PT::UINT32:
+    case PT::FLOAT:
+    case PT::DOUBLE:
+        break;
+    default:
+        return std::unexpected(QStringLiteral("Pixel type %1 is not supported for raw binary files")
+                                   .arg(QString::fromStdString(std::string(layout.pixelType))));
+    }
+
+    auto file = std::make_unique<QFile>(filename);
+    if (!file->open(QIODevice::ReadOnly))
+        return std::unexpected(QStringLiteral("Failed to open %1: %2").arg(filename, file->errorString()));
+
+    const auto planeBytes = static_cast<qint64>(layout.sizeX) * layout.sizeY * bytesPerPixel(layout.pixelType);
+    const auto planesInFile = std::max<qint64>(file->size() - layout.headerBytes, 0) / planeBytes;
+
+    // without a T size, the file length tells us how many time points there are
+    auto shape = layout;
+    if (shape.sizeT == 0)
+        shape.sizeT = static_cast<int>(planesInFile / (static_cast<qint64>(shape.sizeZ) * shape.sizeC));
+    const auto planeCount = static_cast<qint64>(shape.sizeZ) * shape.sizeC * shape.sizeT;
+    if (planeCount == 0 || planeCount > planesInFile)
+        return std::unexpected(QStringLiteral("The file holds %1 planes of %2x%3 pixels, but the shape needs %4")
+                                   .arg(planesInFile)
+                                   .arg(shape.sizeX)
+                                   .arg(shape.sizeY)
+                                   .arg(planeCount));
+    if (file->size() != layout.headerBytes + planeCount * planeBytes)
+        qWarning().noquote() << "Ignoring" << file->size() - layout.headerBytes - planeCount * planeBytes
+                             << "bytes at the end of" << filename;
+
+    // pages are only read from disk once a plane is accessed, and stay in the page cache
+    const auto data = file->map(0, file->size());
+    if (data == nullptr)
+        return std::unexpected(QStringLiteral("Failed to map %1: %2").arg(filename, file->errorString()));
+
+    d->rawBinaryFile = std::move(file);
+    d->rawBinaryData = data;
+    d->rawBinaryLayout = shape;
+    d->isOmeTiff = false;
+    d->currentFilename = filename;
+    d->series = 0;
+    d->resolution = 0;
+
+    d->rawSizeX = shape.sizeX;
+    d->rawSizeY = shape.sizeY;
+    d->rawSizeZ = shape.sizeZ;
+    d->rawSizeC = shape.sizeC;
+    d->rawSizeT = shape.sizeT;
+    d->rawImageCount = planeCount;
+    d->rawRGBChannelCount = 1;
+    d->cachedPixelType = shape.pixelType;
+    d->applyInterleavingInterpretation();
+
+    qDebug() << "Opened raw binary file:" << filename;
+    qDebug().nospace() << "  Dimensions: X=" << d->sizeX << "Y=" << d->sizeY << "Z=" << d->sizeZ << "T=" << d->sizeT
+                       << "C=" << d->sizeC;
+
+    return true;
+}
+
+bool OMETiffImage::isRawBinary() const
+{
+    return d->rawBinaryData != nullptr;
+}
+
+RawBinaryLayout OMETiffImage::rawBinaryLayout() const
+{
+    return d->rawBinaryLayout;
+}
+
+QString OMETiffImage::folderPattern() const
+{
+    return d->folderPattern;
+}
+
+QStringList OMETiffImage::findSeriesFiles(const QString &filename)
+{
+    static const QRegularExpression seriesRe(
+        QStringLiteral("^(.+_)(\\d{5})(\\.tiff?)$"), QRegularExpression::CaseInsensitiveOption);
+
+    const QFileInfo fi(filename);
+    const auto match = seriesRe.match(fi.fileName());
+    if (!match.hasMatch() || hasOmeTiffExtension(filename))
+        return {filename};
+
+    const auto prefix = match.captured(1);
+    const auto dir = fi.absoluteDir();
+    QMap<int, QString> numberedFiles;
+    const auto entries = dir.entryList({QStringLiteral("*.tif"), QStringLiteral("*.tiff")}, QDir::Files);
+    for (const auto &name : entries) {
+        const auto m = seriesRe.match(name);
+        if (m.hasMatch() && m.captured(1) == prefix)
+            numberedFiles.insert(m.captured(2).toInt(), dir.absoluteFilePath(name));
+    }
+
+    // only files with consecutive numbers belong to the same recording
+    const auto number = match.captured(2).toInt();
+    auto first = number;
+    while (numberedFiles.contains(first - 1))
+        first--;
+
+    QStringList files;
+    for (auto n = first; numberedFiles.contains(n); ++n)
+        files.append(numberedFiles.value(n));
+
+    return files.isEmpty() ? QStringList{filename} : files;
+}
+
+bool OMETiffImage::hasOmeTiffExtension(const QString &filename)
+{
+    return filename.endsWith(".ome.tiff", Qt::CaseInsensitive) || filename.endsWith(".ome.tif", Qt::CaseInsensitive);
+}
+
+std::expected<std::string, QString> OMETiffImage::readOmeXml(const QString &filename)
+{
+    try {
+        auto tiff = ome::files::tiff::TIFF::open(filename.toStdString(), "r");
+        auto ifd = tiff->getDirectoryByIndex(0U);
+
+        std::string xml;
+        ifd->getField(ome::files::tiff::IMAGEDESCRIPTION).get(xml);
+        return xml;
+    } catch (const std::exception &e) {
+        return std::unexpected(QStringLiteral("Failed to read TIFF header: %1").arg(e.what()));
+    }
+}
+
+std::expected<bool, QString> OMETiffImage::writeOmeXml(const QString &filename, const std::string &xml)
+{
+    PERF_TRACE_SCOPE("OMETiffImage::writeOmeXml", "save");
+    try {
+        // libtiff appends the directory to the end of the file if it grew, pixel data stays untouched
+        auto tiff = ome::files::tiff::TIFF::open(filename.toStdString(), "r+");
+        auto ifd = tiff->getDirectoryByIndex(0U);
+        ifd->getField(ome::files::tiff::IMAGEDESCRIPTION).set(xml);
+        tiff->writeDirectory(ifd);
+        return true;
+    } catch (const std::exception &e) {
+        return std::unexpected(QStringLiteral("Failed to write TIFF header: %1").arg(e.what()));
+    }
+}
+
+std::expected<ImageMetadata, QString> OMETiffImage::inspectFile(const QString &filename, int imageIndex)
+{
+    PERF_TRACE_SCOPE("OMETiffImage::inspectFile", "metadata");
+
+    const auto xmlResult = readOmeXml(filename);
+    if (!xmlResult)
+        return std::unexpected(xmlResult.error());
+    const auto &xml = xmlResult.value();
+
+    const auto first = xml.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos || xml[first] != '<')
+        return std::unexpected(QStringLiteral("File does not contain OME-XML metadata: %1").arg(filename));
+
+    const QByteArrayView xmlView(xml.data() + first, static_cast<qsizetype>(xml.size() - first));
+    const auto scan = scanOmeXml(xmlView, imageIndex);
+    if (!scan)
+        return std::unexpected(scan.error());
+
+    auto meta = scan->metadata;
+    if (meta.imageName.isEmpty())
+        meta.imageName = QFileInfo(filename).fileName();
+    try {
+        meta.dataSizeBytes = static_cast<size_t>(meta.sizeX) * meta.sizeY * meta.sizeZ * meta.sizeC * meta.sizeT
+                             * bytesPerPixel(PT(meta.pixelType.toStdString()));
+    } catch (const std::exception &) {
+        meta.dataSizeBytes = 0;
+    }
+
+    qDebug().noquote().nospace() << "Inspected " << filename << ": " << xml.size() << " bytes of OME-XML, "
+                                 << scan->planeCount << " planes, " << scan->annotationCount << " annotations";
+    return meta;
+}
+
 void OMETiffImage::close()
 {
     if (d->reader) {
@@ -258,17 +1373,36 @@ void OMETiffImage::close()
         }
         d->reader.reset();
     }
+    for (auto &file : d->seriesFiles) {
+        if (file.reader)
+            file.reader->close();
+    }
+    d->stripReader.reset();
+    if (d->rawBinaryFile) {
+        d->rawBinaryFile->unmap(d->rawBinaryData);
+        d->rawBinaryFile.reset();
+        d->rawBinaryData = nullptr;
+    }
+    d->seriesFiles.clear();
+    d->openSeriesFiles.clear();
+    d->isFolder = false;
+    d->folderPattern.clear();
+    d->folderSizeZ = d->folderSizeC = d->folderSizeT = 0;
     d->currentFilename.clear();
     d->interleavedChannels = 1;
+    d->binFrames = 1;
+    d->pixelConversion = PixelConversion::None;
     d->rawSizeX = d->rawSizeY = d->rawSizeZ = d->rawSizeT = d->rawSizeC = 0;
     d->rawImageCount = 0;
     d->sizeX = d->sizeY = d->sizeZ = d->sizeT = d->sizeC = 0;
     d->imageCount = 0;
+    d->planeCache.clear();
+    d->readStats = {};
 }
 
 bool OMETiffImage::isOpen() const
 {
-    return d->reader != nullptr;
+    return d->isOpen();
 }
 
 QString OMETiffImage::filename() const
@@ -276,6 +1410,14 @@ QString OMETiffImage::filename() const
     return d->currentFilename;
 }
 
+QStringList OMETiffImage::seriesFiles() const
+{
+    QStringList files;
+    for (const auto &file : d->seriesFiles)
+        files.append(file.path);
+    return files;
+}
+
 bool OMETiffImage::isOmeTiff() const
 {
     return d->isOmeTiff;
@@ -289,6 +1431,8 @@ std::expected<bool, QString> OMETiffImage::setInterleavedChannelCount(dimension_
     // Never mess with proper OME-TIFF files
     if (d->isOmeTiff)
         return std::unexpected("Cannot set interleaved channel count for OME-TIFF files!");
+    if (d->isFolder && d->folderSizeC > 1)
+        return std::unexpected("The channels of this folder are already given by the file names.");
     ;
 
     // Make sure the channel count divides evenly into the image count
@@ -314,6 +1458,75 @@ dimension_size_type OMETiffImage::interleavedChannelCount() const
     return d->interleavedChannels;
 }
 
+std::expected<bool, QString> OMETiffImage::setFrameBinning(dimension_size_type frames, FrameBinMode mode)
+{
+    frames = std::max<dimension_size_type>(frames, 1);
+    const auto r = d->checkFrameBinning(frames);
+    if (!r)
+        return r;
+
+    d->binFrames = frames;
+    d->binMode = mode;
+    return true;
+}
+
+dimension_size_type OMETiffImage::frameBinning() const
+{
+    return d->binFrames;
+}
+
+FrameBinMode OMETiffImage::frameBinMode() const
+{
+    return d->binMode;
+}
+
+std::expected<bool, QString> OMETiffImage::setPixelConversion(PixelConversion conversion)
+{
+    const auto r = d->checkPixelConversion(conversion);
+    if (!r)
+        return r;
+
+    d->pixelConversion = conversion;
+    return true;
+}
+
+PixelConversion OMETiffImage::pixelConversion() const
+{
+    return d->pixelConversion;
+}
+
+std::expected<bool, QString> OMETiffImage::setCompression(TiffCompression compression)
+{
+    if (!isCompressionAvailable(compression))
+        return std::unexpected(QStringLiteral("The TIFF library was built without support for %1 compression.")
+                                   .arg(QString::fromStdString(tiffCodecName(compression))));
+
+    d->compression = compression;
+    return true;
+}
+
+TiffCompression OMETiffImage::compression() const
+{
+    return d->compression;
+}
+
+void OMETiffImage::setDeduplicatePlanes(bool enabled)
+{
+    d->deduplicatePlanes = enabled;
+}
+
+bool OMETiffImage::deduplicatePlanes() const
+{
+    return d->deduplicatePlanes;
+}
+
+bool OMETiffImage::isCompressionAvailable(TiffCompression compression)
+{
+    // the codecs ome-files offers are the ones libtiff was built with
+    static const auto codecs = ome::files::out::OMETIFFWriter().getCompressionTypes();
+    return codecs.contains(tiffCodecName(compression));
+}
+
 dimension_size_type OMETiffImage::rawImageCount() const
 {
     return d->rawImageCount;
@@ -359,9 +1572,15 @@ dimension_size_type OMETiffImage::rgbChannelCount() const
     return d->rgbChannelCount;
 }
 
+size_t OMETiffImage::planeSizeBytes() const
+{
+    return d->sizeX * d->sizeY * std::max<dimension_size_type>(d->rgbChannelCount, 1)
+           * bytesPerPixel(d->cachedPixelType);
+}
+
 dimension_size_type OMETiffImage::getIndex(dimension_size_type z, dimension_size_type c, dimension_size_type t) const
 {
-    if (!d->reader)
+    if (!d->isOpen())
         return 0;
 
     return d->getPlaneIndex(z, c, t);
@@ -633,7 +1852,7 @@ private:
 
 RawImage OMETiffImage::readPlane(dimension_size_type z, dimension_size_type c, dimension_size_type t)
 {
-    if (!d->reader) {
+    if (!d->isOpen()) {
         qWarning().noquote() << "No file open";
         return {};
     }
@@ -644,23 +1863,50 @@ RawImage OMETiffImage::readPlane(dimension_size_type z, dimension_size_type c, d
 
 RawImage OMETiffImage::readPlaneByIndex(dimension_size_type planeIndex)
 {
-    if (!d->reader) {
+    if (!d->isOpen()) {
         qWarning().noquote() << "No file open";
         return {};
     }
 
+    PerfTrace::Span span("OMETiffImage::readPlaneByIndex", "io");
+    span.setArg("plane", static_cast<qint64>(planeIndex));
+
+    if (const auto cached = d->planeCache.object(planeIndex)) {
+        d->readStats.cacheHits++;
+        return *cached;
+    }
+    d->readStats.cacheMisses++;
+
     try {
-        dimension_size_type oldSeries = d->reader->getSeries();
-        d->reader->setSeries(d->series);
-        d->reader->setResolution(d->resolution);
+        QElapsedTimer timer;
+        dimension_size_type oldSeries = d->reader ? d->reader->getSeries() : 0;
+        if (d->reader) {
+            d->reader->setSeries(d->series);
+            d->reader->setResolution(d->resolution);
+        }
 
         VariantPixelBuffer buf;
-        d->reader->openBytes(planeIndex, buf);
+        {
+            // ome-files reads and decompresses in one go
+            PERF_TRACE_SCOPE("openBytes", "decode");
+            timer.start();
+            d->readRawPlane(planeIndex, buf);
+            d->readStats.lastDecodeMs = timer.nsecsElapsed() / 1000000.0;
+        }
 
-        d->reader->setSeries(oldSeries);
+        if (d->reader)
+            d->reader->setSeries(oldSeries);
 
+        PERF_TRACE_SCOPE("convertToRawImage", "convert");
+        timer.start();
         PixelBufferToRawImageVisitor visitor(d->sizeX, d->sizeY);
         std::visit(visitor, buf.vbuffer());
+        d->readStats.lastConvertMs = timer.nsecsElapsed() / 1000000.0;
+
+        // the pixel data is implicitly shared, so the cache holds no extra copy
+        const auto cost = static_cast<qsizetype>(visitor.result.data.size());
+        if (cost <= d->planeCache.maxCost())
+            d->planeCache.insert(planeIndex, new RawImage(visitor.result), cost);
 
         return visitor.result;
 
@@ -670,6 +1916,49 @@ RawImage OMETiffImage::readPlaneByIndex(dimension_size_type planeIndex)
     }
 }
 
+void OMETiffImage::setPlaneCacheSize(size_t bytes)
+{
+    d->planeCache.setMaxCost(static_cast<qsizetype>(bytes));
+}
+
+size_t OMETiffImage::planeCacheSize() const
+{
+    return static_cast<size_t>(d->planeCache.maxCost());
+}
+
+std::expected<bool, QString> OMETiffImage::readPlaneData(
+    dimension_size_type z,
+    dimension_size_type c,
+    dimension_size_type t,
+    VariantPixelBuffer &buf)
+{
+    if (!d->isOpen())
+        return std::unexpected(QStringLiteral("No file open"));
+    if (z >= d->sizeZ || c >= d->sizeC || t >= d->sizeT)
+        return std::unexpected(QStringLiteral("Plane Z=%1 C=%2 T=%3 is out of range").arg(z).arg(c).arg(t));
+
+    try {
+        if (d->reader) {
+            d->reader->setSeries(d->series);
+            d->reader->setResolution(d->resolution);
+        }
+        d->readRawPlane(d->getPlaneIndex(z, c, t), buf);
+    } catch (const std::exception &e) {
+        return std::unexpected(
+            QStringLiteral("Failed to read plane Z=%1 C=%2 T=%3: %4").arg(z).arg(c).arg(t).arg(e.what()));
+    }
+
+    return true;
+}
+
+PlaneReadStatistics OMETiffImage::readStatistics() const
+{
+    auto stats = d->readStats;
+    stats.cacheUsedBytes = static_cast<size_t>(d->planeCache.totalCost());
+    stats.cacheCapacityBytes = planeCacheSize();
+    return stats;
+}
+
 std::shared_ptr<ome::files::FormatReader> OMETiffImage::reader() const
 {
     return d->reader;
@@ -685,9 +1974,11 @@ std::shared_ptr<ome::xml::meta::OMEXMLMetadata> OMETiffImage::omeMetadata() cons
     return std::dynamic_pointer_cast<ome::xml::meta::OMEXMLMetadata>(metaStore);
 }
 
-static double floatQuantityToNm(
-    const ome::xml::model::primitives::
-        Quantity<ome::xml::model::enums::UnitsLength, ome::xml::model::primitives::PositiveFloat> &q)
+/**
+ * Convert a length quantity to nanometers.
+ */
+template<typename Quantity>
+static double quantityToNm(const Quantity &q)
 {
     double value = q.getValue();
     auto unit = q.getUnit();
@@ -705,18 +1996,29 @@ ImageMetadata OMETiffImage::extractMetadata(dimension_size_type imageIndex) cons
 {
     ImageMetadata meta;
 
-    if (!d->reader) {
-        qWarning().noquote() << "extractMetadata: No reader available";
+    if (!d->isOpen()) {
+        qWarning().noquote() << "extractMetadata: No file open";
         return meta;
     }
 
-    std::shared_ptr<ome::xml::meta::MetadataRetrieve> retrieve;
-    auto metaStore = d->reader->getMetadataStore();
-    retrieve = std::dynamic_pointer_cast<ome::xml::meta::MetadataRetrieve>(metaStore);
+    // We walk the OME object model directly: Optional attributes are null pointers there, while the
+    // MetadataRetrieve getters throw for every missing value, which is very slow for large files.
+    std::shared_ptr<ome::xml::meta::OMEXMLMetadataRoot> root;
+    auto metaStore = d->reader ? d->reader->getMetadataStore() : nullptr;
+    auto omeMeta = std::dynamic_pointer_cast<ome::xml::meta::OMEXMLMetadata>(metaStore);
+    if (omeMeta)
+        root = std::dynamic_pointer_cast<ome::xml::meta::OMEXMLMetadataRoot>(omeMeta->getRoot());
+
+    std::shared_ptr<ome::xml::model::Image> image;
+    std::shared_ptr<ome::xml::model::Pixels> pixels;
+    if (root && imageIndex < root->sizeOfImageList()) {
+        image = root->getImage(imageIndex);
+        if (image)
+            pixels = image->getPixels();
+    }
 
     // check if real metadata is available, if not, fall back to basic info
-    bool metadataAvailable = std::dynamic_pointer_cast<ome::xml::meta::DummyMetadata>(metaStore) == nullptr;
-    if (!retrieve || !metadataAvailable) {
+    if (!pixels) {
         // Use dimensions which account for interleaving
         meta.sizeX = static_cast<int>(d->sizeX);
         meta.sizeY = static_cast<int>(d->sizeY);
@@ -726,7 +2028,13 @@ ImageMetadata OMETiffImage::extractMetadata(dimension_size_type imageIndex) cons
         meta.pixelType = QString::fromStdString(std::string(d->cachedPixelType));
         QFileInfo fi(d->currentFilename);
         meta.imageName = fi.fileName();
-        meta.dataSizeBytes = fi.size();
+        if (d->seriesFiles.empty()) {
+            meta.dataSizeBytes = fi.size();
+        } else {
+            meta.dataSizeBytes = 0;
+            for (const auto &file : d->seriesFiles)
+                meta.dataSizeBytes += QFileInfo(file.path).size();
+        }
 
         // Add empty channel params for each effective channel
         for (int c = 0; c < meta.sizeC; ++c) {
@@ -738,201 +2046,292 @@ ImageMetadata OMETiffImage::extractMetadata(dimension_size_type imageIndex) cons
     }
 
     using namespace ome::xml::model;
+    PERF_TRACE_SCOPE("OMETiffImage::extractMetadata", "metadata");
 
     // Image name
-    try {
-        auto name = retrieve->getImageName(imageIndex);
-        meta.imageName = QString::fromStdString(name);
-    } catch (const std::exception &e) {
-        QFileInfo fi(d->currentFilename);
-        meta.imageName = fi.fileName();
-    }
+    if (const auto name = image->getName())
+        meta.imageName = QString::fromStdString(*name);
+    else
+        meta.imageName = QFileInfo(d->currentFilename).fileName();
+
+    // Dimensions & pixel type
+    meta.sizeX = static_cast<int>(pixels->getSizeX());
+    meta.sizeY = static_cast<int>(pixels->getSizeY());
+    meta.sizeZ = static_cast<int>(pixels->getSizeZ());
+    meta.sizeC = static_cast<int>(pixels->getSizeC());
+    meta.sizeT = static_cast<int>(pixels->getSizeT());
+
+    const auto pt = pixels->getType();
+    meta.pixelType = QString::fromStdString(std::string(pt));
+    meta.dataSizeBytes = static_cast<size_t>(meta.sizeX) * meta.sizeY * meta.sizeZ * meta.sizeC * meta.sizeT
+                         * bytesPerPixel(pt);
 
-    // Dimensions
-    try {
-        meta.sizeX = static_cast<int>(retrieve->getPixelsSizeX(imageIndex));
-        meta.sizeY = static_cast<int>(retrieve->getPixelsSizeY(imageIndex));
-        meta.sizeZ = static_cast<int>(retrieve->getPixelsSizeZ(imageIndex));
-        meta.sizeC = static_cast<int>(retrieve->getPixelsSizeC(imageIndex));
-        meta.sizeT = static_cast<int>(retrieve->getPixelsSizeT(imageIndex));
-    } catch (const std::exception &e) {
-        qWarning().noquote() << "extractMetadata: Failed to get dimensions:" << e.what();
-    }
+    // Physical sizes (convert to nm)
+    if (const auto physX = pixels->getPhysicalSizeX())
+        meta.physSizeXNm = quantityToNm(*physX);
+    if (const auto physY = pixels->getPhysicalSizeY())
+        meta.physSizeYNm = quantityToNm(*physY);
+    if (const auto physZ = pixels->getPhysicalSizeZ())
+        meta.physSizeZNm = quantityToNm(*physZ);
+
+    // Objective/optical parameters
+    if (const auto objSettings = image->getObjectiveSettings()) {
+        if (const auto ri = objSettings->getRefractiveIndex())
+            meta.immersionRI = *ri;
+        if (const auto medium = objSettings->getMedium())
+            meta.embeddingMedium = *medium;
+
+        // Index all objectives by their ID once, instead of searching every instrument
+        std::unordered_map<std::string, std::shared_ptr<Objective>> objectivesById;
+        for (size_t inst = 0; inst < root->sizeOfInstrumentList(); ++inst) {
+            const auto instrument = root->getInstrument(inst);
+            for (size_t obj = 0; obj < instrument->sizeOfObjectiveList(); ++obj) {
+                const auto objective = instrument->getObjective(obj);
+                objectivesById.try_emplace(objective->getID(), objective);
+            }
+        }
 
-    // Pixel type
-    try {
-        auto pt = retrieve->getPixelsType(imageIndex);
-        meta.pixelType = QString::fromStdString(std::string(pt));
-
-        // Calculate approximate data size
-        int bytesPerPixel = 1;
-        if (pt == enums::PixelType::UINT16 || pt == enums::PixelType::INT16)
-            bytesPerPixel = 2;
-        else if (pt == enums::PixelType::UINT32 || pt == enums::PixelType::INT32 || pt == enums::PixelType::FLOAT)
-            bytesPerPixel = 4;
-        else if (pt == enums::PixelType::DOUBLE)
-            bytesPerPixel = 8;
-        meta.dataSizeBytes = static_cast<size_t>(meta.sizeX) * meta.sizeY * meta.sizeZ * meta.sizeC * meta.sizeT
-                             * bytesPerPixel;
-    } catch (const std::exception &e) {
-        qWarning().noquote() << "extractMetadata: Failed to get pixel type:" << e.what();
+        const auto it = objectivesById.find(objSettings->getID());
+        if (it != objectivesById.end()) {
+            if (const auto na = it->second->getLensNA())
+                meta.numericalAperture = *na;
+            if (const auto immersion = it->second->getImmersion())
+                meta.lensImmersion = *immersion;
+        }
     }
 
-    // Physical sizes (convert to nm)
-    try {
-        auto physX = retrieve->getPixelsPhysicalSizeX(imageIndex);
-        meta.physSizeXNm = floatQuantityToNm(physX);
-    } catch (const std::exception &e) {
+    // Channel information
+    const auto channelCount = pixels->sizeOfChannelList();
+    meta.channels.reserve(channelCount);
+    for (size_t ch = 0; ch < channelCount; ++ch) {
+        const auto channel = pixels->getChannel(ch);
+        ChannelParams chParams;
+
+        if (const auto name = channel->getName())
+            chParams.name = QString::fromStdString(*name);
+        else
+            chParams.name = QStringLiteral("Channel %1").arg(ch);
+
+        if (const auto mode = channel->getAcquisitionMode()) {
+            chParams.acquisitionMode = *mode;
+            if (chParams.acquisitionMode == enums::AcquisitionMode::MULTIPHOTONMICROSCOPY)
+                chParams.photonCount = 2; // Default assumption for multiphoton
+        }
+
+        if (const auto excWL = channel->getExcitationWavelength())
+            chParams.exWavelengthNm = quantityToNm(*excWL);
+        if (const auto emWL = channel->getEmissionWavelength())
+            chParams.emWavelengthNm = quantityToNm(*emWL);
+        if (const auto pinhole = channel->getPinholeSize())
+            chParams.pinholeSizeNm = quantityToNm(*pinhole);
+
+        meta.channels.push_back(chParams);
     }
 
-    try {
-        auto physY = retrieve->getPixelsPhysicalSizeY(imageIndex);
-        meta.physSizeYNm = floatQuantityToNm(physY);
-    } catch (const std::exception &e) {
+    return meta;
+}
+
+std::shared_ptr<ome::xml::meta::OMEXMLMetadata> OMETiffImage::createOmeMetadata(
+    const ImageMetadata &metadata,
+    ome::xml::model::enums::DimensionOrder dimensionOrder)
+{
+    using namespace ome::xml::model;
+    auto meta = std::make_shared<ome::xml::meta::OMEXMLMetadata>();
+    const PT pixelType(metadata.pixelType.toStdString());
+
+    // Create CoreMetadata to describe the image
+    std::vector<std::shared_ptr<ome::files::CoreMetadata>> seriesList;
+    auto core = std::make_shared<ome::files::CoreMetadata>();
+
+    core->sizeX = metadata.sizeX;
+    core->sizeY = metadata.sizeY;
+    core->sizeZ = metadata.sizeZ;
+    core->sizeT = metadata.sizeT;
+
+    // Set up channels
+    core->sizeC.clear();
+    for (int c = 0; c < metadata.sizeC; ++c) {
+        core->sizeC.push_back(1); // 1 sample per channel (grayscale channels)
     }
 
-    try {
-        auto physZ = retrieve->getPixelsPhysicalSizeZ(imageIndex);
-        meta.physSizeZNm = floatQuantityToNm(physZ);
-    } catch (const std::exception &e) {
+    core->pixelType = pixelType;
+    core->interleaved = false;
+    core->dimensionOrder = dimensionOrder;
+
+    // Calculate bits per pixel based on pixel type
+    switch (pixelType) {
+    case PT::UINT8:
+    case PT::INT8:
+        core->bitsPerPixel = 8;
+        break;
+    case PT::UINT16:
+    case PT::INT16:
+        core->bitsPerPixel = 16;
+        break;
+    case PT::UINT32:
+    case PT::INT32:
+    case PT::FLOAT:
+        core->bitsPerPixel = 32;
+        break;
+    case PT::DOUBLE:
+        core->bitsPerPixel = 64;
+        break;
+    default:
+        core->bitsPerPixel = 8;
     }
 
-    // Objective/optical parameters from Instrument
-    try {
-        // Get objective settings from image
-        auto objectiveID = retrieve->getObjectiveSettingsID(imageIndex);
+    seriesList.push_back(core);
+
+    // Populate the OMEXMLMetadata
+    ome::files::fillMetadata(*meta, seriesList);
 
-        // Find the objective
-        auto instrumentCount = retrieve->getInstrumentCount();
+    // Set image name
+    if (!metadata.imageName.isEmpty())
+        meta->setImageName(metadata.imageName.toStdString(), 0);
 
-        for (dimension_size_type inst = 0; inst < instrumentCount; ++inst) {
-            auto objectiveCount = retrieve->getObjectiveCount(inst);
+    return meta;
+}
 
-            for (dimension_size_type obj = 0; obj < objectiveCount; ++obj) {
-                auto objID = retrieve->getObjectiveID(inst, obj);
-                if (objID != objectiveID)
-                    continue;
+void OMETiffImage::applyMetadata(
+    ome::xml::meta::OMEXMLMetadata &meta,
+    const ImageMetadata &metadata,
+    bool updateObjective)
+{
+    using namespace ome::xml::model;
+    using PositiveLength = primitives::Quantity<enums::UnitsLength, primitives::PositiveFloat>;
+    using Length = primitives::Quantity<enums::UnitsLength>;
+    const dimension_size_type imageIndex = 0;
+
+    // Update physical sizes (convert from nm to micrometers for OME standard)
+    if (metadata.physSizeXNm > 0) {
+        meta.setPixelsPhysicalSizeX(
+            PositiveLength(metadata.physSizeXNm / 1000.0, enums::UnitsLength::MICROMETER), imageIndex);
+    }
+    if (metadata.physSizeYNm > 0) {
+        meta.setPixelsPhysicalSizeY(
+            PositiveLength(metadata.physSizeYNm / 1000.0, enums::UnitsLength::MICROMETER), imageIndex);
+    }
+    if (metadata.physSizeZNm > 0) {
+        meta.setPixelsPhysicalSizeZ(
+            PositiveLength(metadata.physSizeZNm / 1000.0, enums::UnitsLength::MICROMETER), imageIndex);
+    }
 
-                try {
-                    meta.numericalAperture = retrieve->getObjectiveLensNA(inst, obj);
-                } catch (const std::exception &e) {
-                }
+    // Update objective settings (only for existing OME-TIFF with instrument data)
+    if (updateObjective) {
+        try {
+            if (metadata.immersionRI > 0)
+                meta.setObjectiveSettingsRefractiveIndex(metadata.immersionRI, imageIndex);
+            meta.setObjectiveSettingsMedium(metadata.embeddingMedium, imageIndex);
+        } catch (...) {
+        }
 
-                try {
-                    meta.lensImmersion = retrieve->getObjectiveImmersion(inst, obj);
-                } catch (const std::exception &e) {
+        // Update instrument/objective data
+        try {
+            auto objectiveID = meta.getObjectiveSettingsID(imageIndex);
+            auto instrumentCount = meta.getInstrumentCount();
+            for (dimension_size_type inst = 0; inst < instrumentCount; ++inst) {
+                auto objectiveCount = meta.getObjectiveCount(inst);
+                for (dimension_size_type obj = 0; obj < objectiveCount; ++obj) {
+                    auto objID = meta.getObjectiveID(inst, obj);
+                    if (objID == objectiveID) {
+                        if (metadata.numericalAperture > 0) {
+                            meta.setObjectiveLensNA(metadata.numericalAperture, inst, obj);
+                        }
+                        meta.setObjectiveImmersion(metadata.lensImmersion, inst, obj);
+                        break;
+                    }
                 }
-                break;
             }
+        } catch (...) {
         }
-    } catch (const std::exception &e) {
-    }
-
-    // Refractive index
-    try {
-        meta.immersionRI = retrieve->getObjectiveSettingsRefractiveIndex(imageIndex);
-    } catch (const std::exception &e) {
-    }
-
-    // Medium
-    try {
-        meta.embeddingMedium = retrieve->getObjectiveSettingsMedium(imageIndex);
-    } catch (const std::exception &e) {
     }
 
-    // Channel information
-    try {
-        auto channelCount = retrieve->getChannelCount(imageIndex);
-
-        for (dimension_size_type ch = 0; ch < channelCount; ++ch) {
-            ChannelParams chParams;
+    // Update channel information
+    for (size_t ch = 0; ch < metadata.channels.size(); ++ch) {
+        const auto &chParams = metadata.channels[ch];
 
-            try {
-                chParams.name = QString::fromStdString(retrieve->getChannelName(imageIndex, ch));
-                qDebug() << "extractMetadata: Channel" << ch << "name:" << chParams.name;
-            } catch (const std::exception &e) {
-                chParams.name = QString("Channel %1").arg(ch);
-            }
+        try {
+            meta.setChannelName(chParams.name.toStdString(), imageIndex, ch);
+        } catch (...) {
+        }
 
-            try {
-                chParams.acquisitionMode = retrieve->getChannelAcquisitionMode(imageIndex, ch);
-                if (chParams.acquisitionMode == enums::AcquisitionMode::MULTIPHOTONMICROSCOPY)
-                    chParams.photonCount = 2; // Default assumption for multiphoton
-                qDebug() << "extractMetadata: Channel" << ch << "acquisition mode:" << chParams.acquisitionMode;
-            } catch (const std::exception &e) {
-                chParams.acquisitionMode = enums::AcquisitionMode::LASERSCANNINGCONFOCALMICROSCOPY;
-            }
+        try {
+            meta.setChannelAcquisitionMode(chParams.acquisitionMode, imageIndex, ch);
+        } catch (...) {
+        }
 
-            try {
-                auto excWL = retrieve->getChannelExcitationWavelength(imageIndex, ch);
-                double value = excWL.getValue();
-                auto unit = excWL.getUnit();
-                // Convert to nm
-                if (unit == enums::UnitsLength::MICROMETER)
-                    value *= 1000.0;
-                else if (unit == enums::UnitsLength::METER)
-                    value *= 1e9;
-                chParams.exWavelengthNm = value;
-                qDebug() << "extractMetadata: Channel" << ch << "excitation:" << value << "nm";
-            } catch (const std::exception &e) {
+        try {
+            if (chParams.exWavelengthNm > 0) {
+                PositiveLength excWL(chParams.exWavelengthNm, enums::UnitsLength::NANOMETER);
+                meta.setChannelExcitationWavelength(excWL, imageIndex, ch);
             }
+        } catch (...) {
+        }
 
-            try {
-                auto emWL = retrieve->getChannelEmissionWavelength(imageIndex, ch);
-                double value = emWL.getValue();
-                auto unit = emWL.getUnit();
-                // Convert to nm
-                if (unit == enums::UnitsLength::MICROMETER)
-                    value *= 1000.0;
-                else if (unit == enums::UnitsLength::METER)
-                    value *= 1e9;
-                chParams.emWavelengthNm = value;
-                qDebug() << "extractMetadata: Channel" << ch << "emission:" << value << "nm";
-            } catch (const std::exception &e) {
+        try {
+            if (chParams.emWavelengthNm > 0) {
+                PositiveLength emWL(chParams.emWavelengthNm, enums::UnitsLength::NANOMETER);
+                meta.setChannelEmissionWavelength(emWL, imageIndex, ch);
             }
+        } catch (...) {
+        }
 
-            try {
-                auto pinhole = retrieve->getChannelPinholeSize(imageIndex, ch);
-                double value = pinhole.getValue();
-                auto unit = pinhole.getUnit();
-                // Convert to nm
-                if (unit == enums::UnitsLength::MICROMETER)
-                    value *= 1000.0;
-                else if (unit == enums::UnitsLength::METER)
-                    value *= 1e9;
-                chParams.pinholeSizeNm = value;
-                qDebug() << "extractMetadata: Channel" << ch << "pinhole:" << value << "nm";
-            } catch (const std::exception &e) {
+        try {
+            if (chParams.pinholeSizeNm > 0) {
+                Length pinhole(chParams.pinholeSizeNm, enums::UnitsLength::NANOMETER);
+                meta.setChannelPinholeSize(pinhole, imageIndex, ch);
             }
-
-            meta.channels.push_back(chParams);
+        } catch (...) {
         }
-    } catch (const std::exception &e) {
-        qWarning().noquote() << "extractMetadata: Error extracting channel information:" << e.what();
     }
-
-    return meta;
 }
 
 std::expected<bool, QString> OMETiffImage::saveWithMetadata(
     const QString &outputPath,
     const ImageMetadata &metadata,
-    ProgressCallback progressCallback)
+    ProgressCallback progressCallback,
+    SaveStatistics *stats)
 {
-    if (!d->reader)
+    if (!d->isOpen())
         return std::unexpected("No image data loaded");
 
+    // the interpretation may have changed since frame binning was set up
+    const auto binningValid = d->checkFrameBinning(d->binFrames);
+    if (!binningValid)
+        return binningValid;
+    const auto conversionValid = d->checkPixelConversion(d->pixelConversion);
+    if (!conversionValid)
+        return conversionValid;
+
+    PERF_TRACE_SCOPE("OMETiffImage::saveWithMetadata", "save");
+
+    SaveStatistics localStats;
+    auto &st = stats ? *stats : localStats;
+    st = {};
+
+    QElapsedTimer totalTimer;
+    QElapsedTimer stageTimer;
+    totalTimer.start();
+    stageTimer.start();
+    const auto msecsSince = [](const QElapsedTimer &timer) {
+        return timer.nsecsElapsed() / 1000000.0;
+    };
+
+    // Frames of a slice are consecutive Z positions, or time points for images without Z axis
+    const auto binFrames = d->binFrames;
+    const bool binZ = d->sizeZ > 1;
+    const auto outSizeZ = binZ ? d->sizeZ / binFrames : d->sizeZ;
+    const auto outSizeT = binZ ? d->sizeT : d->sizeT / binFrames;
+    const auto binnedType = binFrames > 1 ? binnedPixelType(d->cachedPixelType, d->binMode) : d->cachedPixelType;
+    const auto outPixelType = convertedPixelType(binnedType, d->pixelConversion);
+
     try {
-        using namespace ome::xml::model;
-        using PositiveLength = primitives::Quantity<enums::UnitsLength, primitives::PositiveFloat>;
-        using Length = primitives::Quantity<enums::UnitsLength>;
-        using PositiveInteger = primitives::PositiveInteger;
+        std::optional<PerfTrace::Span> metaSpan(std::in_place, "prepareMetadata", "save");
 
         std::shared_ptr<ome::xml::meta::OMEXMLMetadata> modifiedMeta;
-        dimension_size_type imageIndex = 0;
 
         // Check if we have valid source metadata
-        auto metaStore = d->reader->getMetadataStore();
+        auto metaStore = d->reader ? d->reader->getMetadataStore() : nullptr;
         auto sourceMetadata = std::dynamic_pointer_cast<ome::xml::meta::OMEXMLMetadata>(metaStore);
         bool hasValidSourceMetadata = sourceMetadata
                                       && std::dynamic_pointer_cast<ome::xml::meta::DummyMetadata>(metaStore) == nullptr;
@@ -941,145 +2340,31 @@ std::expected<bool, QString> OMETiffImage::saveWithMetadata(
             // For OME-TIFF: Copy and modify existing metadata
             modifiedMeta = std::make_shared<ome::xml::meta::OMEXMLMetadata>();
             ome::xml::meta::convert(*sourceMetadata, *modifiedMeta);
-        } else {
-            // For raw TIFF: Create metadata from scratch using CoreMetadata helper
-            modifiedMeta = std::make_shared<ome::xml::meta::OMEXMLMetadata>();
-
-            // Create CoreMetadata to describe the image
-            std::vector<std::shared_ptr<ome::files::CoreMetadata>> seriesList;
-            auto core = std::make_shared<ome::files::CoreMetadata>();
-
-            core->sizeX = d->sizeX;
-            core->sizeY = d->sizeY;
-            core->sizeZ = d->sizeZ;
-            core->sizeT = d->sizeT;
-
-            // Set up channels
-            core->sizeC.clear();
-            for (dimension_size_type c = 0; c < d->sizeC; ++c) {
-                core->sizeC.push_back(1); // 1 sample per channel (grayscale channels)
-            }
-
-            core->pixelType = d->cachedPixelType;
-            core->interleaved = false;
-            core->dimensionOrder = enums::DimensionOrder::XYZCT;
-
-            // Calculate bits per pixel based on pixel type
-            switch (d->cachedPixelType) {
-            case PT::UINT8:
-            case PT::INT8:
-                core->bitsPerPixel = 8;
-                break;
-            case PT::UINT16:
-            case PT::INT16:
-                core->bitsPerPixel = 16;
-                break;
-            case PT::UINT32:
-            case PT::INT32:
-            case PT::FLOAT:
-                core->bitsPerPixel = 32;
-                break;
-            case PT::DOUBLE:
-                core->bitsPerPixel = 64;
-                break;
-            default:
-                core->bitsPerPixel = 8;
-            }
-
-            seriesList.push_back(core);
-
-            // Populate the OMEXMLMetadata
-            ome::files::fillMetadata(*modifiedMeta, seriesList);
-
-            // Set image name
-            if (!metadata.imageName.isEmpty())
-                modifiedMeta->setImageName(metadata.imageName.toStdString(), imageIndex);
-        }
-
-        // Update physical sizes (convert from nm to micrometers for OME standard)
-        if (metadata.physSizeXNm > 0) {
-            modifiedMeta->setPixelsPhysicalSizeX(
-                PositiveLength(metadata.physSizeXNm / 1000.0, enums::UnitsLength::MICROMETER), imageIndex);
-        }
-        if (metadata.physSizeYNm > 0) {
-            modifiedMeta->setPixelsPhysicalSizeY(
-                PositiveLength(metadata.physSizeYNm / 1000.0, enums::UnitsLength::MICROMETER), imageIndex);
-        }
-        if (metadata.physSizeZNm > 0) {
-            modifiedMeta->setPixelsPhysicalSizeZ(
-                PositiveLength(metadata.physSizeZNm / 1000.0, enums::UnitsLength::MICROMETER), imageIndex);
-        }
-
-        // Update objective settings (only for existing OME-TIFF with instrument data)
-        if (hasValidSourceMetadata && d->isOmeTiff) {
-            try {
-                if (metadata.immersionRI > 0)
-                    modifiedMeta->setObjectiveSettingsRefractiveIndex(metadata.immersionRI, imageIndex);
-                modifiedMeta->setObjectiveSettingsMedium(metadata.embeddingMedium, imageIndex);
-            } catch (...) {
-            }
-
-            // Update instrument/objective data
-            try {
-                auto objectiveID = modifiedMeta->getObjectiveSettingsID(imageIndex);
-                auto instrumentCount = modifiedMeta->getInstrumentCount();
-                for (dimension_size_type inst = 0; inst < instrumentCount; ++inst) {
-                    auto objectiveCount = modifiedMeta->getObjectiveCount(inst);
-                    for (dimension_size_type obj = 0; obj < objectiveCount; ++obj) {
-                        auto objID = modifiedMeta->getObjectiveID(inst, obj);
-                        if (objID == objectiveID) {
-                            if (metadata.numericalAperture > 0) {
-                                modifiedMeta->setObjectiveLensNA(metadata.numericalAperture, inst, obj);
-                            }
-                            modifiedMeta->setObjectiveImmersion(metadata.lensImmersion, inst, obj);
-                            break;
-                        }
-                    }
-                }
-            } catch (...) {
+            if (d->pixelConversion != PixelConversion::None) {
+                modifiedMeta->setPixelsType(outPixelType, 0);
+                modifiedMeta->setPixelsSignificantBits(
+                    ome::xml::model::primitives::PositiveInteger(bytesPerPixel(outPixelType) * 8), 0);
             }
+        } else {
+            // For raw TIFF: Create metadata from scratch
+            auto rawMetadata = metadata;
+            rawMetadata.sizeX = static_cast<int>(d->sizeX);
+            rawMetadata.sizeY = static_cast<int>(d->sizeY);
+            rawMetadata.sizeZ = static_cast<int>(outSizeZ);
+            rawMetadata.sizeC = static_cast<int>(d->sizeC);
+            rawMetadata.sizeT = static_cast<int>(outSizeT);
+            rawMetadata.pixelType = QString::fromStdString(std::string(outPixelType));
+            modifiedMeta = createOmeMetadata(rawMetadata);
         }
 
-        // Update channel information
-        for (size_t ch = 0; ch < metadata.channels.size(); ++ch) {
-            const auto &chParams = metadata.channels[ch];
-
-            try {
-                modifiedMeta->setChannelName(chParams.name.toStdString(), imageIndex, ch);
-            } catch (...) {
-            }
-
-            try {
-                modifiedMeta->setChannelAcquisitionMode(chParams.acquisitionMode, imageIndex, ch);
-            } catch (...) {
-            }
-
-            try {
-                if (chParams.exWavelengthNm > 0) {
-                    PositiveLength excWL(chParams.exWavelengthNm, enums::UnitsLength::NANOMETER);
-                    modifiedMeta->setChannelExcitationWavelength(excWL, imageIndex, ch);
-                }
-            } catch (...) {
-            }
-
-            try {
-                if (chParams.emWavelengthNm > 0) {
-                    PositiveLength emWL(chParams.emWavelengthNm, enums::UnitsLength::NANOMETER);
-                    modifiedMeta->setChannelEmissionWavelength(emWL, imageIndex, ch);
-                }
-            } catch (...) {
-            }
+        applyMetadata(*modifiedMeta, metadata, hasValidSourceMetadata && d->isOmeTiff);
 
-            try {
-                if (chParams.pinholeSizeNm > 0) {
-                    Length pinhole(chParams.pinholeSizeNm, enums::UnitsLength::NANOMETER);
-                    modifiedMeta->setChannelPinholeSize(pinhole, imageIndex, ch);
-                }
-            } catch (...) {
-            }
-        }
+        metaSpan.reset();
+        st.metadataMs = msecsSince(stageTimer);
 
         // Create writer and write the file
+        std::optional<PerfTrace::Span> setupSpan(std::in_place, "setupWriter", "save");
+        stageTimer.start();
         auto writer = std::make_shared<ome::files::out::OMETIFFWriter>();
         std::shared_ptr<ome::xml::meta::MetadataRetrieve> metaRetrieve = modifiedMeta;
         writer->setMetadataRetrieve(metaRetrieve);
@@ -1090,60 +2375,183 @@ std::expected<bool, QString> OMETiffImage::saveWithMetadata(
         // Use interleaved (contiguous) storage
         writer->setInterleaved(true);
 
-        // Use zlib compression for smaller file sizes
-        // A warning is emitted for "Deflate", recommending to use "AdobeDeflate" instead for wider support,
-        // and claiming "Deflate" was legacy. So we just use "AdobeDeflate", it's the same algorithm.
-        writer->setCompression("AdobeDeflate");
+        // Compress the pixel data for smaller file sizes
+        const auto codec = tiffCodecName(d->compression);
+        writer->setCompression(codec);
+        st.codec = QString::fromStdString(codec);
 
         writer->setId(outputPath.toStdString());
+        setupSpan.reset();
+        st.setupMs = msecsSince(stageTimer);
+
+        const auto planeBytes = planeSizeBytes();
+        auto readSourcePlane = [&](dimension_size_type plane, VariantPixelBuffer &buf) {
+            PerfTrace::Span span("readPlane", "save");
+            span.setArg("plane", static_cast<qint64>(plane));
+            stageTimer.start();
+            d->readRawPlane(plane, buf);
+            st.readMs += msecsSince(stageTimer);
+            st.bytesIn += planeBytes;
+        };
+        auto writeOutputPlane = [&](dimension_size_type plane, const VariantPixelBuffer &buf) {
+            // includes compression, ome-files does not expose it as a separate step
+            PerfTrace::Span span("writePlane", "save");
+            span.setArg("plane", static_cast<qint64>(plane));
+            stageTimer.start();
+            writer->saveBytes(plane, buf);
+            st.writeMs += msecsSince(stageTimer);
+            st.planes++;
+        };
 
         // Write planes
         writer->setSeries(0);
-        d->reader->setSeries(0);
-
-        if (!d->isOmeTiff && d->interleavedChannels > 1) {
-            // For interleaved raw TIFFs: write planes in the correct order for OME-TIFF
-            // OME-TIFF expects planes ordered by dimension order (XYZCT means Z varies fastest, then C, then T)
-            dimension_size_type outPlane = 0;
-            dimension_size_type totalPlanes = d->sizeT * d->sizeC * d->sizeZ;
-
-            for (dimension_size_type t = 0; t < d->sizeT; ++t) {
-                for (dimension_size_type c = 0; c < d->sizeC; ++c) {
-                    for (dimension_size_type z = 0; z < d->sizeZ; ++z) {
-                        if (progressCallback && !progressCallback(outPlane, totalPlanes)) {
-                            writer->close();
-                            return std::unexpected("Save operation cancelled by user");
-                        }
-
-                        // Get the raw plane index for this (z, c, t) combination
-                        dimension_size_type rawPlane = d->getPlaneIndex(z, c, t);
+        if (d->reader)
+            d->reader->setSeries(0);
+
+        const auto planeOrder = d->outputPlaneOrder();
+        const auto totalPlanes = static_cast<dimension_size_type>(planeOrder.size() / binFrames);
+
+        // A conversion maps the value range of the whole image, which needs a pass over all planes first
+        double valueOffset = 0;
+        double valueScale = 1;
+        if (d->pixelConversion != PixelConversion::None) {
+            PERF_TRACE_SCOPE("scanValueRange", "save");
+            QElapsedTimer rangeTimer;
+            rangeTimer.start();
+
+            double minValue = std::numeric_limits<double>::infinity();
+            double maxValue = -std::numeric_limits<double>::infinity();
+            for (size_t i = 0; i < planeOrder.size(); ++i) {
+                if (progressCallback && !progressCallback(0, totalPlanes)) {
+                    writer->close();
+                    return std::unexpected("Save operation cancelled by user");
+                }
 
-                        VariantPixelBuffer buf;
-                        d->reader->openBytes(rawPlane, buf);
-                        writer->saveBytes(outPlane, buf);
-                        ++outPlane;
+                if (d->isFolder) {
+                    const auto plane = readSinglePlaneFile(d->seriesFiles[planeOrder[i]].path);
+                    if (!plane) {
+                        writer->close();
+                        return std::unexpected(plane.error());
                     }
+                    updateValueRange(*plane.value(), minValue, maxValue);
+                } else {
+                    VariantPixelBuffer buf;
+                    d->readRawPlane(planeOrder[i], buf);
+                    updateValueRange(buf, minValue, maxValue);
                 }
             }
-        } else {
-            // For OME-TIFF or non-interleaved: copy planes directly
-            dimension_size_type planeCount = d->reader->getImageCount();
-            for (dimension_size_type plane = 0; plane < planeCount; ++plane) {
-                if (progressCallback && !progressCallback(plane, planeCount)) {
+
+            // an image of NaNs only has no range, everything is written as 0
+            if (minValue > maxValue)
+                minValue = maxValue = 0;
+
+            // sums of binned frames cover a proportionally larger range
+            if (binFrames > 1 && d->binMode == FrameBinMode::Sum) {
+                minValue *= static_cast<double>(binFrames);
+                maxValue *= static_cast<double>(binFrames);
+            }
+
+            std::tie(valueOffset, valueScale) = conversionMapping(
+                d->pixelConversion, outPixelType, minValue, maxValue);
+
+            st.rangeMs = msecsSince(rangeTimer);
+            st.valueOffset = valueOffset;
+            st.valueScale = valueScale;
+            qDebug().noquote() << "Converting pixel values in range" << minValue << "to" << maxValue << "to"
+                               << QString::fromStdString(std::string(outPixelType)) << "with offset" << valueOffset
+                               << "and scale" << valueScale;
+        }
+
+        // Opening a file takes longer than reading a single plane from it, especially on network
+        // storage, so the files of a folder source are read ahead in parallel
+        QThreadPool readPool;
+        readPool.setMaxThreadCount(MaxParallelFileReads);
+        std::deque<QFuture<PlaneFileResult>> readAhead;
+        size_t nextReadAhead = 0;
+
+        size_t nextPlane = 0;
+        const std::function<PlaneFileResult()> readNextPlane = [&]() -> PlaneFileResult {
+            if (!d->isFolder) {
+                auto buf = std::make_shared<VariantPixelBuffer>();
+                readSourcePlane(planeOrder[nextPlane++], *buf);
+                return buf;
+            }
+
+            while (readAhead.size() < 2 * MaxParallelFileReads && nextReadAhead < planeOrder.size()) {
+                const auto path = d->seriesFiles[planeOrder[nextReadAhead++]].path;
+                readAhead.push_back(QtConcurrent::run(&readPool, readSinglePlaneFile, path));
+            }
+
+            stageTimer.start();
+            auto plane = readAhead.front().result();
+            readAhead.pop_front();
+            nextPlane++;
+            st.readMs += msecsSince(stageTimer);
+            if (plane)
+                st.bytesIn += planeBytes;
+            return plane;
+        };
+
+        for (dimension_size_type outPlane = 0; outPlane < totalPlanes; ++outPlane) {
+            if (progressCallback && !progressCallback(outPlane, totalPlanes)) {
+                writer->close();
+                return std::unexpected("Save operation cancelled by user");
+            }
+
+            std::shared_ptr<VariantPixelBuffer> plane;
+            if (binFrames > 1) {
+                plane = std::make_shared<VariantPixelBuffer>();
+                const auto r = binPlanes(
+                    d->cachedPixelType, readNextPlane, binFrames, d->binMode, d->sizeX, d->sizeY, *plane);
+                if (!r) {
                     writer->close();
-                    return std::unexpected("Save operation cancelled by user");
+                    return std::unexpected(r.error());
+                }
+            } else {
+                auto next = readNextPlane();
+                if (!next) {
+                    writer->close();
+                    return std::unexpected(next.error());
                 }
+                plane = std::move(next.value());
+            }
 
-                VariantPixelBuffer buf;
-                d->reader->openBytes(plane, buf);
-                writer->saveBytes(plane, buf);
+            if (d->pixelConversion != PixelConversion::None) {
+                auto converted = std::make_shared<VariantPixelBuffer>();
+                convertPixels(*plane, outPixelType, valueOffset, valueScale, d->sizeX, d->sizeY, *converted);
+                plane = std::move(converted);
             }
+            writeOutputPlane(outPlane, *plane);
         }
 
-        writer->close();
+        {
+            PERF_TRACE_SCOPE("closeWriter", "save");
+            stageTimer.start();
+            writer->close();
+            st.finalizeMs = msecsSince(stageTimer);
+        }
 
         // Guard against ome-files omitting the XML declaration in the embedded OME-XML.
-        ensureXmlDeclaration(outputPath.toStdString());
+        {
+            PERF_TRACE_SCOPE("ensureXmlDeclaration", "save");
+            stageTimer.start();
+            ensureXmlDeclaration(outputPath.toStdString());
+            st.xmlPatchMs = msecsSince(stageTimer);
+        }
+
+        // ome-files writes every plane in full, so repeated planes are made to share their strips afterwards
+        if (d->deduplicatePlanes) {
+            stageTimer.start();
+            const auto dedup = TiffDeduplicator(outputPath).run();
+            if (!dedup)
+                return std::unexpected(dedup.error());
+            st.duplicatePlanes = dedup->planes;
+            st.duplicateBytes = dedup->bytes;
+            st.dedupMs = msecsSince(stageTimer);
+        }
+
+        st.bytesOut = static_cast<quint64>(QFileInfo(outputPath).size());
+        st.totalMs = msecsSince(totalTimer);
 
         qDebug() << "Successfully saved OME-TIFF with modified metadata to:" << outputPath;
         return true;
@@ -1152,3 +2560,90 @@ std::expected<bool, QString> OMETiffImage::saveWithMetadata(
         return std::unexpected(QStringLiteral("Failed to save OME-TIFF: %1").arg(e.what()));
     }
 }
+
+dimension_size_type OMETiffImage::outputPlaneCount() const
+{
+    return d->isOpen() ? d->imageCount / d->binFrames : 0;
+}
+
+std::expected<std::shared_ptr<VariantPixelBuffer>, QString> OMETiffImage::readOutputPlane(
+    dimension_size_type outPlane)
+{
+    if (!d->isOpen())
+        return std::unexpected(QStringLiteral("No image data loaded"));
+    const auto binningValid = d->checkFrameBinning(d->binFrames);
+    if (!binningValid)
+        return std::unexpected(binningValid.error());
+    const auto conversionValid = d->checkPixelConversion(d->pixelConversion);
+    if (!conversionValid)
+        return std::unexpected(conversionValid.error());
+
+    const auto binFrames = d->binFrames;
+    const auto planeOrder = d->outputPlaneOrder();
+    if (outPlane >= planeOrder.size() / binFrames)
+        return std::unexpected(QStringLiteral("Output plane %1 does not exist").arg(outPlane));
+
+    try {
+        auto nextPlane = static_cast<size_t>(outPlane * binFrames);
+        const std::function<PlaneFileResult()> readNextPlane = [&]() -> PlaneFileResult {
+            const auto plane = planeOrder[nextPlane++];
+            if (d->isFolder)
+                return readSinglePlaneFile(d->seriesFiles[plane].path);
+            auto buf = std::make_shared<VariantPixelBuffer>();
+            d->readRawPlane(plane, *buf);
+            return buf;
+        };
+
+        std::shared_ptr<VariantPixelBuffer> plane;
+        if (binFrames > 1) {
+            plane = std::make_shared<VariantPixelBuffer>();
+            const auto r = binPlanes(
+                d->cachedPixelType, readNextPlane, binFrames, d->binMode, d->sizeX, d->sizeY, *plane);
+            if (!r)
+                return std::unexpected(r.error());
+        } else {
+            auto next = readNextPlane();
+            if (!next)
+                return next;
+            plane = std::move(next.value());
+        }
+
+        if (d->pixelConversion == PixelConversion::None)
+            return plane;
+
+        double minValue = std::numeric_limits<double>::infinity();
+        double maxValue = -std::numeric_limits<double>::infinity();
+        updateValueRange(*plane, minValue, maxValue);
+        if (minValue > maxValue)
+            minValue = maxValue = 0;
+
+        const auto binnedType = binFrames > 1 ? binnedPixelType(d->cachedPixelType, d->binMode) : d->cachedPixelType;
+        const auto outPixelType = convertedPixelType(binnedType, d->pixelConversion);
+        const auto [offset, scale] = conversionMapping(d->pixelConversion, outPixelType, minValue, maxValue);
+        auto converted = std::make_shared<VariantPixelBuffer>();
+        convertPixels(*plane, outPixelType, offset, scale, d->sizeX, d->sizeY, *converted);
+        return converted;
+    } catch (const std::exception &e) {
+        return std::unexpected(QStringLiteral("Failed to read output plane %1: %2").arg(outPlane).arg(e.what()));
+    }
+}
+
+size_t OMETiffImage::saveMemoryBytes() const
+{
+    if (!d->isOpen())
+        return 0;
+
+    const auto samples = d->sizeX * d->sizeY * std::max<dimension_size_type>(d->rgbChannelCount, 1);
+    const auto binnedType = d->binFrames > 1 ? binnedPixelType(d->cachedPixelType, d->binMode)
+                                             : d->cachedPixelType;
+    const auto outBytes = samples * bytesPerPixel(convertedPixelType(binnedType, d->pixelConversion));
+
+    // the source plane, the combined and the converted plane, frame sums in up to 8 bytes per sample,
+    // and the planes read ahead from a folder
+    auto bytes = planeSizeBytes() + 2 * outBytes;
+    if (d->binFrames > 1)
+        bytes += samples * sizeof(double);
+    if (d->isFolder)
+        bytes += 2 * MaxParallelFileReads * planeSizeBytes();
+    return bytes;
+}
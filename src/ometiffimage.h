@@ -8,6 +8,7 @@
 
 #include <QObject>
 #include <QString>
+#include <QStringList>
 #include <memory>
 #include <expected>
 #include <functional>
@@ -78,6 +79,104 @@ struct RawImage {
     }
 };
 
+/**
+ * @brief Counters maintained by the plane read path, for diagnostics.
+ */
+struct PlaneReadStatistics {
+    double lastDecodeMs = 0;  /// Time spent reading & decompressing the last uncached plane
+    double lastConvertMs = 0; /// Time spent converting the last uncached plane for display
+    quint64 cacheHits = 0;
+    quint64 cacheMisses = 0;
+    size_t cacheUsedBytes = 0;
+    size_t cacheCapacityBytes = 0;
+
+    [[nodiscard]] double cacheHitRate() const
+    {
+        const auto total = cacheHits + cacheMisses;
+        return total > 0 ? static_cast<double>(cacheHits) / total : 0;
+    }
+};
+
+/**
+ * @brief Timings and data volumes collected while saving an image.
+ *
+ * All times are in milliseconds. ome-files compresses the data while writing it,
+ * so both steps are accounted for in writeMs.
+ */
+struct SaveStatistics {
+    quint64 planes = 0;
+    quint64 bytesIn = 0;  /// Uncompressed pixel data read from the source
+    quint64 bytesOut = 0; /// Size of the written file
+
+    double metadataMs = 0; /// Preparing the OME-XML metadata
+    double setupMs = 0;    /// Creating the output file
+    double readMs = 0;     /// Reading & decompressing source planes
+    double writeMs = 0;    /// Compressing & writing output planes
+    double finalizeMs = 0; /// Closing the writer, which writes the OME-XML
+    double xmlPatchMs = 0; /// Fixing up the written OME-XML header
+    double rangeMs = 0;    /// Scanning the value range for a pixel type conversion
+    double dedupMs = 0;    /// Finding identical planes and removing their copies
+    double totalMs = 0;
+
+    bool headerOnly = false; /// Only the OME-XML header was rewritten, pixel data was kept as-is
+    QString codec;           /// Compression codec of the written pixel data
+
+    quint64 duplicatePlanes = 0; /// Planes sharing the pixel data of an identical earlier plane
+    quint64 duplicateBytes = 0;  /// Bytes saved by not storing those planes again
+
+    // Mapping applied by a pixel type conversion: written = (source - valueOffset) * valueScale
+    double valueOffset = 0;
+    double valueScale = 1;
+
+    [[nodiscard]] double compressionRatio() const
+    {
+        return bytesOut > 0 ? static_cast<double>(bytesIn) / static_cast<double>(bytesOut) : 0;
+    }
+};
+
+/**
+ * @brief Shape and sample format of a headerless binary image file.
+ *
+ * Planes are stored one after another in XYZCT order, like the data.bin files
+ * written by suite2p.
+ */
+struct RawBinaryLayout {
+    int sizeX = 0;
+    int sizeY = 0;
+    int sizeZ = 1;
+    int sizeC = 1;
+    int sizeT = 0; /// 0 to derive the number of time points from the file size
+    ome::xml::model::enums::PixelType pixelType = ome::xml::model::enums::PixelType::INT16;
+    bool bigEndian = false;
+    qint64 headerBytes = 0; /// Bytes to skip at the start of the file
+};
+
+/**
+ * @brief How consecutive frames of a slice are combined into one plane.
+ */
+enum class FrameBinMode {
+    Average, /// Mean of all frames, keeping the pixel type
+    Sum      /// Sum of all frames, in a wider pixel type for 8 & 16 bit data
+};
+
+/**
+ * @brief Conversion of the pixel type applied when saving.
+ */
+enum class PixelConversion {
+    None,
+    ScaleToUInt16, /// Map the value range of the whole image linearly onto 0..65535
+    ScaleToUInt8,  /// Map the value range of the whole image linearly onto 0..255
+    OffsetToUInt16 /// Shift negative values up so the image minimum becomes 0, keeping the scale
+};
+
+/**
+ * @brief Compression of the pixel data of written OME-TIFF files.
+ */
+enum class TiffCompression {
+    Deflate, /// zlib deflate, readable by every TIFF reader
+    Zstd     /// Zstandard, several times faster to write and read at a similar ratio, needs libtiff 4.0.10+
+};
+
 /**
  * @brief Wrapper class for reading & writing OME-TIFF files
  *
@@ -101,6 +200,116 @@ public:
      */
     bool open(const QString &filename);
 
+    /**
+     * @brief Open a series of raw TIFF files as one image.
+     *
+     * The planes of all files are presented as one continuous plane sequence, in the
+     * order the files are given in. Files are opened on demand when their planes are
+     * read, so only a limited number of them is open at the same time.
+     *
+     * @param filenames Paths to the raw TIFF files, in acquisition order.
+     * @return true if all files were opened and have the same plane size and pixel type.
+     */
+    bool openSeries(const QStringList &filenames);
+
+    /**
+     * @brief Open a directory of single-plane TIFF files as one image.
+     *
+     * The position of each file is read from its name with a regular expression, whose
+     * named groups "z", "c" and "t" capture the respective index, for example
+     * "img_c(?<c>[0-9]+)_z(?<z>[0-9]+)[.]tif". Groups can be left out for dimensions of size 1.
+     * Without a pattern, all TIFF files form a Z stack in natural file name order.
+     * When saving, the files are read in parallel.
+     *
+     * @param dirPath Directory containing the TIFF files.
+     * @param pattern Regular expression matching the whole file name, or an empty string.
+     * @return true if the files cover all positions exactly once.
+     */
+    bool openFolder(const QString &dirPath, const QString &pattern = QString());
+
+    /**
+     * @brief Open a headerless binary file, like a suite2p data.bin, as an image.
+     *
+     * The file is memory-mapped, so planes are only read from disk when they are
+     * accessed and the operating system can page them out again under memory pressure.
+     *
+     * @param filename Path to the binary file.
+     * @param layout Shape and sample format of the data in the file.
+     * @return true, or an error message if the file does not match the layout.
+     */
+    std::expected<bool, QString> openRawBinary(const QString &filename, const RawBinaryLayout &layout);
+
+    /**
+     * @brief Check whether the open image is a headerless binary file.
+     */
+    [[nodiscard]] bool isRawBinary() const;
+
+    /**
+     * @brief Get the layout of the open binary file, with the derived number of time points.
+     */
+    [[nodiscard]] RawBinaryLayout rawBinaryLayout() const;
+
+    /**
+     * @brief Get the file name pattern the currently open folder was opened with.
+     */
+    [[nodiscard]] QString folderPattern() const;
+
+    /**
+     * @brief Find all files of the multi-file series a raw TIFF belongs to.
+     *
+     * ScanImage splits long recordings into files ending in a running number,
+     * like "stack_00001.tif", "stack_00002.tif" etc.
+     *
+     * @return All files of the series in order, or only @p filename if it is not part of one.
+     */
+    static QStringList findSeriesFiles(const QString &filename);
+
+    /**
+     * @brief Check whether a file name has an OME-TIFF extension.
+     */
+    static bool hasOmeTiffExtension(const QString &filename);
+
+    /**
+     * @brief Read the OME-XML header (the description of the first IFD) of a TIFF file.
+     */
+    static std::expected<std::string, QString> readOmeXml(const QString &filename);
+
+    /**
+     * @brief Replace the OME-XML header of a TIFF file in place, without touching its pixel data.
+     */
+    static std::expected<bool, QString> writeOmeXml(const QString &filename, const std::string &xml);
+
+    /**
+     * @brief Read the metadata of an OME-TIFF file without opening it.
+     *
+     * Only the OME-XML header is read, using a streaming parser that skips per-plane
+     * data, so this is much faster and uses far less memory than open() for files
+     * with huge headers. Use it when only the metadata is needed.
+     *
+     * @param filename Path to the OME-TIFF file.
+     * @param imageIndex The image series index (usually 0)
+     */
+    static std::expected<ImageMetadata, QString> inspectFile(const QString &filename, int imageIndex = 0);
+
+    /**
+     * @brief Create OME-XML metadata describing a new single-image file.
+     *
+     * Dimensions, pixel type and image name are taken from @p metadata. Use applyMetadata()
+     * to set the remaining fields.
+     */
+    static std::shared_ptr<ome::xml::meta::OMEXMLMetadata> createOmeMetadata(
+        const ImageMetadata &metadata,
+        ome::xml::model::enums::DimensionOrder dimensionOrder = ome::xml::model::enums::DimensionOrder::XYZCT);
+
+    /**
+     * @brief Apply physical sizes, optical and channel parameters to OME-XML metadata.
+     * @param updateObjective Also update the objective, which only exists in metadata read from OME-TIFF files.
+     */
+    static void applyMetadata(
+        ome::xml::meta::OMEXMLMetadata &meta,
+        const ImageMetadata &metadata,
+        bool updateObjective);
+
     /**
      * @brief Close the currently open file.
      */
@@ -116,6 +325,12 @@ public:
      */
     [[nodiscard]] QString filename() const;
 
+    /**
+     * @brief Get all files of the currently open multi-file series.
+     * @return The files opened with openSeries(), or an empty list if a single file is open.
+     */
+    [[nodiscard]] QStringList seriesFiles() const;
+
     /**
      * @brief Check if the currently open file is an OME-TIFF.
      * @return true if it's an OME-TIFF, false otherwise.
@@ -138,6 +353,73 @@ public:
      */
     [[nodiscard]] dimension_size_type interleavedChannelCount() const;
 
+    /**
+     * @brief Combine consecutive frames of every slice into one plane when saving.
+     *
+     * ScanImage can record several frames per slice for averaging, which end up as
+     * consecutive Z positions of the raw TIFF, or consecutive time points if it has no Z axis.
+     * With frame binning, every run of @p frames of them is written as a single plane,
+     * and the Z (or T) size of the output shrinks accordingly. The displayed image is not affected.
+     *
+     * @param frames Number of frames per slice, 1 to write every frame.
+     * @param mode Whether frames are averaged or summed.
+     */
+    std::expected<bool, QString> setFrameBinning(dimension_size_type frames, FrameBinMode mode = FrameBinMode::Average);
+
+    /**
+     * @brief Get the number of frames that are combined into one plane when saving.
+     */
+    [[nodiscard]] dimension_size_type frameBinning() const;
+
+    /**
+     * @brief Get how frames are combined when saving.
+     */
+    [[nodiscard]] FrameBinMode frameBinMode() const;
+
+    /**
+     * @brief Convert the pixel type of all planes when saving.
+     *
+     * The value range is determined over the whole image (after frame binning), not per plane,
+     * so intensities stay comparable between planes. This needs an extra pass over the source data.
+     * NaN samples of floating point images are written as 0. The displayed image is not affected.
+     */
+    std::expected<bool, QString> setPixelConversion(PixelConversion conversion);
+
+    /**
+     * @brief Get the pixel type conversion applied when saving.
+     */
+    [[nodiscard]] PixelConversion pixelConversion() const;
+
+    /**
+     * @brief Set how the pixel data is compressed when saving.
+     * @return An error if the TIFF library was built without support for the codec.
+     */
+    std::expected<bool, QString> setCompression(TiffCompression compression);
+
+    /**
+     * @brief Get how the pixel data is compressed when saving.
+     */
+    [[nodiscard]] TiffCompression compression() const;
+
+    /**
+     * @brief Check whether the TIFF library can write and read the given compression.
+     */
+    static bool isCompressionAvailable(TiffCompression compression);
+
+    /**
+     * @brief Set whether planes identical to an earlier plane share its pixel data when saving.
+     *
+     * Repeated planes, like blank frames while the shutter was closed, then take no space
+     * in the written file. This costs an extra pass over the file after writing it, which
+     * only has to move data if duplicates were found.
+     */
+    void setDeduplicatePlanes(bool enabled);
+
+    /**
+     * @brief Check whether identical planes share their pixel data when saving.
+     */
+    [[nodiscard]] bool deduplicatePlanes() const;
+
     /**
      * @brief Get the raw/original number of planes in the file.
      *
@@ -170,6 +452,11 @@ public:
      */
     [[nodiscard]] dimension_size_type rgbChannelCount() const;
 
+    /**
+     * @brief Get the size of a single uncompressed plane in bytes.
+     */
+    [[nodiscard]] size_t planeSizeBytes() const;
+
     /**
      * @brief Calculate the plane index from Z, C, T coordinates.
      * @param z Z position
@@ -200,6 +487,32 @@ public:
      */
     [[nodiscard]] RawImage readPlaneByIndex(dimension_size_type planeIndex);
 
+    /**
+     * @brief Read the unconverted pixel data of a plane, for writing it to another format.
+     *
+     * Unlike readPlane(), the samples keep their pixel type and the plane cache is bypassed.
+     * @return true, or an error message if the plane could not be read.
+     */
+    std::expected<bool, QString> readPlaneData(
+        dimension_size_type z,
+        dimension_size_type c,
+        dimension_size_type t,
+        ome::files::VariantPixelBuffer &buf);
+
+    /**
+     * @brief Set the memory budget for recently read planes.
+     *
+     * Planes are evicted in least-recently-used order once the budget is exceeded.
+     * @param bytes Cache size in bytes, 0 disables caching (the default).
+     */
+    void setPlaneCacheSize(size_t bytes);
+    [[nodiscard]] size_t planeCacheSize() const;
+
+    /**
+     * @brief Get timing and cache counters of the plane read path.
+     */
+    [[nodiscard]] PlaneReadStatistics readStatistics() const;
+
     /**
      * @brief Get the underlying reader.
      */
@@ -231,12 +544,34 @@ public:
      * @param outputPath Path to the output OME-TIFF file.
      * @param metadata Metadata to write to the file.
      * @param progressCallback Optional callback for progress reporting (current, total) -> continue?
+     * @param stats Optional statistics to fill with stage timings and data volumes.
      * @return true if successful, error message otherwise.
      */
     std::expected<bool, QString> saveWithMetadata(
         const QString &outputPath,
         const ImageMetadata &metadata,
-        ProgressCallback progressCallback = nullptr);
+        ProgressCallback progressCallback = nullptr,
+        SaveStatistics *stats = nullptr);
+
+    /**
+     * @brief Get the number of planes saveWithMetadata() writes.
+     */
+    [[nodiscard]] dimension_size_type outputPlaneCount() const;
+
+    /**
+     * @brief Read a plane the way saveWithMetadata() writes it, e.g. to estimate the output.
+     *
+     * Frames are combined and the pixel type is converted as configured. As the value range
+     * of the whole image is not known here, a conversion maps the value range of this plane.
+     * @param outPlane Index of the plane in the written file.
+     */
+    std::expected<std::shared_ptr<ome::files::VariantPixelBuffer>, QString> readOutputPlane(
+        dimension_size_type outPlane);
+
+    /**
+     * @brief Get the approximate memory saveWithMetadata() needs for pixel data at the same time.
+     */
+    [[nodiscard]] size_t saveMemoryBytes() const;
 
 private:
     class Private;
@@ -0,0 +1,538 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include "omexmlpatcher.h"
+
+#include <QByteArray>
+#include <QLocale>
+#include <QUuid>
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <set>
+#include <vector>
+
+using namespace ome::xml::model;
+
+namespace
+{
+
+struct Attribute {
+    std::string_view name;
+    size_t valueBegin = 0;
+    size_t valueEnd = 0;
+};
+
+/**
+ * Start tag of an element we may need to modify.
+ */
+struct Tag {
+    std::string_view name;   // local name, without namespace prefix
+    int imageOrdinal = -1;   // index of the enclosing Image element, -1 if outside of any
+    size_t nameEnd = 0;      // offset right after the element name, where new attributes go
+    size_t contentBegin = 0; // offset right after the start tag, 0 for empty elements
+    std::vector<Attribute> attrs;
+
+    [[nodiscard]] const Attribute *attr(std::string_view attrName) const
+    {
+        const auto it = std::find_if(attrs.cbegin(), attrs.cend(), [&](const Attribute &a) {
+            return a.name == attrName;
+        });
+        return it == attrs.cend() ? nullptr : &*it;
+    }
+};
+
+struct Edit {
+    size_t begin;
+    size_t end;
+    std::string replacement;
+};
+
+} // namespace
+
+static constexpr std::string_view XmlDeclaration = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>";
+
+// Elements whose attributes we read or modify
+static bool isInterestingElement(std::string_view name)
+{
+    return name == "OME" || name == "Image" || name == "Pixels" || name == "Channel" || name == "ObjectiveSettings"
+           || name == "Objective" || name == "UUID" || name == "BinaryOnly";
+}
+
+static bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static std::string_view localName(std::string_view qualifiedName)
+{
+    const auto colon = qualifiedName.find(':');
+    return colon == std::string_view::npos ? qualifiedName : qualifiedName.substr(colon + 1);
+}
+
+/**
+ * Collect the start tags of all elements we are interested in, with the byte
+ * ranges of their attribute values.
+ */
+static std::expected<std::vector<Tag>, QString> scanTags(std::string_view xml)
+{
+    std::vector<Tag> tags;
+    std::vector<std::string_view> openElements;
+    int imageCount = 0;
+    int currentImage = -1;
+
+    const auto skipPast = [&](size_t from, std::string_view terminator) -> size_t {
+        const auto end = xml.find(terminator, from);
+        return end == std::string_view::npos ? std::string_view::npos : end + terminator.size();
+    };
+
+    size_t pos = 0;
+    while ((pos = xml.find('<', pos)) != std::string_view::npos) {
+        const auto rest = xml.substr(pos);
+        if (rest.starts_with("<!--")) {
+            pos = skipPast(pos + 4, "-->");
+        } else if (rest.starts_with("<![CDATA[")) {
+            pos = skipPast(pos + 9, "]]>");
+        } else if (rest.starts_with("<?")) {
+            pos = skipPast(pos + 2, "?>");
+        } else if (rest.starts_with("<!")) {
+            pos = skipPast(pos + 2, ">");
+        } else if (rest.starts_with("</")) {
+            const auto end = xml.find('>', pos);
+            if (end == std::string_view::npos)
+                break;
+            if (openElements.empty())
+                return std::unexpected(QStringLiteral("Unbalanced end tag at offset %1").arg(pos));
+            if (openElements.back() == "Image")
+                currentImage = -1;
+            openElements.pop_back();
+            pos = end + 1;
+        } else {
+            // start tag
+            size_t i = pos + 1;
+            while (i < xml.size() && !isSpace(xml[i]) && xml[i] != '/' && xml[i] != '>')
+                ++i;
+
+            Tag tag;
+            tag.name = localName(xml.substr(pos + 1, i - pos - 1));
+            tag.nameEnd = i;
+
+            bool selfClosing = false;
+            while (true) {
+                while (i < xml.size() && isSpace(xml[i]))
+                    ++i;
+                if (i >= xml.size())
+                    return std::unexpected(QStringLiteral("Unterminated tag at offset %1").arg(pos));
+                if (xml[i] == '>') {
+                    ++i;
+                    break;
+                }
+                if (xml[i] == '/') {
+                    selfClosing = true;
+                    i = xml.find('>', i);
+                    if (i == std::string_view::npos)
+                        return std::unexpected(QStringLiteral("Unterminated tag at offset %1").arg(pos));
+                    ++i;
+                    break;
+                }
+
+                const auto nameBegin = i;
+                while (i < xml.size() && xml[i] != '=' && !isSpace(xml[i]))
+                    ++i;
+                const auto attrName = xml.substr(nameBegin, i - nameBegin);
+                while (i < xml.size() && isSpace(xml[i]))
+                    ++i;
+                if (i >= xml.size() || xml[i] != '=')
+                    return std::unexpected(QStringLiteral("Malformed attribute at offset %1").arg(nameBegin));
+                ++i;
+                while (i < xml.size() && isSpace(xml[i]))
+                    ++i;
+                if (i >= xml.size() || (xml[i] != '"' && xml[i] != '\''))
+                    return std::unexpected(QStringLiteral("Unquoted attribute at offset %1").arg(nameBegin));
+
+                const char quote = xml[i++];
+                const auto valueEnd = xml.find(quote, i);
+                if (valueEnd == std::string_view::npos)
+                    return std::unexpected(QStringLiteral("Unterminated attribute at offset %1").arg(nameBegin));
+                tag.attrs.push_back({attrName, i, valueEnd});
+                i = valueEnd + 1;
+            }
+
+            if (tag.name == "Image" && openElements.size() == 1)
+                currentImage = imageCount++;
+            tag.imageOrdinal = currentImage;
+
+            if (!selfClosing) {
+                openElements.push_back(tag.name);
+                tag.contentBegin = i;
+            }
+            else if (tag.name == "Image")
+                currentImage = -1;
+
+            if (isInterestingElement(tag.name))
+                tags.push_back(std::move(tag));
+            pos = i;
+        }
+
+        if (pos == std::string_view::npos)
+            return std::unexpected(QStringLiteral("Unterminated markup in OME-XML"));
+    }
+
+    if (!openElements.empty())
+        return std::unexpected(QStringLiteral("OME-XML document is truncated"));
+
+    return tags;
+}
+
+static std::string escapeXml(std::string_view text)
+{
+    std::string result;
+    result.reserve(text.size());
+    for (const char c : text) {
+        switch (c) {
+        case '&':
+            result += "&amp;";
+            break;
+        case '<':
+            result += "&lt;";
+            break;
+        case '>':
+            result += "&gt;";
+            break;
+        case '"':
+            result += "&quot;";
+            break;
+        case '\'':
+            result += "&apos;";
+            break;
+        default:
+            result += c;
+        }
+    }
+    return result;
+}
+
+static std::string unescapeXml(std::string_view text)
+{
+    static constexpr std::pair<std::string_view, char> entities[] = {
+        {"&amp;",  '&'},
+        {"&lt;",   '<'},
+        {"&gt;",   '>'},
+        {"&quot;", '"'},
+        {"&apos;", '\''},
+    };
+
+    std::string result;
+    result.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        bool replaced = false;
+        if (text[i] == '&') {
+            for (const auto &[entity, ch] : entities) {
+                if (text.substr(i).starts_with(entity)) {
+                    result += ch;
+                    i += entity.size() - 1;
+                    replaced = true;
+                    break;
+                }
+            }
+        }
+        if (!replaced)
+            result += text[i];
+    }
+    return result;
+}
+
+static std::string formatNumber(double value)
+{
+    return QByteArray::number(value, 'g', QLocale::FloatingPointShortest).toStdString();
+}
+
+/**
+ * Factor to convert a length in the given OME unit symbol to nanometers.
+ */
+static std::optional<double> nmPerUnit(std::string_view unit)
+{
+    if (unit == "nm")
+        return 1.0;
+    if (unit == "µm" || unit == "um")
+        return 1000.0;
+    if (unit == "mm")
+        return 1e6;
+    if (unit == "cm")
+        return 1e7;
+    if (unit == "m")
+        return 1e9;
+    if (unit == "Å")
+        return 0.1;
+    if (unit == "pm")
+        return 1e-3;
+    return std::nullopt;
+}
+
+static bool nearlyEqual(double a, double b)
+{
+    return std::abs(a - b) <= 1e-9 * std::max({1.0, std::abs(a), std::abs(b)});
+}
+
+namespace
+{
+
+/**
+ * Collects edits for a single document, so they can be applied in one pass.
+ */
+class PatchBuilder
+{
+public:
+    explicit PatchBuilder(std::string_view xml)
+        : m_xml(xml)
+    {
+    }
+
+    [[nodiscard]] std::string_view value(const Attribute &attr) const
+    {
+        return m_xml.substr(attr.valueBegin, attr.valueEnd - attr.valueBegin);
+    }
+
+    void setAttribute(const Tag &tag, std::string_view name, std::string_view newValue)
+    {
+        const auto escaped = escapeXml(newValue);
+        if (const auto attr = tag.attr(name)) {
+            if (value(*attr) != escaped)
+                m_edits.push_back({attr->valueBegin, attr->valueEnd, escaped});
+            return;
+        }
+
+        m_edits.push_back({tag.nameEnd, tag.nameEnd, " " + std::string(name) + "=\"" + escaped + "\""});
+    }
+
+    /**
+     * Replace the text content of an element that has no child elements.
+     */
+    void setContent(const Tag &tag, std::string_view newContent)
+    {
+        const auto end = m_xml.find('<', tag.contentBegin);
+        if (end == std::string_view::npos)
+            return;
+        m_edits.push_back({tag.contentBegin, end, escapeXml(newContent)});
+    }
+
+    /**
+     * Set a string attribute, unless its current (possibly implicit) value already matches.
+     */
+    void setText(const Tag &tag, std::string_view name, const std::string &newValue, const std::string &implicitValue)
+    {
+        const auto attr = tag.attr(name);
+        const auto current = attr ? unescapeXml(value(*attr)) : implicitValue;
+        if (current != newValue)
+            setAttribute(tag, name, newValue);
+    }
+
+    /**
+     * Set a length attribute, given in nanometers, if it differs from the current value.
+     */
+    void setLength(
+        const Tag &tag,
+        std::string_view name,
+        std::string_view defaultUnit,
+        double newValueNm,
+        std::string_view writeUnit)
+    {
+        if (newValueNm <= 0)
+            return;
+
+        const auto unitAttrName = std::string(name) + "Unit";
+        const auto attr = tag.attr(name);
+        if (attr) {
+            const auto unitAttr = tag.attr(unitAttrName);
+            const auto factor = nmPerUnit(unitAttr ? value(*unitAttr) : defaultUnit);
+            const auto current = QByteArrayView(value(*attr)).toDouble();
+            if (factor && nearlyEqual(current * factor.value(), newValueNm))
+                return;
+        }
+
+        setAttribute(tag, name, formatNumber(newValueNm / nmPerUnit(writeUnit).value()));
+        setAttribute(tag, unitAttrName, writeUnit);
+    }
+
+    /**
+     * Set a plain numeric attribute if it differs from the current value.
+     */
+    void setNumber(const Tag &tag, std::string_view name, double newValue)
+    {
+        const auto attr = tag.attr(name);
+        if (attr && nearlyEqual(QByteArrayView(value(*attr)).toDouble(), newValue))
+            return;
+        setAttribute(tag, name, formatNumber(newValue));
+    }
+
+    [[nodiscard]] int changeCount() const
+    {
+        return static_cast<int>(m_edits.size());
+    }
+
+    std::string apply()
+    {
+        std::stable_sort(m_edits.begin(), m_edits.end(), [](const Edit &a, const Edit &b) {
+            return a.begin < b.begin;
+        });
+
+        size_t extraSize = 0;
+        for (const auto &edit : m_edits)
+            extraSize += edit.replacement.size();
+
+        std::string result;
+        result.reserve(m_xml.size() + extraSize);
+        size_t pos = 0;
+        for (const auto &edit : m_edits) {
+            result.append(m_xml.substr(pos, edit.begin - pos));
+            result.append(edit.replacement);
+            pos = edit.end;
+        }
+        result.append(m_xml.substr(pos));
+
+        return result;
+    }
+
+private:
+    std::string_view m_xml;
+    std::vector<Edit> m_edits;
+};
+
+} // namespace
+
+std::expected<std::string, QString> patchOmeXml(
+    std::string_view xml,
+    const ImageMetadata &metadata,
+    int imageIndex,
+    const QString &dataFileName,
+    int *changeCount)
+{
+    const auto first = xml.find_first_not_of(" \t\r\n");
+    if (first == std::string_view::npos || xml[first] != '<')
+        return std::unexpected(QStringLiteral("Not an XML document"));
+    xml.remove_prefix(first);
+
+    auto tagsResult = scanTags(xml);
+    if (!tagsResult)
+        return std::unexpected(tagsResult.error());
+    const auto &tags = tagsResult.value();
+
+    PatchBuilder patch(xml);
+
+    // Image data in other files would need their headers updated as well
+    std::set<std::string_view> dataFiles;
+    for (const auto &tag : tags) {
+        if (tag.name == "BinaryOnly")
+            return std::unexpected(QStringLiteral("Metadata-only companion files are not supported"));
+        if (tag.name == "UUID") {
+            if (const auto fileName = tag.attr("FileName"))
+                dataFiles.insert(patch.value(*fileName));
+        }
+    }
+    if (dataFiles.size() > 1)
+        return std::unexpected(QStringLiteral("Multi-file datasets are not supported"));
+
+    // a renamed copy is a file of its own, and must point at itself for its pixel data
+    if (!dataFileName.isEmpty()) {
+        const auto fileName = dataFileName.toStdString();
+        const auto uuid = QStringLiteral("urn:uuid:%1").arg(QUuid::createUuid().toString(QUuid::WithoutBraces));
+        const auto uuidStr = uuid.toStdString();
+        for (const auto &tag : tags) {
+            if (tag.name == "OME")
+                patch.setAttribute(tag, "UUID", uuidStr);
+            if (tag.name != "UUID" || !tag.attr("FileName"))
+                continue;
+            patch.setAttribute(tag, "FileName", fileName);
+            if (tag.contentBegin > 0)
+                patch.setContent(tag, uuidStr);
+        }
+    }
+
+    const Tag *pixels = nullptr;
+    const Tag *objSettings = nullptr;
+    std::vector<const Tag *> channels;
+    for (const auto &tag : tags) {
+        if (tag.imageOrdinal != imageIndex)
+            continue;
+        if (tag.name == "Pixels")
+            pixels = &tag;
+        else if (tag.name == "ObjectiveSettings")
+            objSettings = &tag;
+        else if (tag.name == "Channel")
+            channels.push_back(&tag);
+    }
+    if (!pixels)
+        return std::unexpected(QStringLiteral("OME-XML does not contain pixel data for image %1").arg(imageIndex));
+
+    // Physical sizes, written in micrometers like the full writer does
+    patch.setLength(*pixels, "PhysicalSizeX", "µm", metadata.physSizeXNm, "µm");
+    patch.setLength(*pixels, "PhysicalSizeY", "µm", metadata.physSizeYNm, "µm");
+    patch.setLength(*pixels, "PhysicalSizeZ", "µm", metadata.physSizeZNm, "µm");
+
+    // Objective settings & the objective they reference
+    const ImageMetadata defaults;
+    const auto mediumStr = std::string(metadata.embeddingMedium);
+    const auto immersionStr = std::string(metadata.lensImmersion);
+    const auto defaultMediumStr = std::string(defaults.embeddingMedium);
+    const auto defaultImmersionStr = std::string(defaults.lensImmersion);
+    if (objSettings) {
+        if (metadata.immersionRI > 0)
+            patch.setNumber(*objSettings, "RefractiveIndex", metadata.immersionRI);
+        patch.setText(*objSettings, "Medium", mediumStr, defaultMediumStr);
+
+        const Tag *objective = nullptr;
+        if (const auto idAttr = objSettings->attr("ID")) {
+            const auto id = patch.value(*idAttr);
+            for (const auto &tag : tags) {
+                const auto tagId = tag.name == "Objective" ? tag.attr("ID") : nullptr;
+                if (tagId && patch.value(*tagId) == id) {
+                    objective = &tag;
+                    break;
+                }
+            }
+        }
+
+        if (objective) {
+            if (metadata.numericalAperture > 0)
+                patch.setNumber(*objective, "LensNA", metadata.numericalAperture);
+            patch.setText(*objective, "Immersion", immersionStr, defaultImmersionStr);
+        } else if (metadata.numericalAperture > 0 || immersionStr != defaultImmersionStr) {
+            return std::unexpected(QStringLiteral("The objective referenced by the image was not found"));
+        }
+    } else if (
+        (metadata.immersionRI > 0 && !nearlyEqual(metadata.immersionRI, defaults.immersionRI))
+        || mediumStr != defaultMediumStr || metadata.numericalAperture > 0 || immersionStr != defaultImmersionStr) {
+        return std::unexpected(QStringLiteral("The image has no objective settings to modify"));
+    }
+
+    // Channels
+    if (metadata.channels.size() > channels.size())
+        return std::unexpected(QStringLiteral("The image has fewer channels than the new metadata"));
+    for (size_t ch = 0; ch < metadata.channels.size(); ++ch) {
+        const auto &chParams = metadata.channels[ch];
+        const auto &tag = *channels[ch];
+
+        patch.setText(
+            tag, "Name", chParams.name.toStdString(), QStringLiteral("Channel %1").arg(ch).toStdString());
+        patch.setText(
+            tag,
+            "AcquisitionMode",
+            std::string(chParams.acquisitionMode),
+            std::string(ChannelParams().acquisitionMode));
+        patch.setLength(tag, "ExcitationWavelength", "nm", chParams.exWavelengthNm, "nm");
+        patch.setLength(tag, "EmissionWavelength", "nm", chParams.emWavelengthNm, "nm");
+        patch.setLength(tag, "PinholeSize", "µm", chParams.pinholeSizeNm, "nm");
+    }
+
+    if (changeCount)
+        *changeCount = patch.changeCount();
+
+    auto result = patch.apply();
+    if (!std::string_view(result).starts_with("<?xml"))
+        result.insert(0, std::string(XmlDeclaration) + "\n");
+
+    return result;
+}
@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <QString>
+#include <expected>
+#include <string>
+#include <string_view>
+
+#include "ometiffimage.h"
+
+/**
+ * @brief Apply metadata edits to OME-XML text without a DOM round-trip.
+ *
+ * Only the attributes that actually change are rewritten, all other bytes of the
+ * document - including elements unknown to us, comments and formatting - are kept
+ * verbatim. Attributes that are missing are added to their existing element.
+ *
+ * Edits that would require new elements (e.g. setting the immersion medium on an
+ * image without ObjectiveSettings), as well as multi-file datasets, are not supported
+ * and return an error, in which case the caller should fall back to a full rewrite.
+ *
+ * @param xml The original OME-XML document.
+ * @param metadata The desired metadata of the image.
+ * @param imageIndex The Image element to modify.
+ * @param dataFileName If set, the file name all TiffData elements refer to, for copies with a new name.
+ *                     The copy is given a new UUID, so it can not be mistaken for the original.
+ * @param changeCount Set to the number of rewritten attributes, if not null.
+ * @return The patched document.
+ */
+std::expected<std::string, QString> patchOmeXml(
+    std::string_view xml,
+    const ImageMetadata &metadata,
+    int imageIndex = 0,
+    const QString &dataFileName = QString(),
+    int *changeCount = nullptr);
@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include "omexmlscanner.h"
+
+#include <QDebug>
+#include <QHash>
+#include <QXmlStreamReader>
+
+using namespace ome::xml::model;
+using namespace Qt::Literals::StringLiterals;
+
+namespace
+{
+
+struct ObjectiveInfo {
+    double lensNA = 0;
+    QString immersion;
+};
+
+} // namespace
+
+/**
+ * Convert a length in the given OME unit symbol to nanometers.
+ */
+static double lengthToNm(double value, QStringView unit, QStringView defaultUnit)
+{
+    if (unit.isEmpty())
+        unit = defaultUnit;
+
+    if (unit == u"nm")
+        return value;
+    if (unit == u"µm" || unit == u"um")
+        return value * 1000.0;
+    if (unit == u"mm")
+        return value * 1e6;
+    if (unit == u"cm")
+        return value * 1e7;
+    if (unit == u"m")
+        return value * 1e9;
+    if (unit == u"Å")
+        return value * 0.1;
+    if (unit == u"pm")
+        return value * 1e-3;
+
+    qWarning().noquote() << "OME-XML: Unsupported length unit" << unit.toString();
+    return value;
+}
+
+static double lengthAttribute(
+    const QXmlStreamAttributes &attrs,
+    QLatin1StringView name,
+    QLatin1StringView unitName,
+    QStringView defaultUnit)
+{
+    const auto value = attrs.value(name);
+    if (value.isEmpty())
+        return 0;
+    return lengthToNm(value.toDouble(), attrs.value(unitName), defaultUnit);
+}
+
+/**
+ * Parse an enumeration value, keeping the given default for missing or invalid values.
+ */
+template<typename Enum>
+static Enum parseEnum(QStringView value, Enum defaultValue)
+{
+    if (value.isEmpty())
+        return defaultValue;
+
+    try {
+        return Enum(value.toString().toStdString());
+    } catch (const std::exception &) {
+        qWarning().noquote() << "OME-XML: Invalid enumeration value:" << value.toString();
+        return defaultValue;
+    }
+}
+
+template<typename Enum>
+static Enum enumAttribute(const QXmlStreamAttributes &attrs, QLatin1StringView name, Enum defaultValue)
+{
+    return parseEnum(attrs.value(name), defaultValue);
+}
+
+static void readChannel(const QXmlStreamAttributes &attrs, ImageMetadata &meta)
+{
+    ChannelParams chParams;
+
+    const auto name = attrs.value("Name"_L1);
+    chParams.name = name.isEmpty() ? QStringLiteral("Channel %1").arg(meta.channels.size()) : name.toString();
+
+    chParams.acquisitionMode = enumAttribute(attrs, "AcquisitionMode"_L1, chParams.acquisitionMode);
+    if (chParams.acquisitionMode == enums::AcquisitionMode::MULTIPHOTONMICROSCOPY)
+        chParams.photonCount = 2; // Default assumption for multiphoton
+
+    chParams.exWavelengthNm = lengthAttribute(attrs, "ExcitationWavelength"_L1, "ExcitationWavelengthUnit"_L1, u"nm");
+    chParams.emWavelengthNm = lengthAttribute(attrs, "EmissionWavelength"_L1, "EmissionWavelengthUnit"_L1, u"nm");
+    chParams.pinholeSizeNm = lengthAttribute(attrs, "PinholeSize"_L1, "PinholeSizeUnit"_L1, u"µm");
+
+    meta.channels.push_back(chParams);
+}
+
+static void readPixels(const QXmlStreamAttributes &attrs, ImageMetadata &meta)
+{
+    meta.sizeX = attrs.value("SizeX"_L1).toInt();
+    meta.sizeY = attrs.value("SizeY"_L1).toInt();
+    meta.sizeZ = attrs.value("SizeZ"_L1).toInt();
+    meta.sizeC = attrs.value("SizeC"_L1).toInt();
+    meta.sizeT = attrs.value("SizeT"_L1).toInt();
+    meta.pixelType = attrs.value("Type"_L1).toString();
+
+    meta.physSizeXNm = lengthAttribute(attrs, "PhysicalSizeX"_L1, "PhysicalSizeXUnit"_L1, u"µm");
+    meta.physSizeYNm = lengthAttribute(attrs, "PhysicalSizeY"_L1, "PhysicalSizeYUnit"_L1, u"µm");
+    meta.physSizeZNm = lengthAttribute(attrs, "PhysicalSizeZ"_L1, "PhysicalSizeZUnit"_L1, u"µm");
+}
+
+std::expected<OmeXmlScanResult, QString> scanOmeXml(QByteArrayView xml, int imageIndex)
+{
+    OmeXmlScanResult result;
+    auto &meta = result.metadata;
+
+    QHash<QString, ObjectiveInfo> objectives;
+    QString objectiveId;
+    bool imageFound = false;
+
+    // The reader only keeps the current token in memory, we never build a tree
+    QXmlStreamReader xmlReader(QByteArray::fromRawData(xml.data(), xml.size()));
+    while (!xmlReader.atEnd()) {
+        if (xmlReader.readNext() != QXmlStreamReader::StartElement)
+            continue;
+
+        const auto name = xmlReader.name();
+        const auto attrs = xmlReader.attributes();
+
+        if (name == u"Objective") {
+            ObjectiveInfo info;
+            info.lensNA = attrs.value("LensNA"_L1).toDouble();
+            info.immersion = attrs.value("Immersion"_L1).toString();
+            objectives.insert(attrs.value("ID"_L1).toString(), info);
+            xmlReader.skipCurrentElement();
+        } else if (name == u"Image") {
+            if (result.imageCount++ != imageIndex) {
+                xmlReader.skipCurrentElement();
+                continue;
+            }
+
+            imageFound = true;
+            const auto imageName = attrs.value("Name"_L1);
+            if (!imageName.isEmpty())
+                meta.imageName = imageName.toString();
+        } else if (name == u"ObjectiveSettings") {
+            objectiveId = attrs.value("ID"_L1).toString();
+            const auto refractiveIndex = attrs.value("RefractiveIndex"_L1);
+            if (!refractiveIndex.isEmpty())
+                meta.immersionRI = refractiveIndex.toDouble();
+            meta.embeddingMedium = enumAttribute(attrs, "Medium"_L1, meta.embeddingMedium);
+        } else if (name == u"Pixels") {
+            readPixels(attrs, meta);
+        } else if (name == u"Channel") {
+            readChannel(attrs, meta);
+            xmlReader.skipCurrentElement();
+        } else if (name == u"Plane") {
+            // this is where huge headers spend their bytes
+            result.planeCount++;
+            xmlReader.skipCurrentElement();
+        } else if (name == u"TiffData" || name == u"MetadataOnly" || name == u"BinData") {
+            xmlReader.skipCurrentElement();
+        } else if (name == u"StructuredAnnotations") {
+            // count the annotations without looking at their content
+            while (xmlReader.readNextStartElement()) {
+                result.annotationCount++;
+                xmlReader.skipCurrentElement();
+            }
+        }
+    }
+
+    if (xmlReader.hasError())
+        return std::unexpected(
+            QStringLiteral("Invalid OME-XML (line %1): %2").arg(xmlReader.lineNumber()).arg(xmlReader.errorString()));
+    if (!imageFound)
+        return std::unexpected(QStringLiteral("OME-XML does not contain an image with index %1").arg(imageIndex));
+
+    // Instruments precede images in the schema, but we do not rely on that
+    const auto objIt = objectives.constFind(objectiveId);
+    if (!objectiveId.isEmpty() && objIt != objectives.cend()) {
+        meta.numericalAperture = objIt->lensNA;
+        meta.lensImmersion = parseEnum(QStringView(objIt->immersion), meta.lensImmersion);
+    }
+
+    return result;
+}
@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <QByteArrayView>
+#include <QString>
+#include <expected>
+
+#include "ometiffimage.h"
+
+/**
+ * @brief Result of a streaming scan of an OME-XML document.
+ */
+struct OmeXmlScanResult {
+    ImageMetadata metadata;     /// Metadata of the requested image, dataSizeBytes is not set
+    int imageCount = 0;         /// Number of Image elements in the document
+    qsizetype planeCount = 0;   /// Number of Plane elements of the requested image
+    qsizetype annotationCount = 0;
+};
+
+/**
+ * @brief Extract the fields of ImageMetadata from OME-XML without building a DOM.
+ *
+ * The document is read in a single forward pass, and everything that is not needed,
+ * like per-plane data and annotations, is skipped without being stored. This keeps
+ * memory usage flat even for multi-megabyte headers.
+ *
+ * @param xml The OME-XML document.
+ * @param imageIndex Index of the Image element to extract.
+ */
+std::expected<OmeXmlScanResult, QString> scanOmeXml(QByteArrayView xml, int imageIndex = 0);
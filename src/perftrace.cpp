@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include "perftrace.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace PerfTrace
+{
+
+// Number of events kept per thread before the oldest ones are overwritten
+static constexpr size_t RingBufferCapacity = 32768;
+
+namespace
+{
+
+struct TraceEvent {
+    const char *name;
+    const char *category;
+    const char *argName;
+    qint64 argValue;
+    qint64 startUs;
+    qint64 durationUs;
+};
+
+struct ThreadBuffer {
+    std::mutex mutex;
+    std::vector<TraceEvent> events;
+    size_t next = 0;
+    bool wrapped = false;
+    int threadId = 0;
+    QString threadName;
+
+    void append(const TraceEvent &event)
+    {
+        // only contended while an export is running
+        std::lock_guard lock(mutex);
+        if (events.empty())
+            events.resize(RingBufferCapacity);
+
+        events[next] = event;
+        next = (next + 1) % events.size();
+        if (next == 0)
+            wrapped = true;
+    }
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    int nextThreadId = 1;
+};
+
+} // namespace
+
+static std::atomic_bool g_enabled = false;
+
+static Registry &registry()
+{
+    static Registry reg;
+    return reg;
+}
+
+static qint64 nowUs()
+{
+    using namespace std::chrono;
+    static const auto epoch = steady_clock::now();
+    return duration_cast<microseconds>(steady_clock::now() - epoch).count();
+}
+
+static ThreadBuffer &threadBuffer()
+{
+    // buffers are shared with the registry, so events of finished threads can still be exported
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+    if (buffer)
+        return *buffer;
+
+    buffer = std::make_shared<ThreadBuffer>();
+
+    auto thread = QThread::currentThread();
+    const auto app = QCoreApplication::instance();
+    if (app && app->thread() == thread)
+        buffer->threadName = QStringLiteral("Main");
+    else if (thread && !thread->objectName().isEmpty())
+        buffer->threadName = thread->objectName();
+
+    auto &reg = registry();
+    std::lock_guard lock(reg.mutex);
+    buffer->threadId = reg.nextThreadId++;
+    if (buffer->threadName.isEmpty())
+        buffer->threadName = QStringLiteral("Worker %1").arg(buffer->threadId);
+    reg.buffers.push_back(buffer);
+
+    return *buffer;
+}
+
+bool isEnabled()
+{
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+void setEnabled(bool enabled)
+{
+    g_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void clear()
+{
+    auto &reg = registry();
+    std::lock_guard lock(reg.mutex);
+    for (const auto &buffer : reg.buffers) {
+        std::lock_guard bufLock(buffer->mutex);
+        buffer->next = 0;
+        buffer->wrapped = false;
+    }
+}
+
+std::expected<qsizetype, QString> exportChromeTrace(const QString &fileName)
+{
+    QJsonArray traceEvents;
+    qsizetype eventCount = 0;
+    const auto pid = static_cast<qint64>(QCoreApplication::applicationPid());
+
+    {
+        auto &reg = registry();
+        std::lock_guard lock(reg.mutex);
+        for (const auto &buffer : reg.buffers) {
+            std::lock_guard bufLock(buffer->mutex);
+
+            QJsonObject nameEvent;
+            nameEvent.insert("name", "thread_name");
+            nameEvent.insert("ph", "M");
+            nameEvent.insert("pid", pid);
+            nameEvent.insert("tid", buffer->threadId);
+            nameEvent.insert("args", QJsonObject{{"name", buffer->threadName}});
+            traceEvents.append(nameEvent);
+
+            // oldest events first
+            const size_t count = buffer->wrapped ? buffer->events.size() : buffer->next;
+            const size_t first = buffer->wrapped ? buffer->next : 0;
+            for (size_t i = 0; i < count; ++i) {
+                const auto &ev = buffer->events[(first + i) % buffer->events.size()];
+
+                QJsonObject obj;
+                obj.insert("name", QString::fromLatin1(ev.name));
+                obj.insert("cat", QString::fromLatin1(ev.category));
+                obj.insert("ph", "X");
+                obj.insert("ts", ev.startUs);
+                obj.insert("dur", ev.durationUs);
+                obj.insert("pid", pid);
+                obj.insert("tid", buffer->threadId);
+                if (ev.argName != nullptr)
+                    obj.insert("args", QJsonObject{{QString::fromLatin1(ev.argName), ev.argValue}});
+                traceEvents.append(obj);
+                ++eventCount;
+            }
+        }
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return std::unexpected(QStringLiteral("Unable to write trace file: %1").arg(file.errorString()));
+
+    QJsonObject root;
+    root.insert("traceEvents", traceEvents);
+    root.insert("displayTimeUnit", "ms");
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+
+    return eventCount;
+}
+
+Span::Span(const char *name, const char *category)
+    : m_name(name),
+      m_category(category)
+{
+    if (isEnabled())
+        m_startUs = nowUs();
+}
+
+Span::~Span()
+{
+    if (m_startUs < 0)
+        return;
+
+    threadBuffer().append({m_name, m_category, m_argName, m_argValue, m_startUs, nowUs() - m_startUs});
+}
+
+void Span::setArg(const char *name, qint64 value)
+{
+    m_argName = name;
+    m_argValue = value;
+}
+
+} // namespace PerfTrace
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <QString>
+#include <expected>
+
+/**
+ * @brief Lightweight tracing of where time is spent.
+ *
+ * Spans are recorded into a fixed-size ring buffer per thread, so recording is cheap
+ * and never blocks other threads. Once enabled, the most recent events of every thread
+ * can be exported in the Chrome trace event format, which can be viewed with Perfetto
+ * (https://ui.perfetto.dev) or chrome://tracing.
+ *
+ * Span names and categories must be string literals, as only their pointers are stored.
+ */
+namespace PerfTrace
+{
+
+[[nodiscard]] bool isEnabled();
+void setEnabled(bool enabled);
+
+/**
+ * @brief Drop all events recorded so far.
+ */
+void clear();
+
+/**
+ * @brief Write all recorded events to a Chrome trace JSON file.
+ * @return Number of exported events.
+ */
+std::expected<qsizetype, QString> exportChromeTrace(const QString &fileName);
+
+/**
+ * @brief Records the time between its construction and destruction.
+ */
+class Span
+{
+public:
+    explicit Span(const char *name, const char *category = "app");
+    ~Span();
+
+    Span(const Span &) = delete;
+    Span &operator=(const Span &) = delete;
+
+    /**
+     * @brief Attach a numeric argument, e.g. a plane index or byte count, to this span.
+     */
+    void setArg(const char *name, qint64 value);
+
+private:
+    const char *m_name;
+    const char *m_category;
+    const char *m_argName = nullptr;
+    qint64 m_argValue = 0;
+    qint64 m_startUs = -1;
+};
+
+} // namespace PerfTrace
+
+#define PERF_TRACE_CONCAT_(a, b) a##b
+#define PERF_TRACE_CONCAT(a, b)  PERF_TRACE_CONCAT_(a, b)
+
+/**
+ * Trace the remainder of the current scope.
+ */
+#define PERF_TRACE_SCOPE(name, category) \
+    PerfTrace::Span PERF_TRACE_CONCAT(perfTraceSpan_, __LINE__)(name, category)
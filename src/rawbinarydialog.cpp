@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include "rawbinarydialog.h"
+
+#include <QComboBox>
+#include <QDialogButtonBox>
+#include <QFileInfo>
+#include <QFormLayout>
+#include <QLabel>
+#include <QPushButton>
+#include <QSettings>
+#include <QSpinBox>
+#include <QVBoxLayout>
+#include <algorithm>
+
+#include <ome/files/PixelProperties.h>
+
+typedef ome::xml::model::enums::PixelType PT;
+
+static QSpinBox *createSizeSpinBox(int minimum, int value, QWidget *parent)
+{
+    auto spin = new QSpinBox(parent);
+    spin->setRange(minimum, 1 << 30);
+    spin->setValue(value);
+    return spin;
+}
+
+RawBinaryDialog::RawBinaryDialog(const QString &filename, QWidget *parent)
+    : QDialog(parent),
+      m_fileSize(QFileInfo(filename).size())
+{
+    setWindowTitle(QStringLiteral("Open Raw Binary File"));
+
+    QSettings settings("OMERewriter", "OMERewriter");
+
+    // suite2p writes 512x512 int16 frames by default
+    m_spinX = createSizeSpinBox(1, settings.value("rawBinary/sizeX", 512).toInt(), this);
+    m_spinY = createSizeSpinBox(1, settings.value("rawBinary/sizeY", 512).toInt(), this);
+    m_spinZ = createSizeSpinBox(1, settings.value("rawBinary/sizeZ", 1).toInt(), this);
+    m_spinC = createSizeSpinBox(1, settings.value("rawBinary/sizeC", 1).toInt(), this);
+    m_spinT = createSizeSpinBox(0, settings.value("rawBinary/sizeT", 0).toInt(), this);
+    m_spinT->setSpecialValueText(QStringLiteral("From file size"));
+    m_spinHeader = createSizeSpinBox(0, settings.value("rawBinary/headerBytes", 0).toInt(), this);
+    m_spinHeader->setSuffix(QStringLiteral(" bytes"));
+
+    m_pixelTypeCombo = new QComboBox(this);
+    for (const auto pt : {PT::INT16, PT::UINT16, PT::INT8, PT::UINT8, PT::INT32, PT::UINT32, PT::FLOAT, PT::DOUBLE}) {
+        const auto name = QString::fromStdString(std::string(PT(pt)));
+        m_pixelTypeCombo->addItem(name, name);
+    }
+    m_pixelTypeCombo->setCurrentIndex(
+        std::max(m_pixelTypeCombo->findData(settings.value("rawBinary/pixelType", "int16").toString()), 0));
+
+    m_byteOrderCombo = new QComboBox(this);
+    m_byteOrderCombo->addItem(QStringLiteral("Little endian"), false);
+    m_byteOrderCombo->addItem(QStringLiteral("Big endian"), true);
+    m_byteOrderCombo->setCurrentIndex(settings.value("rawBinary/bigEndian", false).toBool() ? 1 : 0);
+
+    m_summaryLabel = new QLabel(this);
+    m_summaryLabel->setWordWrap(true);
+
+    auto form = new QFormLayout;
+    form->addRow(QStringLiteral("Width (X):"), m_spinX);
+    form->addRow(QStringLiteral("Height (Y):"), m_spinY);
+    form->addRow(QStringLiteral("Slices (Z):"), m_spinZ);
+    form->addRow(QStringLiteral("Channels (C):"), m_spinC);
+    form->addRow(QStringLiteral("Time points (T):"), m_spinT);
+    form->addRow(QStringLiteral("Pixel type:"), m_pixelTypeCombo);
+    form->addRow(QStringLiteral("Byte order:"), m_byteOrderCombo);
+    form->addRow(QStringLiteral("Header:"), m_spinHeader);
+
+    m_buttonBox = new QDialogButtonBox(QDialogButtonBox::Open | QDialogButtonBox::Cancel, this);
+
+    auto layout = new QVBoxLayout(this);
+    layout->addWidget(new QLabel(
+        QStringLiteral("Please describe the layout of '%1'.\n"
+                       "Planes are expected one after another, in XYZCT order.")
+            .arg(QFileInfo(filename).fileName()),
+        this));
+    layout->addLayout(form);
+    layout->addWidget(m_summaryLabel);
+    layout->addWidget(m_buttonBox);
+
+    for (auto spin : {m_spinX, m_spinY, m_spinZ, m_spinC, m_spinT, m_spinHeader})
+        connect(spin, &QSpinBox::valueChanged, this, &RawBinaryDialog::updateSummary);
+    connect(m_pixelTypeCombo, &QComboBox::currentIndexChanged, this, &RawBinaryDialog::updateSummary);
+    connect(m_buttonBox, &QDialogButtonBox::accepted, this, &QDialog::accept);
+    connect(m_buttonBox, &QDialogButtonBox::rejected, this, &QDialog::reject);
+
+    updateSummary();
+}
+
+RawBinaryDialog::~RawBinaryDialog()
+{
+    if (result() != QDialog::Accepted)
+        return;
+
+    QSettings settings("OMERewriter", "OMERewriter");
+    settings.setValue("rawBinary/sizeX", m_spinX->value());
+    settings.setValue("rawBinary/sizeY", m_spinY->value());
+    settings.setValue("rawBinary/sizeZ", m_spinZ->value());
+    settings.setValue("rawBinary/sizeC", m_spinC->value());
+    settings.setValue("rawBinary/sizeT", m_spinT->value());
+    settings.setValue("rawBinary/pixelType", m_pixelTypeCombo->currentData().toString());
+    settings.setValue("rawBinary/bigEndian", m_byteOrderCombo->currentData().toBool());
+    settings.setValue("rawBinary/headerBytes", m_spinHeader->value());
+}
+
+RawBinaryLayout RawBinaryDialog::layout() const
+{
+    RawBinaryLayout layout;
+    layout.sizeX = m_spinX->value();
+    layout.sizeY = m_spinY->value();
+    layout.sizeZ = m_spinZ->value();
+    layout.sizeC = m_spinC->value();
+    layout.sizeT = m_spinT->value();
+    layout.pixelType = PT(m_pixelTypeCombo->currentData().toString().toStdString());
+    layout.bigEndian = m_byteOrderCombo->currentData().toBool();
+    layout.headerBytes = m_spinHeader->value();
+    return layout;
+}
+
+bool RawBinaryDialog::hasRawBinaryExtension(const QString &filename)
+{
+    const auto suffix = QFileInfo(filename).suffix().toLower();
+    return suffix == QStringLiteral("bin") || suffix == QStringLiteral("dat") || suffix == QStringLiteral("raw");
+}
+
+void RawBinaryDialog::updateSummary()
+{
+    const auto l = layout();
+    const auto planeBytes = static_cast<qint64>(l.sizeX) * l.sizeY * (ome::files::bitsPerPixel(l.pixelType) / 8);
+    const auto planes = std::max<qint64>(m_fileSize - l.headerBytes, 0) / planeBytes;
+    const auto planesPerVolume = static_cast<qint64>(l.sizeZ) * l.sizeC;
+    const auto sizeT = l.sizeT > 0 ? l.sizeT : std::max<qint64>(planes / planesPerVolume, 1);
+    const auto needed = planesPerVolume * sizeT;
+
+    const bool fits = planes >= needed;
+    if (!fits)
+        m_summaryLabel->setText(QStringLiteral("The file is too small for this layout: it holds %1 planes, "
+                                               "but %2 are needed.")
+                                    .arg(planes)
+                                    .arg(needed));
+    else if (l.sizeT == 0)
+        m_summaryLabel->setText(QStringLiteral("The file holds %1 time points.").arg(planes / planesPerVolume));
+    else
+        m_summaryLabel->setText(QStringLiteral("The file holds %1 planes, %2 of them are used.")
+                                    .arg(planes)
+                                    .arg(needed));
+
+    m_buttonBox->button(QDialogButtonBox::Open)->setEnabled(fits);
+}
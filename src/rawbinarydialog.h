@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <QDialog>
+
+#include "ometiffimage.h"
+
+class QComboBox;
+class QDialogButtonBox;
+class QLabel;
+class QSpinBox;
+
+/**
+ * @brief Dialog asking for the shape and sample format of a headerless binary file.
+ *
+ * The last used layout is remembered, as binary files of one setup usually share it.
+ */
+class RawBinaryDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit RawBinaryDialog(const QString &filename, QWidget *parent = nullptr);
+    ~RawBinaryDialog() override;
+
+    [[nodiscard]] RawBinaryLayout layout() const;
+
+    /**
+     * @brief Check whether a file name has one of the extensions used for headerless binary data.
+     */
+    static bool hasRawBinaryExtension(const QString &filename);
+
+private:
+    void updateSummary();
+
+    qint64 m_fileSize;
+    QSpinBox *m_spinX;
+    QSpinBox *m_spinY;
+    QSpinBox *m_spinZ;
+    QSpinBox *m_spinC;
+    QSpinBox *m_spinT;
+    QSpinBox *m_spinHeader;
+    QComboBox *m_pixelTypeCombo;
+    QComboBox *m_byteOrderCombo;
+    QLabel *m_summaryLabel;
+    QDialogButtonBox *m_buttonBox;
+};
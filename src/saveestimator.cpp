@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include "saveestimator.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QRandomGenerator>
+#include <QStorageInfo>
+#include <QStringList>
+#include <QThread>
+#include <algorithm>
+
+#include <ome/files/VariantPixelBuffer.h>
+
+#include "codecselector.h"
+#include "hdf5exporter.h"
+#include "perftrace.h"
+#include "utils.h"
+
+using ome::files::VariantPixelBuffer;
+
+// Room on top of the estimated output, for the OME-XML and the error of the estimate
+static constexpr double SizeMargin = 1.05;
+static constexpr quint64 MinFreeBytes = 64ULL * 1024 * 1024;
+
+// TIFF directory and strip tables written for every plane
+static constexpr quint64 TiffPlaneOverheadBytes = 512;
+
+QString SaveEstimate::summary() const
+{
+    QStringList lines;
+    lines.append(QStringLiteral("Output: about %1 (%2 planes, %3 of source data, %4)")
+                     .arg(formatDataSize(bytesOut))
+                     .arg(planes)
+                     .arg(formatDataSize(bytesIn), codec));
+    lines.append(QStringLiteral("Duration: about %1").arg(formatDuration(static_cast<qint64>(seconds + 0.5))));
+    lines.append(QStringLiteral("Memory: about %1 of pixel data").arg(formatDataSize(peakMemoryBytes)));
+    if (bytesAvailable >= 0)
+        lines.append(QStringLiteral("Disk space: %1 needed, %2 available")
+                         .arg(formatDataSize(bytesRequired), formatDataSize(static_cast<size_t>(bytesAvailable))));
+    else
+        lines.append(QStringLiteral("Disk space: %1 needed").arg(formatDataSize(bytesRequired)));
+    lines.append(QStringLiteral("Extrapolated from %1 sampled planes").arg(samplePlanes));
+
+    return lines.join(QLatin1Char('\n'));
+}
+
+QJsonObject SaveEstimate::toJson() const
+{
+    return QJsonObject{
+        {"planes", static_cast<qint64>(planes)},
+        {"samplePlanes", static_cast<qint64>(samplePlanes)},
+        {"bytesIn", static_cast<qint64>(bytesIn)},
+        {"bytesOut", static_cast<qint64>(bytesOut)},
+        {"seconds", seconds},
+        {"peakMemoryBytes", static_cast<qint64>(peakMemoryBytes)},
+        {"bytesRequired", static_cast<qint64>(bytesRequired)},
+        {"bytesAvailable", bytesAvailable},
+        {"codec", codec},
+        {"fitsOnVolume", fitsOnVolume()},
+    };
+}
+
+SaveEstimator::SaveEstimator(OMETiffImage &image, const SaveRequest &request)
+    : m_image(image),
+      m_request(request)
+{
+}
+
+std::expected<SaveEstimate, QString> SaveEstimator::estimate(quint64 samplePlanes)
+{
+    if (!m_image.isOpen())
+        return std::unexpected(QStringLiteral("No image data loaded"));
+
+    PERF_TRACE_SCOPE("SaveEstimator::estimate", "save");
+    const bool toHdf5 = Hdf5Exporter::hasHdf5Extension(m_request.destPath);
+    if (toHdf5 && (m_image.frameBinning() > 1 || m_image.pixelConversion() != PixelConversion::None))
+        return std::unexpected(
+            QStringLiteral("Frames can not be combined, and pixel types not converted, when writing HDF5 files"));
+
+    auto compression = m_request.compression;
+    auto hdf5Options = m_request.hdf5Options;
+    if (m_request.compressionGoal) {
+        CodecSelector selector(m_image, m_request.compressionGoal.value());
+        const auto choice = toHdf5 ? selector.selectHdf5Compression(hdf5Options) : selector.selectTiffCompression();
+        if (!choice)
+            return std::unexpected(choice.error());
+        choice->applyTo(compression, hdf5Options);
+    }
+
+    SaveEstimate est;
+    est.planes = m_image.outputPlaneCount();
+    if (est.planes == 0)
+        return std::unexpected(QStringLiteral("The image has no planes to save"));
+    est.bytesIn = est.planes * m_image.frameBinning() * m_image.planeSizeBytes();
+
+    // the HDF5 exporter compresses chunks on all cores, libtiff on the writing thread only
+    const auto encoder = toHdf5 ? hdf5Options : tiffCompressionModel(compression);
+    const auto threads = toHdf5 ? std::max(QThread::idealThreadCount(), 1) : 1;
+    est.codec = toHdf5 ? CodecTrial{hdf5Options.compression, hdf5Options.level, hdf5Options.shuffle}.name()
+                       : tiffCompressionName(compression);
+
+    // one plane from a random position in each of evenly sized runs of planes
+    const auto count = std::min(std::max<quint64>(samplePlanes, 1), est.planes);
+    quint64 sampleOut = 0;
+    qint64 readNs = 0;
+    qint64 encodeNs = 0;
+    QElapsedTimer timer;
+    for (quint64 i = 0; i < count; ++i) {
+        const auto first = i * est.planes / count;
+        const auto last = (i + 1) * est.planes / count;
+        const auto outPlane = first
+                              + static_cast<quint64>(
+                                  QRandomGenerator::global()->bounded(static_cast<qint64>(last - first)));
+
+        timer.start();
+        const auto plane = m_image.readOutputPlane(outPlane);
+        readNs += timer.nsecsElapsed();
+        if (!plane)
+            return std::unexpected(plane.error());
+
+        bool encoded = true;
+        std::visit(
+            [&](const auto &pixels) {
+                if (!pixels)
+                    return;
+                const auto elementSize = sizeof(*pixels->data());
+                const auto data = reinterpret_cast<const unsigned char *>(pixels->data());
+                const auto bytes = pixels->num_elements() * elementSize;
+
+                auto block = toHdf5 ? static_cast<size_t>(hdf5Options.chunkFrames) * hdf5Options.chunkY
+                                          * hdf5Options.chunkX * elementSize
+                                    : TiffModelBlockBytes;
+                block = std::max(block - block % elementSize, elementSize);
+                for (size_t offset = 0; offset < bytes && encoded; offset += block) {
+                    std::vector<unsigned char> chunk(data + offset, data + std::min(offset + block, bytes));
+                    timer.start();
+                    const auto out = encoder.encode(std::move(chunk), elementSize);
+                    encodeNs += timer.nsecsElapsed();
+                    encoded = !out.empty();
+                    sampleOut += out.size();
+                }
+            },
+            plane.value()->vbuffer());
+        if (!encoded)
+            return std::unexpected(QStringLiteral("Failed to compress output plane %1").arg(outPlane));
+    }
+
+    const auto scale = static_cast<double>(est.planes) / static_cast<double>(count);
+    est.samplePlanes = count;
+    est.bytesOut = static_cast<quint64>(static_cast<double>(sampleOut) * scale);
+    if (!toHdf5)
+        est.bytesOut += est.planes * TiffPlaneOverheadBytes;
+
+    // a pixel type conversion reads all planes once more, to find the value range
+    auto sampleNs = static_cast<double>(readNs) + static_cast<double>(encodeNs) / threads;
+    if (m_image.pixelConversion() != PixelConversion::None)
+        sampleNs += static_cast<double>(readNs);
+    est.seconds = sampleNs * scale / 1e9;
+
+    est.peakMemoryBytes = toHdf5 ? (2 * static_cast<quint64>(hdf5Options.chunkFrames) + 1) * m_image.planeSizeBytes()
+                                 : m_image.saveMemoryBytes();
+    est.bytesRequired = static_cast<quint64>(static_cast<double>(est.bytesOut) * SizeMargin) + MinFreeBytes;
+    est.bytesAvailable = bytesAvailable();
+
+    qDebug().noquote() << "Estimated save of" << m_request.sourcePath << "from" << count << "planes:" << est.toJson();
+    return est;
+}
+
+std::expected<bool, QString> SaveEstimator::checkFreeSpace()
+{
+    const auto available = bytesAvailable();
+    if (available < 0)
+        return true;
+
+    // combining frames or converting pixels at most doubles the width of a sample
+    const auto upperBound = 2 * m_image.outputPlaneCount() * m_image.planeSizeBytes();
+    if (static_cast<quint64>(available) >= static_cast<quint64>(upperBound * SizeMargin) + MinFreeBytes)
+        return true;
+
+    const auto est = estimate();
+    if (!est) {
+        qWarning().noquote() << "Unable to estimate the size of" << m_request.destPath << ":" << est.error();
+        return true;
+    }
+    if (est->fitsOnVolume())
+        return true;
+
+    return std::unexpected(QStringLiteral("Not enough free space to write %1: about %2 are needed, but only %3 are "
+                                          "available.")
+                               .arg(m_request.destPath,
+                                    formatDataSize(est->bytesRequired),
+                                    formatDataSize(static_cast<size_t>(available))));
+}
+
+qint64 SaveEstimator::bytesAvailable() const
+{
+    const QStorageInfo storage(QFileInfo(m_request.destPath).absolutePath());
+    if (!storage.isValid() || !storage.isReady())
+        return -1;
+
+    return storage.bytesAvailable();
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <QJsonObject>
+#include <QString>
+#include <expected>
+
+#include "ometiffimage.h"
+#include "savejob.h"
+
+/**
+ * @brief Expected cost of a save, extrapolated from a sample of planes.
+ */
+struct SaveEstimate {
+    quint64 planes = 0;          /// Planes that will be written
+    quint64 samplePlanes = 0;    /// Planes the estimate was extrapolated from
+    quint64 bytesIn = 0;         /// Source pixel data that will be read
+    quint64 bytesOut = 0;        /// Expected size of the written file
+    double seconds = 0;          /// Expected duration of the save
+    quint64 peakMemoryBytes = 0; /// Expected memory used for pixel data at the same time
+    quint64 bytesRequired = 0;   /// Free space needed next to the destination while writing
+    qint64 bytesAvailable = -1;  /// Free space on the volume of the destination, -1 if unknown
+    QString codec;               /// Compression the estimate was made for
+
+    [[nodiscard]] bool fitsOnVolume() const
+    {
+        return bytesAvailable < 0 || static_cast<quint64>(bytesAvailable) >= bytesRequired;
+    }
+
+    /**
+     * @brief Describe the estimate in a few lines of text.
+     */
+    [[nodiscard]] QString summary() const;
+
+    [[nodiscard]] QJsonObject toJson() const;
+};
+
+/**
+ * @brief Estimates the output size, duration and disk space of a save before running it.
+ *
+ * Planes are sampled at a random position within evenly sized strata of the output,
+ * read with frames combined and pixels converted as the request asks for, and
+ * compressed like the writer would. Size and time of the whole save are extrapolated
+ * from the sample. If the request selects the compression automatically, it is
+ * chosen first, like the save would.
+ */
+class SaveEstimator
+{
+public:
+    /**
+     * @param image The source of the request, opened and set up as the save will use it.
+     */
+    SaveEstimator(OMETiffImage &image, const SaveRequest &request);
+
+    std::expected<SaveEstimate, QString> estimate(quint64 samplePlanes = 16);
+
+    /**
+     * @brief Check that the volume of the destination can hold the output.
+     *
+     * Planes are only sampled if the output might not fit even without compression,
+     * so this is cheap for the common case of plenty of free space.
+     * @return An error describing the shortfall if the output will not fit.
+     */
+    std::expected<bool, QString> checkFreeSpace();
+
+private:
+    [[nodiscard]] qint64 bytesAvailable() const;
+
+    OMETiffImage &m_image;
+    SaveRequest m_request;
+};
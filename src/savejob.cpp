@@ -0,0 +1,694 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include "savejob.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPromise>
+#include <QSaveFile>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QtConcurrent/QtConcurrentRun>
+#include <optional>
+
+#include "config.h"
+#include "metadatajson.h"
+#include "omexmlpatcher.h"
+#include "omexmlscanner.h"
+#include "perftrace.h"
+#include "saveestimator.h"
+#include "tiffstripreader.h"
+#include "utils.h"
+
+// Minimum time between two progress notifications, in msec
+static constexpr qint64 ProgressUpdateIntervalMs = 100;
+
+// Weight of the newest sample in the smoothed throughput
+static constexpr double RateSmoothingFactor = 0.3;
+
+// Number of job reports kept before the oldest ones are removed
+static constexpr int MaxKeptReports = 200;
+
+QString pixelConversionName(PixelConversion conversion)
+{
+    switch (conversion) {
+    case PixelConversion::None:
+        return QStringLiteral("none");
+    case PixelConversion::ScaleToUInt16:
+        return QStringLiteral("uint16");
+    case PixelConversion::ScaleToUInt8:
+        return QStringLiteral("uint8");
+    case PixelConversion::OffsetToUInt16:
+        return QStringLiteral("offset-uint16");
+    }
+
+    return {};
+}
+
+std::optional<PixelConversion> pixelConversionFromName(const QString &name)
+{
+    for (const auto conversion :
+         {PixelConversion::None,
+          PixelConversion::ScaleToUInt16,
+          PixelConversion::ScaleToUInt8,
+          PixelConversion::OffsetToUInt16}) {
+        if (pixelConversionName(conversion) == name)
+            return conversion;
+    }
+
+    return std::nullopt;
+}
+
+QString tiffCompressionName(TiffCompression compression)
+{
+    switch (compression) {
+    case TiffCompression::Deflate:
+        return QStringLiteral("deflate");
+    case TiffCompression::Zstd:
+        return QStringLiteral("zstd");
+    }
+
+    return {};
+}
+
+std::optional<TiffCompression> tiffCompressionFromName(const QString &name)
+{
+    for (const auto compression : {TiffCompression::Deflate, TiffCompression::Zstd}) {
+        if (tiffCompressionName(compression) == name)
+            return compression;
+    }
+
+    return std::nullopt;
+}
+
+/**
+ * Apply the parameter set of a request to the metadata the source image already has.
+ */
+static ImageMetadata applyRequestParameters(
+    const SaveRequest &request,
+    const ImageMetadata &imageMeta,
+    QString &warning)
+{
+    if (request.metadata.channels.size() != imageMeta.channels.size())
+        warning = QStringLiteral(
+                      "The parameters have %1 channel(s), but the image has %2 channel(s). "
+                      "Only the overlapping channels were updated.")
+                      .arg(request.metadata.channels.size())
+                      .arg(imageMeta.channels.size());
+
+    return MetadataJson::applyParameters(request.metadata, imageMeta);
+}
+
+/**
+ * Read how the pixel data of a TIFF file is compressed, from its first directory.
+ * Returns nothing for compressions we do not write, or if the file can not be read.
+ */
+static std::optional<TiffCompression> readTiffCompression(const QString &path)
+{
+    TiffStripReader reader(path);
+    if (!reader.open() || reader.directoryCount() == 0)
+        return std::nullopt;
+    const auto entries = reader.entries(0);
+    if (!entries)
+        return std::nullopt;
+
+    quint64 compression = 1; // none, if the tag is missing
+    for (const auto &entry : entries.value()) {
+        if (entry.tag != 259)
+            continue;
+        const auto values = reader.readValues(entry);
+        if (!values || values->empty())
+            return std::nullopt;
+        compression = values->front();
+    }
+
+    switch (compression) {
+    case 8:     // Adobe Deflate
+    case 32946: // Deflate
+        return TiffCompression::Deflate;
+    case 50000:
+        return TiffCompression::Zstd;
+    default:
+        return std::nullopt;
+    }
+}
+
+/**
+ * Save by patching the OME-XML header of an OME-TIFF, keeping its pixel data.
+ * Returns nothing if this is not possible and the image has to be rewritten in full.
+ */
+static std::optional<SaveJob::Result> runHeaderOnlySave(const SaveRequest &request, SaveStatistics &stats)
+{
+    if (!OMETiffImage::hasOmeTiffExtension(request.sourcePath) || !OMETiffImage::hasOmeTiffExtension(request.destPath)
+        || request.interleavedChannels > 1 || request.framesPerSlice > 1
+        || request.pixelConversion != PixelConversion::None)
+        return std::nullopt;
+
+    // the pixel data is kept as it is, so it must already be stored the way the request asks for
+    if (request.compressionGoal || request.deduplicatePlanes
+        || readTiffCompression(request.sourcePath) != request.compression)
+        return std::nullopt;
+
+    QSettings settings("OMERewriter", "OMERewriter");
+    if (!settings.value("saving/allowHeaderOnlyRewrite", true).toBool())
+        return std::nullopt;
+
+    PERF_TRACE_SCOPE("SaveJob::headerOnlySave", "save");
+    QElapsedTimer totalTimer;
+    QElapsedTimer stageTimer;
+    totalTimer.start();
+    stageTimer.start();
+    const auto msecsSince = [](const QElapsedTimer &timer) {
+        return timer.nsecsElapsed() / 1000000.0;
+    };
+
+    const auto xml = OMETiffImage::readOmeXml(request.sourcePath);
+    if (!xml)
+        return std::nullopt;
+
+    auto metadata = request.metadata;
+    QString warning;
+    if (request.applyAsParameters) {
+        const auto scan = scanOmeXml(QByteArrayView(xml->data(), static_cast<qsizetype>(xml->size())));
+        if (!scan)
+            return std::nullopt;
+        metadata = applyRequestParameters(request, scan->metadata, warning);
+    }
+    stats.metadataMs = msecsSince(stageTimer);
+
+    const QFileInfo sourceFi(request.sourcePath);
+    const QFileInfo destFi(request.destPath);
+    const bool inPlace = sourceFi == destFi;
+
+    stageTimer.start();
+    int changeCount = 0;
+    auto patched = patchOmeXml(xml.value(), metadata, 0, inPlace ? QString() : destFi.fileName(), &changeCount);
+    if (!patched) {
+        qDebug().noquote() << "Rewriting all image data, OME-XML can not be patched:" << patched.error();
+        return std::nullopt;
+    }
+    stats.xmlPatchMs = msecsSince(stageTimer);
+    stats.headerOnly = true;
+    qDebug().noquote() << "Patching" << changeCount << "OME-XML attributes of" << request.destPath;
+
+    SaveJob::Output output;
+    output.warning = warning;
+    if (inPlace) {
+        // the header is replaced once the viewer has let go of the file
+        output.inPlace = true;
+        output.headerXml = std::move(patched.value());
+        stats.totalMs = msecsSince(totalTimer);
+        return SaveJob::Result(output);
+    }
+
+    QTemporaryDir tempDir(destFi.absoluteDir().absoluteFilePath("_temp-omewrite"));
+    if (!tempDir.isValid())
+        return SaveJob::Result(std::unexpected(QStringLiteral("Failed to create temporary directory.")));
+    const auto tempFile = tempDir.filePath(destFi.fileName());
+
+    stageTimer.start();
+    if (!QFile::copy(request.sourcePath, tempFile))
+        return SaveJob::Result(std::unexpected(QStringLiteral("Failed to copy %1").arg(request.sourcePath)));
+    const auto r = OMETiffImage::writeOmeXml(tempFile, patched.value());
+    if (!r)
+        return SaveJob::Result(std::unexpected(r.error()));
+    stats.writeMs = msecsSince(stageTimer);
+    stats.bytesOut = static_cast<quint64>(QFileInfo(tempFile).size());
+    stats.totalMs = msecsSince(totalTimer);
+
+    tempDir.setAutoRemove(false);
+    output.tempFile = tempFile;
+    return SaveJob::Result(output);
+}
+
+/**
+ * Remove the temporary directory of a written file that will not be moved into place.
+ */
+static void discardOutput(const SaveJob::Result &result)
+{
+    if (result && !result->tempFile.isEmpty())
+        QDir(QFileInfo(result->tempFile).absolutePath()).removeRecursively();
+}
+
+/**
+ * Report the result of the worker, dropping its written file if the job was cancelled in the meantime.
+ */
+static void reportOutput(QPromise<SaveJob::Result> &promise, const SaveJob::Result &result)
+{
+    if (!promise.addResult(result))
+        discardOutput(result);
+}
+
+static void runSave(
+    QPromise<SaveJob::Result> &promise,
+    const SaveRequest &request,
+    const std::shared_ptr<std::atomic<quint64>> &planeBytes,
+    const std::shared_ptr<SaveStatistics> &stats)
+{
+    PERF_TRACE_SCOPE("SaveJob", "save");
+
+    if (auto headerResult = runHeaderOnlySave(request, *stats)) {
+        promise.setProgressRange(0, 1);
+        promise.setProgressValue(1);
+        reportOutput(promise, headerResult.value());
+        return;
+    }
+    *stats = {};
+
+    OMETiffImage image;
+    bool opened;
+    if (request.rawBinaryLayout) {
+        const auto r = image.openRawBinary(request.sourcePath, *request.rawBinaryLayout);
+        if (!r) {
+            promise.addResult(SaveJob::Result(std::unexpected(r.error())));
+            return;
+        }
+        opened = true;
+    } else if (QFileInfo(request.sourcePath).isDir())
+        opened = image.openFolder(request.sourcePath, request.folderPattern);
+    else if (request.seriesFiles.size() > 1)
+        opened = image.openSeries(request.seriesFiles);
+    else
+        opened = image.open(request.sourcePath);
+    if (!opened) {
+        promise.addResult(
+            SaveJob::Result(std::unexpected(QStringLiteral("Failed to open file: %1").arg(request.sourcePath))));
+        return;
+    }
+
+    if (request.interleavedChannels > 1) {
+        const auto r = image.setInterleavedChannelCount(request.interleavedChannels);
+        if (!r) {
+            promise.addResult(SaveJob::Result(std::unexpected(r.error())));
+            return;
+        }
+    }
+    if (request.framesPerSlice > 1) {
+        const auto r = image.setFrameBinning(request.framesPerSlice, request.frameBinMode);
+        if (!r) {
+            promise.addResult(SaveJob::Result(std::unexpected(r.error())));
+            return;
+        }
+    }
+    if (request.pixelConversion != PixelConversion::None) {
+        const auto r = image.setPixelConversion(request.pixelConversion);
+        if (!r) {
+            promise.addResult(SaveJob::Result(std::unexpected(r.error())));
+            return;
+        }
+    }
+
+    auto metadata = request.metadata;
+    QString warning;
+    if (request.applyAsParameters)
+        metadata = applyRequestParameters(request, image.extractMetadata(), warning);
+
+    // Create a temporary directory in the same location as the destination
+    // This ensures: 1) disk space available, 2) same filesystem for atomic move
+    // 3) correct filename in OME-XML metadata (no temp filename warnings)
+    const QFileInfo destFi(request.destPath);
+    QTemporaryDir tempDir(destFi.absoluteDir().absoluteFilePath("_temp-omewrite"));
+    if (!tempDir.isValid()) {
+        promise.addResult(SaveJob::Result(std::unexpected(QStringLiteral("Failed to create temporary directory."))));
+        return;
+    }
+    tempDir.setAutoRemove(true);
+    const auto tempFile = tempDir.filePath(destFi.fileName());
+
+    planeBytes->store(image.planeSizeBytes());
+    promise.setProgressRange(0, static_cast<int>(image.imageCount() / image.frameBinning()));
+
+    QElapsedTimer progressTimer;
+    progressTimer.start();
+    const auto progressCallback = [&promise, &progressTimer](
+                                      OMETiffImage::dimension_size_type current, OMETiffImage::dimension_size_type) {
+        if (progressTimer.elapsed() >= ProgressUpdateIntervalMs) {
+            promise.setProgressValue(static_cast<int>(current));
+            progressTimer.restart();
+        }
+        return !promise.isCanceled();
+    };
+
+    // pick the compression that suits this data best, if the request leaves it to us
+    const bool toHdf5 = Hdf5Exporter::hasHdf5Extension(request.destPath);
+    auto hdf5Options = request.hdf5Options;
+    auto compression = request.compression;
+    QJsonObject codecChoice;
+    if (request.compressionGoal) {
+        CodecSelector selector(image, request.compressionGoal.value());
+        const auto choice = toHdf5 ? selector.selectHdf5Compression(hdf5Options) : selector.selectTiffCompression();
+        if (!choice) {
+            promise.addResult(SaveJob::Result(std::unexpected(choice.error())));
+            return;
+        }
+        choice->applyTo(compression, hdf5Options);
+        codecChoice = choice->toJson();
+    }
+
+    // refuse before spending hours on a file that does not fit
+    auto chosenRequest = request;
+    chosenRequest.compressionGoal.reset();
+    chosenRequest.compression = compression;
+    chosenRequest.hdf5Options = hdf5Options;
+    const auto space = SaveEstimator(image, chosenRequest).checkFreeSpace();
+    if (!space) {
+        promise.addResult(SaveJob::Result(std::unexpected(space.error())));
+        return;
+    }
+
+    std::expected<bool, QString> result;
+    if (toHdf5) {
+        result = Hdf5Exporter(image, hdf5Options).write(tempFile, metadata, progressCallback, stats.get());
+    } else {
+        result = image.setCompression(compression);
+        image.setDeduplicatePlanes(request.deduplicatePlanes);
+        if (result)
+            result = image.saveWithMetadata(tempFile, metadata, progressCallback, stats.get());
+    }
+
+    if (!result) {
+        promise.addResult(SaveJob::Result(std::unexpected(result.error())));
+        return;
+    }
+
+    // keep the written file around, it is moved into place by the job
+    tempDir.setAutoRemove(false);
+    SaveJob::Output output;
+    output.tempFile = tempFile;
+    output.warning = warning;
+    output.codecChoice = codecChoice;
+    reportOutput(promise, SaveJob::Result(output));
+}
+
+SaveJob::SaveJob(const SaveRequest &request, QObject *parent)
+    : QObject(parent),
+      m_request(request),
+      m_planeBytes(std::make_shared<std::atomic<quint64>>(0)),
+      m_stats(std::make_shared<SaveStatistics>())
+{
+    connect(&m_watcher, &QFutureWatcher<Result>::progressValueChanged, this, &SaveJob::onWorkerProgress);
+    connect(&m_watcher, &QFutureWatcher<Result>::finished, this, &SaveJob::onWorkerFinished);
+}
+
+SaveJob::~SaveJob()
+{
+    // never leave a worker behind that writes to a file nobody will pick up
+    m_watcher.disconnect(this);
+    if (m_future.isRunning()) {
+        m_future.cancel();
+        m_future.waitForFinished();
+    }
+
+    // drop data that was written, but never committed
+    if (!m_handled && m_future.resultCount() > 0)
+        discardOutput(m_future.result());
+}
+
+const SaveRequest &SaveJob::request() const
+{
+    return m_request;
+}
+
+void SaveJob::start(QThreadPool *pool)
+{
+    if (m_state != State::Queued)
+        return;
+
+    m_state = State::Running;
+    m_rateTimer.start();
+    m_jobTimer.start();
+    m_future = QtConcurrent::run(
+        pool ? pool : QThreadPool::globalInstance(), runSave, m_request, m_planeBytes, m_stats);
+    m_watcher.setFuture(m_future);
+    emit started();
+}
+
+void SaveJob::cancel()
+{
+    if (m_state == State::Queued) {
+        finish(State::Cancelled, QStringLiteral("Save operation cancelled by user"));
+        return;
+    }
+
+    m_future.cancel();
+}
+
+SaveJob::State SaveJob::state() const
+{
+    return m_state;
+}
+
+bool SaveJob::isRunning() const
+{
+    return m_state == State::Running;
+}
+
+bool SaveJob::isDone() const
+{
+    return m_state != State::Queued && m_state != State::Running;
+}
+
+int SaveJob::planesDone() const
+{
+    return m_planesDone;
+}
+
+int SaveJob::planesTotal() const
+{
+    return m_watcher.progressMaximum();
+}
+
+quint64 SaveJob::bytesDone() const
+{
+    return m_planeBytes->load() * static_cast<quint64>(m_planesDone);
+}
+
+quint64 SaveJob::bytesTotal() const
+{
+    return m_planeBytes->load() * static_cast<quint64>(planesTotal());
+}
+
+double SaveJob::bytesPerSecond() const
+{
+    return m_bytesPerSecond;
+}
+
+qint64 SaveJob::remainingSecs() const
+{
+    if (m_bytesPerSecond <= 0 || m_state != State::Running)
+        return -1;
+    return static_cast<qint64>(static_cast<double>(bytesTotal() - bytesDone()) / m_bytesPerSecond);
+}
+
+SaveStatistics SaveJob::statistics() const
+{
+    if (m_state != State::Succeeded)
+        return {};
+    return *m_stats;
+}
+
+QString SaveJob::reportPath() const
+{
+    return m_reportPath;
+}
+
+void SaveJob::onWorkerProgress(int value)
+{
+    m_planesDone = value;
+
+    const auto elapsedMs = m_rateTimer.elapsed();
+    const auto bytes = bytesDone();
+    if (elapsedMs > 0 && bytes >= m_lastRateBytes) {
+        const double rate = static_cast<double>(bytes - m_lastRateBytes) * 1000.0 / static_cast<double>(elapsedMs);
+        m_bytesPerSecond = m_bytesPerSecond > 0
+                               ? (RateSmoothingFactor * rate) + ((1.0 - RateSmoothingFactor) * m_bytesPerSecond)
+                               : rate;
+        m_lastRateBytes = bytes;
+        m_rateTimer.restart();
+    }
+
+    emit progressChanged(value, m_watcher.progressMaximum());
+}
+
+void SaveJob::onWorkerFinished()
+{
+    m_handled = true;
+    if (m_future.isCanceled() || m_future.resultCount() == 0) {
+        if (m_future.resultCount() > 0)
+            discardOutput(m_future.result());
+        finish(State::Cancelled, QStringLiteral("Save operation cancelled by user"));
+        return;
+    }
+
+    const auto result = m_future.result();
+    if (!result) {
+        finish(State::Failed, result.error());
+        return;
+    }
+
+    commit(result.value());
+}
+
+void SaveJob::finish(State state, const QString &message)
+{
+    m_state = state;
+    if (state == State::Succeeded)
+        m_planesDone = planesTotal();
+    emit finished(state == State::Succeeded, message);
+}
+
+void SaveJob::commit(const Output &output)
+{
+    const auto &destPath = m_request.destPath;
+    const auto &sourcePath = m_request.sourcePath;
+
+    emit aboutToCommit(destPath, sourcePath);
+    PERF_TRACE_SCOPE("SaveJob::commit", "save");
+    m_codecChoice = output.codecChoice;
+
+    if (output.inPlace) {
+        QElapsedTimer timer;
+        timer.start();
+        const auto r = OMETiffImage::writeOmeXml(destPath, output.headerXml);
+        if (!r) {
+            finish(State::Failed, r.error());
+            return;
+        }
+
+        const double writeMs = timer.nsecsElapsed() / 1000000.0;
+        m_stats->writeMs = writeMs;
+        m_stats->totalMs += writeMs;
+        m_stats->bytesOut = static_cast<quint64>(QFileInfo(destPath).size());
+    } else {
+        // Move from temp directory to final destination
+        const auto &tempFile = output.tempFile;
+        QFile::remove(destPath);
+        if (!QFile::rename(tempFile, destPath)) {
+            finish(
+                State::Failed,
+                QStringLiteral("Failed to move the written file into place. It has been kept at: %1").arg(tempFile));
+            return;
+        }
+        QDir(QFileInfo(tempFile).absolutePath()).removeRecursively();
+    }
+    qDebug() << "Saved:" << destPath;
+
+    auto warning = output.warning;
+    if (m_request.deleteSource) {
+        const auto sources = m_request.seriesFiles.isEmpty() ? QStringList{sourcePath} : m_request.seriesFiles;
+        QStringList failed;
+        for (const auto &path : sources) {
+            if (QFileInfo(path) != QFileInfo(destPath) && QFile::exists(path) && !QFile::remove(path))
+                failed.append(path);
+        }
+        if (!failed.isEmpty())
+            warning = QStringLiteral("Failed to delete original file '%1'. Please check if it can be deleted manually.")
+                          .arg(failed.join(QStringLiteral("', '")));
+    }
+
+    writeReport();
+    finish(State::Succeeded, warning);
+}
+
+void SaveJob::writeReport()
+{
+    const auto &st = *m_stats;
+    const double seconds = st.totalMs / 1000.0;
+    if (st.headerOnly)
+        qInfo().noquote() << QStringLiteral("Rewrote OME-XML header only, in %1 ms").arg(st.totalMs, 0, 'f', 1);
+    else
+        qInfo().noquote() << QStringLiteral("Saved %1 planes, %2 -> %3 (ratio %4) in %5s, %6/s")
+                                 .arg(st.planes)
+                                 .arg(formatDataSize(st.bytesIn), formatDataSize(st.bytesOut))
+                                 .arg(st.compressionRatio(), 0, 'f', 2)
+                                 .arg(seconds, 0, 'f', 1)
+                                 .arg(formatDataSize(seconds > 0 ? static_cast<size_t>(st.bytesIn / seconds) : 0));
+
+    QSettings settings("OMERewriter", "OMERewriter");
+    if (!settings.value("saving/writeReports", true).toBool())
+        return;
+
+    QJsonObject stages;
+    stages.insert("metadata", st.metadataMs);
+    stages.insert("setup", st.setupMs);
+    stages.insert("read", st.readMs);
+    stages.insert("write", st.writeMs);
+    stages.insert("finalize", st.finalizeMs);
+    stages.insert("xmlPatch", st.xmlPatchMs);
+    if (m_request.deduplicatePlanes && !st.headerOnly)
+        stages.insert("dedup", st.dedupMs);
+    if (m_request.pixelConversion != PixelConversion::None)
+        stages.insert("valueRange", st.rangeMs);
+
+    QJsonObject report;
+    report.insert("version", PROJECT_VERSION);
+    report.insert("timestamp", QDateTime::currentDateTime().toString(Qt::ISODate));
+    report.insert("source", m_request.sourcePath);
+    report.insert("destination", m_request.destPath);
+    report.insert("mode", st.headerOnly ? "header-only" : "full");
+    report.insert("compression", st.headerOnly ? QStringLiteral("unchanged") : st.codec);
+    report.insert("planes", static_cast<qint64>(st.planes));
+    report.insert("bytesIn", static_cast<qint64>(st.bytesIn));
+    report.insert("bytesOut", static_cast<qint64>(st.bytesOut));
+    report.insert("compressionRatio", st.compressionRatio());
+    if (!m_codecChoice.isEmpty())
+        report.insert("compressionChoice", m_codecChoice);
+    if (m_request.deduplicatePlanes && !st.headerOnly)
+        report.insert(
+            "deduplication",
+            QJsonObject{
+                {"planes", static_cast<qint64>(st.duplicatePlanes)},
+                {"bytesSaved", static_cast<qint64>(st.duplicateBytes)},
+            });
+    if (m_request.pixelConversion != PixelConversion::None) {
+        // written = (source - offset) * scale, to recover the original values
+        report.insert(
+            "pixelConversion",
+            QJsonObject{
+                {"mode", pixelConversionName(m_request.pixelConversion)},
+                {"offset", st.valueOffset},
+                {"scale", st.valueScale},
+            });
+    }
+    report.insert("stagesMs", stages);
+    report.insert("totalMs", st.totalMs);
+    report.insert("wallTimeMs", static_cast<qint64>(m_jobTimer.elapsed()));
+    report.insert("throughputBytesPerSec", st.totalMs > 0 ? st.bytesIn * 1000.0 / st.totalMs : 0.0);
+
+    QDir reportDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+    if (!reportDir.mkpath("save-reports") || !reportDir.cd("save-reports")) {
+        qWarning().noquote() << "Unable to create directory for save reports in" << reportDir.absolutePath();
+        return;
+    }
+
+    const auto reportName = QStringLiteral("%1-%2.json")
+                                .arg(QDateTime::currentDateTime().toString("yyyyMMdd-HHmmsszzz"),
+                                     QFileInfo(m_request.destPath).completeBaseName());
+    QSaveFile file(reportDir.filePath(reportName));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning().noquote() << "Unable to write save report:" << file.errorString();
+        return;
+    }
+    file.write(QJsonDocument(report).toJson());
+    if (!file.commit()) {
+        qWarning().noquote() << "Unable to write save report:" << file.errorString();
+        return;
+    }
+    m_reportPath = file.fileName();
+
+    // only keep the most recent reports around
+    const auto oldReports = reportDir.entryInfoList({"*.json"}, QDir::Files, QDir::Name | QDir::Reversed);
+    for (qsizetype i = MaxKeptReports; i < oldReports.size(); ++i)
+        QFile::remove(oldReports[i].absoluteFilePath());
+}
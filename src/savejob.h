@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QThreadPool>
+#include <atomic>
+#include <expected>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "codecselector.h"
+#include "ometiffimage.h"
+#include "hdf5exporter.h"
+
+/**
+ * @brief Description of a single rewrite operation.
+ */
+struct SaveRequest {
+    QString sourcePath;                                        /// File to read the pixel data from
+    QStringList seriesFiles; /// All files of a multi-file source in order, starting with sourcePath
+    QString folderPattern;   /// File name pattern of a folder source, if sourcePath is a directory
+    std::optional<RawBinaryLayout> rawBinaryLayout; /// Layout of a headerless binary source
+    OMETiffImage::dimension_size_type interleavedChannels = 1; /// Channel interleaving of raw TIFF sources
+    OMETiffImage::dimension_size_type framesPerSlice = 1;      /// Frames combined into one output plane
+    FrameBinMode frameBinMode = FrameBinMode::Average;         /// How frames per slice are combined
+    PixelConversion pixelConversion = PixelConversion::None;   /// Pixel type conversion of the output
+    TiffCompression compression = TiffCompression::Deflate;   /// Compression of OME-TIFF pixel data
+    ImageMetadata metadata;                                    /// Metadata to write to the output file
+    QString destPath;                                          /// Final location of the written OME-TIFF
+    bool deleteSource = false;                                 /// Remove the source file after a successful save
+    bool applyAsParameters = false; /// Apply metadata as a parameter set on top of the metadata the source has
+    Hdf5ExportOptions hdf5Options;  /// Chunking & compression, if destPath is an HDF5 file
+    std::optional<CompressionGoal> compressionGoal; /// Choose the compression from sampled planes instead
+    bool deduplicatePlanes = false; /// Let identical OME-TIFF planes share their pixel data
+};
+
+/**
+ * @brief Get the name of a pixel type conversion, as used in job requests and reports.
+ */
+QString pixelConversionName(PixelConversion conversion);
+
+/**
+ * @brief Look up a pixel type conversion by its name ("none", "uint16", "uint8" or "offset-uint16").
+ */
+std::optional<PixelConversion> pixelConversionFromName(const QString &name);
+
+/**
+ * @brief Get the name of an OME-TIFF compression, as used in job requests and settings.
+ */
+QString tiffCompressionName(TiffCompression compression);
+
+/**
+ * @brief Look up an OME-TIFF compression by its name ("deflate" or "zstd").
+ */
+std::optional<TiffCompression> tiffCompressionFromName(const QString &name);
+
+/**
+ * @brief Asynchronous OME-TIFF save operation.
+ *
+ * The job reads the source through its own OMETiffImage instance, so the image
+ * that is currently displayed can still be browsed while the job is running.
+ * Data is written to a temporary directory next to the destination, and moved into
+ * place from the thread the job lives in once writing has completed.
+ *
+ * If only metadata of an OME-TIFF changes, the OME-XML header is patched instead
+ * and the pixel data is kept as-is, which is nearly instant even for huge files.
+ */
+class SaveJob : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Data produced by the worker, which the job moves into place.
+     */
+    struct Output {
+        QString tempFile;        /// Written file in a temporary directory next to the destination
+        std::string headerXml;   /// New OME-XML header of the destination, for in-place header rewrites
+        bool inPlace = false;    /// Only the header of the destination needs to be replaced
+        QString warning;         /// Non-fatal issue to report once the output is in place
+        QJsonObject codecChoice; /// How the compression was chosen, if it was selected automatically
+    };
+    using Result = std::expected<Output, QString>;
+
+    enum class State {
+        Queued,
+        Running,
+        Succeeded,
+        Failed,
+        Cancelled
+    };
+
+    explicit SaveJob(const SaveRequest &request, QObject *parent = nullptr);
+    ~SaveJob() override;
+
+    [[nodiscard]] const SaveRequest &request() const;
+
+    /**
+     * @brief Start writing on the given thread pool.
+     * @param pool Pool to run on, the global pool is used if none is set.
+     */
+    void start(QThreadPool *pool = nullptr);
+
+    /**
+     * @brief Request cancellation. The job will emit finished() once the worker has stopped.
+     *
+     * Jobs that were not started yet are finished immediately.
+     */
+    void cancel();
+
+    [[nodiscard]] State state() const;
+    [[nodiscard]] bool isRunning() const;
+    [[nodiscard]] bool isDone() const;
+
+    // Progress information, updated whenever progressChanged() is emitted
+    [[nodiscard]] int planesDone() const;
+    [[nodiscard]] int planesTotal() const;
+    [[nodiscard]] quint64 bytesDone() const;
+    [[nodiscard]] quint64 bytesTotal() const;
+
+    /**
+     * @brief Smoothed throughput of the job, in bytes of pixel data per second.
+     */
+    [[nodiscard]] double bytesPerSecond() const;
+
+    /**
+     * @brief Estimated remaining time in seconds, or -1 if unknown.
+     */
+    [[nodiscard]] qint64 remainingSecs() const;
+
+    /**
+     * @brief Stage timings and data volumes, available once the job has succeeded.
+     */
+    [[nodiscard]] SaveStatistics statistics() const;
+
+    /**
+     * @brief Path of the JSON report written for a succeeded job, if any.
+     */
+    [[nodiscard]] QString reportPath() const;
+
+signals:
+    void started();
+
+    /**
+     * @brief Emitted at a limited rate while planes are being written.
+     */
+    void progressChanged(int current, int total);
+
+    /**
+     * @brief Emitted right before the written file replaces the destination.
+     *
+     * Receivers must release any handles they hold on the destination or
+     * source file when this signal is emitted.
+     */
+    void aboutToCommit(const QString &destPath, const QString &sourcePath);
+
+    /**
+     * @brief Emitted once the job has completed.
+     * @param success true if the output was written and moved into place.
+     * @param message Error message on failure, or a non-fatal warning on success.
+     */
+    void finished(bool success, const QString &message);
+
+private:
+    void onWorkerProgress(int value);
+    void onWorkerFinished();
+    void commit(const Output &output);
+    void finish(State state, const QString &message);
+    void writeReport();
+
+    SaveRequest m_request;
+    State m_state = State::Queued;
+    QFuture<Result> m_future;
+    QFutureWatcher<Result> m_watcher;
+    bool m_handled = false;
+
+    // Size of one plane in bytes, known once the worker has opened the source
+    std::shared_ptr<std::atomic<quint64>> m_planeBytes;
+
+    // Filled by the worker, only read once it has finished
+    std::shared_ptr<SaveStatistics> m_stats;
+    QElapsedTimer m_jobTimer;
+    QString m_reportPath;
+    QJsonObject m_codecChoice;
+
+    int m_planesDone = 0;
+    QElapsedTimer m_rateTimer;
+    quint64 m_lastRateBytes = 0;
+    double m_bytesPerSecond = 0;
+};
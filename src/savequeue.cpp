@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include "savequeue.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QSettings>
+#include <QStorageInfo>
+#include <QThread>
+#include <algorithm>
+
+/**
+ * Identify the storage device a file lives on. For files that do not exist yet,
+ * the device of the directory they will be created in is used.
+ */
+static QByteArray storageDeviceForPath(const QString &path)
+{
+    const QFileInfo fi(path);
+    QStorageInfo storage(fi.exists() ? fi.absoluteFilePath() : fi.absolutePath());
+    if (!storage.isValid())
+        return fi.absolutePath().toUtf8();
+
+    // network shares have no real device node, so tell them apart by their mount point
+    const auto device = storage.device();
+    return device.isEmpty() ? storage.rootPath().toUtf8() : device;
+}
+
+SaveQueue::SaveQueue(QObject *parent)
+    : QObject(parent)
+{
+    QSettings settings("OMERewriter", "OMERewriter");
+
+    // Every job needs one core for compression, but most of its time is spent waiting on I/O
+    const auto defaultConcurrency = std::max(2, QThread::idealThreadCount() / 2);
+    m_pool.setMaxThreadCount(std::max(1, settings.value("saving/maxConcurrentJobs", defaultConcurrency).toInt()));
+    m_maxJobsPerDevice = std::max(1, settings.value("saving/maxJobsPerDevice", 2).toInt());
+}
+
+SaveQueue::~SaveQueue()
+{
+    cancelAll();
+
+    // Jobs wait for their worker when they are destroyed
+    qDeleteAll(m_jobs);
+    m_jobs.clear();
+    m_pool.waitForDone();
+}
+
+SaveJob *SaveQueue::enqueue(const SaveRequest &request)
+{
+    auto job = new SaveJob(request, this);
+
+    QSet<QByteArray> devices;
+    devices.insert(storageDeviceForPath(request.sourcePath));
+    devices.insert(storageDeviceForPath(request.destPath));
+    m_jobDevices.insert(job, devices);
+
+    connect(job, &SaveJob::finished, this, [this, job]() {
+        onJobFinished(job);
+    });
+
+    m_jobs.append(job);
+    emit jobAdded(job);
+
+    schedule();
+    emit queueChanged();
+
+    return job;
+}
+
+QList<SaveJob *> SaveQueue::jobs() const
+{
+    return m_jobs;
+}
+
+void SaveQueue::removeFinished()
+{
+    for (auto i = m_jobs.size() - 1; i >= 0; --i) {
+        auto job = m_jobs[i];
+        if (!job->isDone())
+            continue;
+
+        m_jobs.removeAt(i);
+        m_jobDevices.remove(job);
+        emit jobRemoved(job);
+        job->deleteLater();
+    }
+}
+
+void SaveQueue::cancelAll()
+{
+    // don't start queued jobs while the ones before them are being cancelled
+    m_cancelling = true;
+    const auto jobs = m_jobs;
+    for (auto job : jobs) {
+        if (!job->isDone())
+            job->cancel();
+    }
+    m_cancelling = false;
+}
+
+int SaveQueue::pendingCount() const
+{
+    return static_cast<int>(std::count_if(m_jobs.cbegin(), m_jobs.cend(), [](SaveJob *job) {
+        return job->state() == SaveJob::State::Queued;
+    }));
+}
+
+int SaveQueue::runningCount() const
+{
+    return static_cast<int>(m_activeJobs.size());
+}
+
+void SaveQueue::setMaxConcurrentJobs(int count)
+{
+    m_pool.setMaxThreadCount(std::max(1, count));
+    schedule();
+}
+
+int SaveQueue::maxConcurrentJobs() const
+{
+    return m_pool.maxThreadCount();
+}
+
+void SaveQueue::setMaxJobsPerDevice(int count)
+{
+    m_maxJobsPerDevice = std::max(1, count);
+    schedule();
+}
+
+int SaveQueue::maxJobsPerDevice() const
+{
+    return m_maxJobsPerDevice;
+}
+
+bool SaveQueue::canStart(SaveJob *job) const
+{
+    if (runningCount() >= m_pool.maxThreadCount())
+        return false;
+
+    for (const auto &device : m_jobDevices.value(job)) {
+        if (m_runningPerDevice.value(device) >= m_maxJobsPerDevice)
+            return false;
+    }
+
+    return true;
+}
+
+void SaveQueue::schedule()
+{
+    if (m_cancelling)
+        return;
+
+    // Jobs are started in order, but a job waiting on a busy device
+    // does not block jobs behind it that use other devices.
+    for (auto job : m_jobs) {
+        if (runningCount() >= m_pool.maxThreadCount())
+            break;
+        if (job->state() != SaveJob::State::Queued || !canStart(job))
+            continue;
+
+        for (const auto &device : m_jobDevices.value(job))
+            m_runningPerDevice[device]++;
+        m_activeJobs.insert(job);
+
+        qDebug().noquote() << "Starting save job for" << job->request().destPath;
+        job->start(&m_pool);
+    }
+}
+
+void SaveQueue::onJobFinished(SaveJob *job)
+{
+    // Jobs cancelled while still queued never held a slot
+    if (m_activeJobs.remove(job)) {
+        for (const auto &device : m_jobDevices.value(job))
+            m_runningPerDevice[device]--;
+    }
+
+    schedule();
+    emit queueChanged();
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QThreadPool>
+
+#include "savejob.h"
+
+/**
+ * @brief Runs queued save jobs concurrently.
+ *
+ * The number of jobs running at the same time is limited globally, as well as per
+ * storage device, so multiple jobs reading or writing on the same disk or network
+ * share do not end up competing for its bandwidth.
+ */
+class SaveQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SaveQueue(QObject *parent = nullptr);
+    ~SaveQueue() override;
+
+    /**
+     * @brief Add a new save job to the queue.
+     *
+     * The returned job is owned by the queue, and will start as soon as a slot is available.
+     */
+    SaveJob *enqueue(const SaveRequest &request);
+
+    /**
+     * @brief All jobs known to the queue, in the order they were added.
+     */
+    [[nodiscard]] QList<SaveJob *> jobs() const;
+
+    /**
+     * @brief Forget about all jobs that have completed.
+     */
+    void removeFinished();
+
+    /**
+     * @brief Cancel all jobs that are queued or running.
+     */
+    void cancelAll();
+
+    [[nodiscard]] int pendingCount() const;
+    [[nodiscard]] int runningCount() const;
+
+    void setMaxConcurrentJobs(int count);
+    [[nodiscard]] int maxConcurrentJobs() const;
+
+    void setMaxJobsPerDevice(int count);
+    [[nodiscard]] int maxJobsPerDevice() const;
+
+signals:
+    void jobAdded(SaveJob *job);
+    void jobRemoved(SaveJob *job);
+
+    /**
+     * @brief Emitted whenever the number of pending or running jobs changes.
+     */
+    void queueChanged();
+
+private:
+    void schedule();
+    void onJobFinished(SaveJob *job);
+    [[nodiscard]] bool canStart(SaveJob *job) const;
+
+    QThreadPool m_pool;
+    QList<SaveJob *> m_jobs;
+    QHash<SaveJob *, QSet<QByteArray>> m_jobDevices;
+    QHash<QByteArray, int> m_runningPerDevice;
+    QSet<SaveJob *> m_activeJobs;
+    int m_maxJobsPerDevice;
+    bool m_cancelling = false;
+};
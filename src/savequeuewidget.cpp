@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include "savequeuewidget.h"
+
+#include <QFileInfo>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QToolButton>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+#include "savequeue.h"
+#include "utils.h"
+
+namespace
+{
+enum Column {
+    ColumnFile,
+    ColumnStatus,
+    ColumnProgress,
+    ColumnSpeed,
+    ColumnRemaining,
+    ColumnCancel,
+    ColumnCount
+};
+} // namespace
+
+static QString jobStateName(SaveJob::State state)
+{
+    switch (state) {
+    case SaveJob::State::Queued:
+        return QStringLiteral("Queued");
+    case SaveJob::State::Running:
+        return QStringLiteral("Writing");
+    case SaveJob::State::Succeeded:
+        return QStringLiteral("Done");
+    case SaveJob::State::Failed:
+        return QStringLiteral("Failed");
+    case SaveJob::State::Cancelled:
+        return QStringLiteral("Cancelled");
+    }
+
+    return QString();
+}
+
+SaveQueueWidget::SaveQueueWidget(SaveQueue *queue, QWidget *parent)
+    : QWidget(parent),
+      m_queue(queue)
+{
+    m_jobTree = new QTreeWidget(this);
+    m_jobTree->setColumnCount(ColumnCount);
+    m_jobTree->setHeaderLabels(
+        {QStringLiteral("File"),
+         QStringLiteral("Status"),
+         QStringLiteral("Progress"),
+         QStringLiteral("Speed"),
+         QStringLiteral("Remaining"),
+         QString()});
+    m_jobTree->setRootIsDecorated(false);
+    m_jobTree->setUniformRowHeights(true);
+    m_jobTree->setSelectionMode(QAbstractItemView::NoSelection);
+    m_jobTree->header()->setStretchLastSection(false);
+    m_jobTree->header()->setSectionResizeMode(ColumnFile, QHeaderView::Stretch);
+    m_jobTree->header()->setSectionResizeMode(ColumnCancel, QHeaderView::ResizeToContents);
+
+    m_summaryLabel = new QLabel(this);
+    m_btnClearFinished = new QPushButton(QStringLiteral("Clear Finished"), this);
+    m_btnClearFinished->setIcon(QIcon::fromTheme(QIcon::ThemeIcon::EditClear));
+
+    auto bottomLayout = new QHBoxLayout;
+    bottomLayout->setContentsMargins(0, 0, 0, 0);
+    bottomLayout->addWidget(m_summaryLabel, 1);
+    bottomLayout->addWidget(m_btnClearFinished);
+
+    auto layout = new QVBoxLayout(this);
+    layout->setContentsMargins(2, 2, 2, 2);
+    layout->setSpacing(4);
+    layout->addWidget(m_jobTree);
+    layout->addLayout(bottomLayout);
+
+    connect(m_btnClearFinished, &QPushButton::clicked, m_queue, &SaveQueue::removeFinished);
+    connect(m_queue, &SaveQueue::jobAdded, this, &SaveQueueWidget::addJob);
+    connect(m_queue, &SaveQueue::jobRemoved, this, &SaveQueueWidget::removeJob);
+    connect(m_queue, &SaveQueue::queueChanged, this, &SaveQueueWidget::updateSummary);
+
+    for (auto job : m_queue->jobs())
+        addJob(job);
+    updateSummary();
+}
+
+SaveQueueWidget::~SaveQueueWidget() = default;
+
+void SaveQueueWidget::addJob(SaveJob *job)
+{
+    const auto &request = job->request();
+
+    auto item = new QTreeWidgetItem(m_jobTree);
+    item->setText(ColumnFile, QFileInfo(request.destPath).fileName());
+    item->setToolTip(
+        ColumnFile, QStringLiteral("%1\n→ %2").arg(request.sourcePath, request.destPath));
+    m_items.insert(job, item);
+
+    auto progressBar = new QProgressBar(m_jobTree);
+    progressBar->setRange(0, 100);
+    progressBar->setValue(0);
+    m_jobTree->setItemWidget(item, ColumnProgress, progressBar);
+
+    auto btnCancel = new QToolButton(m_jobTree);
+    btnCancel->setIcon(QIcon::fromTheme(QIcon::ThemeIcon::ProcessStop));
+    btnCancel->setToolTip(QStringLiteral("Cancel"));
+    btnCancel->setAutoRaise(true);
+    m_jobTree->setItemWidget(item, ColumnCancel, btnCancel);
+    connect(btnCancel, &QToolButton::clicked, job, &SaveJob::cancel);
+
+    connect(job, &SaveJob::started, this, [this, job]() {
+        updateJob(job);
+    });
+    connect(job, &SaveJob::progressChanged, this, [this, job]() {
+        updateJob(job);
+    });
+    connect(job, &SaveJob::finished, this, [this, job](bool success, const QString &message) {
+        updateJob(job);
+
+        auto item = m_items.value(job);
+        if (!item)
+            return;
+        if (!message.isEmpty())
+            item->setToolTip(ColumnStatus, message);
+        if (!success)
+            return;
+
+        // summarize the finished job in place of the live values
+        const auto stats = job->statistics();
+        if (stats.headerOnly) {
+            item->setText(ColumnRemaining, QStringLiteral("Header only"));
+            item->setToolTip(
+                ColumnRemaining,
+                QStringLiteral("Only the OME-XML header was updated, in %1 ms").arg(stats.totalMs, 0, 'f', 0));
+            return;
+        }
+        if (stats.totalMs > 0) {
+            const auto avgRate = static_cast<size_t>(stats.bytesIn * 1000.0 / stats.totalMs);
+            item->setText(ColumnSpeed, QStringLiteral("%1/s").arg(formatDataSize(avgRate)));
+        }
+        item->setText(ColumnRemaining, QStringLiteral("Ratio %1:1").arg(stats.compressionRatio(), 0, 'f', 2));
+        auto summary = QStringLiteral("Read: %1 ms\nWrite: %2 ms\nMetadata: %3 ms\nXML patch: %4 ms\n%5 → %6")
+                           .arg(stats.readMs, 0, 'f', 0)
+                           .arg(stats.writeMs, 0, 'f', 0)
+                           .arg(stats.metadataMs + stats.setupMs + stats.finalizeMs, 0, 'f', 0)
+                           .arg(stats.xmlPatchMs, 0, 'f', 0)
+                           .arg(formatDataSize(stats.bytesIn), formatDataSize(stats.bytesOut));
+        if (!job->reportPath().isEmpty())
+            summary += QStringLiteral("\n\nReport: %1").arg(job->reportPath());
+        item->setToolTip(ColumnRemaining, summary);
+    });
+
+    updateJob(job);
+}
+
+void SaveQueueWidget::removeJob(SaveJob *job)
+{
+    delete m_items.take(job);
+}
+
+void SaveQueueWidget::updateJob(SaveJob *job)
+{
+    auto item = m_items.value(job);
+    if (!item)
+        return;
+
+    const auto state = job->state();
+    item->setText(ColumnStatus, jobStateName(state));
+
+    auto progressBar = qobject_cast<QProgressBar *>(m_jobTree->itemWidget(item, ColumnProgress));
+    if (progressBar && job->planesTotal() > 0)
+        progressBar->setValue((job->planesDone() * 100) / job->planesTotal());
+
+    if (state == SaveJob::State::Running) {
+        item->setText(
+            ColumnSpeed,
+            job->bytesPerSecond() > 0 ? QStringLiteral("%1/s").arg(formatDataSize(job->bytesPerSecond()))
+                                      : QString());
+        item->setText(ColumnRemaining, formatDuration(job->remainingSecs()));
+    } else {
+        item->setText(ColumnSpeed, QString());
+        item->setText(ColumnRemaining, QString());
+    }
+
+    if (job->isDone()) {
+        auto btnCancel = m_jobTree->itemWidget(item, ColumnCancel);
+        if (btnCancel)
+            btnCancel->setEnabled(false);
+    }
+}
+
+void SaveQueueWidget::updateSummary()
+{
+    const auto running = m_queue->runningCount();
+    const auto pending = m_queue->pendingCount();
+    if (running == 0 && pending == 0)
+        m_summaryLabel->setText(QStringLiteral("No active jobs"));
+    else
+        m_summaryLabel->setText(QStringLiteral("%1 running, %2 queued").arg(running).arg(pending));
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <QWidget>
+#include <QHash>
+
+class QLabel;
+class QPushButton;
+class QTreeWidget;
+class QTreeWidgetItem;
+class SaveJob;
+class SaveQueue;
+
+/**
+ * @brief Panel listing the jobs of a SaveQueue with their progress.
+ */
+class SaveQueueWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit SaveQueueWidget(SaveQueue *queue, QWidget *parent = nullptr);
+    ~SaveQueueWidget() override;
+
+private:
+    void addJob(SaveJob *job);
+    void removeJob(SaveJob *job);
+    void updateJob(SaveJob *job);
+    void updateSummary();
+
+    SaveQueue *m_queue;
+    QTreeWidget *m_jobTree;
+    QLabel *m_summaryLabel;
+    QPushButton *m_btnClearFinished;
+    QHash<SaveJob *, QTreeWidgetItem *> m_items;
+};
@@ -0,0 +1,333 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include "tailconverter.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QUuid>
+#include <algorithm>
+
+#include <ome/files/MetadataTools.h>
+#include <ome/files/PixelProperties.h>
+#include <ome/files/VariantPixelBuffer.h>
+#include <ome/files/tiff/Field.h>
+#include <ome/files/tiff/IFD.h>
+#include <ome/files/tiff/TIFF.h>
+#include <ome/files/tiff/Tags.h>
+
+#include "perftrace.h"
+
+// Interval in which the source is checked for new planes, in msec
+static constexpr int PollIntervalMs = 500;
+
+// Aim for strips of about 64 KiB, like ome-files does
+static constexpr quint64 StripSizeBytes = 64 * 1024;
+
+// libtiff tag value of Zstandard compression, which ome-files has no name for
+static constexpr quint16 CompressionZstd = 50000;
+
+/**
+ * Get the ome-files compression scheme of a compression codec.
+ */
+static ome::files::tiff::Compression tiffCompressionScheme(TiffCompression compression)
+{
+    switch (compression) {
+    case TiffCompression::Zstd:
+        return static_cast<ome::files::tiff::Compression>(CompressionZstd);
+    case TiffCompression::Deflate:
+        break;
+    }
+
+    return ome::files::tiff::ADOBE_DEFLATE;
+}
+
+TailConverter::TailConverter(
+    const QString &sourcePath,
+    const QString &destPath,
+    const ImageMetadata &params,
+    QObject *parent)
+    : QObject(parent),
+      m_sourcePath(sourcePath),
+      m_destPath(destPath),
+      m_partPath(destPath + QStringLiteral(".part")),
+      m_params(params)
+{
+    m_pollTimer.setInterval(PollIntervalMs);
+    connect(&m_pollTimer, &QTimer::timeout, this, &TailConverter::poll);
+}
+
+TailConverter::~TailConverter()
+{
+    if (m_out) {
+        m_out.reset();
+        QFile::remove(m_partPath);
+    }
+}
+
+void TailConverter::setInterleavedChannels(int count)
+{
+    m_interleavedChannels = std::max(count, 1);
+}
+
+void TailConverter::setSlicesPerVolume(int count)
+{
+    m_slicesPerVolume = std::max(count, 1);
+}
+
+void TailConverter::setIdleTimeout(qint64 msecs)
+{
+    m_idleTimeoutMs = msecs;
+}
+
+void TailConverter::setCompression(TiffCompression compression)
+{
+    m_compression = compression;
+}
+
+bool TailConverter::start()
+{
+    if (!QFileInfo::exists(m_sourcePath))
+        return false;
+
+    m_idleTimer.start();
+    m_pollTimer.start();
+    return true;
+}
+
+QString TailConverter::sourcePath() const
+{
+    return m_sourcePath;
+}
+
+QString TailConverter::destPath() const
+{
+    return m_destPath;
+}
+
+quint64 TailConverter::planesWritten() const
+{
+    return m_planes;
+}
+
+void TailConverter::poll()
+{
+    const QFileInfo fi(m_sourcePath);
+    if (!fi.exists()) {
+        finish(false, QStringLiteral("The source file was removed during the acquisition"));
+        return;
+    }
+
+    if (fi.size() != m_lastSize) {
+        m_lastSize = fi.size();
+        m_idleTimer.restart();
+    }
+    const bool acquisitionEnded = m_idleTimer.elapsed() >= m_idleTimeoutMs;
+
+    // nothing new to read until the file grows again
+    if (m_lastSize == m_readSize && !acquisitionEnded)
+        return;
+
+    const auto result = readNewPlanes(acquisitionEnded);
+    if (!result) {
+        finish(false, result.error());
+        return;
+    }
+    m_readSize = m_lastSize;
+    if (result.value())
+        emit progressChanged(m_planes);
+
+    if (acquisitionEnded) {
+        const auto finalized = finalize();
+        if (finalized)
+            finish(true, finalized.value());
+        else
+            finish(false, finalized.error());
+    }
+}
+
+std::expected<bool, QString> TailConverter::readNewPlanes(bool acquisitionEnded)
+{
+    PERF_TRACE_SCOPE("TailConverter::readNewPlanes", "save");
+    using ome::files::tiff::IFD;
+    using ome::files::tiff::TIFF;
+
+    // libtiff caches the directory chain, so we look at a fresh handle every time
+    std::shared_ptr<TIFF> tiff;
+    std::shared_ptr<IFD> ifd;
+    try {
+        tiff = TIFF::open(m_sourcePath.toStdString(), "r");
+        ifd = m_planes == 0 ? tiff->getDirectoryByIndex(0U) : tiff->getDirectoryByOffset(m_lastOffset)->next();
+    } catch (const std::exception &e) {
+        // the writer may not have finished the header or the next directory yet
+        if (!acquisitionEnded)
+            return false;
+        if (m_planes == 0)
+            return std::unexpected(QStringLiteral("Failed to read %1: %2").arg(m_sourcePath, e.what()));
+        return false;
+    }
+
+    bool added = false;
+    while (ifd) {
+        // a directory is complete once the writer linked the next one, or stopped writing
+        std::shared_ptr<IFD> following;
+        try {
+            following = ifd->next();
+        } catch (const std::exception &) {
+            following.reset();
+        }
+        if (!following && !acquisitionEnded)
+            break;
+
+        const auto result = appendPlane(*ifd);
+        if (!result)
+            return std::unexpected(result.error());
+
+        m_lastOffset = ifd->getOffset();
+        added = true;
+        ifd = following;
+    }
+
+    return added;
+}
+
+std::expected<bool, QString> TailConverter::appendPlane(const ome::files::tiff::IFD &ifd)
+{
+    namespace tiff = ome::files::tiff;
+
+    try {
+        const auto width = ifd.getImageWidth();
+        const auto height = ifd.getImageHeight();
+        const auto pixelType = ifd.getPixelType();
+        if (ifd.getSamplesPerPixel() != 1)
+            return std::unexpected(QStringLiteral("Only single-sample (grayscale) TIFF planes can be followed"));
+
+        if (!m_out) {
+            m_sizeX = width;
+            m_sizeY = height;
+            m_pixelType = QString::fromStdString(std::string(pixelType));
+            m_out = tiff::TIFF::open(m_partPath.toStdString(), "w8");
+        } else if (width != m_sizeX || height != m_sizeY
+                   || QString::fromStdString(std::string(pixelType)) != m_pixelType) {
+            return std::unexpected(
+                QStringLiteral("Plane %1 has a different size or pixel type than the first one").arg(m_planes));
+        }
+
+        ome::files::VariantPixelBuffer buf;
+        ifd.readImage(buf);
+
+        const auto bitsPerPixel = ome::files::bitsPerPixel(pixelType);
+        const auto rowBytes = static_cast<quint64>(width) * ((bitsPerPixel + 7) / 8);
+        const auto rowsPerStrip = static_cast<quint32>(
+            std::clamp<quint64>(StripSizeBytes / std::max<quint64>(rowBytes, 1), 1, height));
+
+        auto outIfd = m_out->getCurrentDirectory();
+        outIfd->setImageWidth(width);
+        outIfd->setImageHeight(height);
+        outIfd->setTileType(tiff::STRIP);
+        outIfd->setTileWidth(width);
+        outIfd->setTileHeight(rowsPerStrip);
+        outIfd->setPixelType(pixelType);
+        outIfd->setBitsPerSample(bitsPerPixel);
+        outIfd->setSamplesPerPixel(1);
+        outIfd->setPlanarConfiguration(tiff::CONTIG);
+        outIfd->setPhotometricInterpretation(tiff::MIN_IS_BLACK);
+        outIfd->setCompression(tiffCompressionScheme(m_compression));
+
+        // replaced with the real OME-XML once we know the final dimensions
+        if (m_planes == 0)
+            outIfd->getField(tiff::IMAGEDESCRIPTION).set(std::string("OME-TIFF (acquisition in progress)"));
+
+        outIfd->writeImage(buf);
+        m_out->writeCurrentDirectory();
+        m_planes++;
+    } catch (const std::exception &e) {
+        return std::unexpected(QStringLiteral("Failed to copy plane %1: %2").arg(m_planes).arg(e.what()));
+    }
+
+    return true;
+}
+
+std::expected<QString, QString> TailConverter::finalize()
+{
+    PERF_TRACE_SCOPE("TailConverter::finalize", "save");
+    if (!m_out)
+        return std::unexpected(QStringLiteral("The acquisition ended without writing any plane"));
+    m_out->close();
+    m_out.reset();
+
+    const quint64 planesPerVolume = static_cast<quint64>(m_interleavedChannels) * m_slicesPerVolume;
+    const auto sizeT = m_planes / planesPerVolume;
+    if (sizeT == 0) {
+        QFile::remove(m_partPath);
+        return std::unexpected(QStringLiteral("The acquisition ended before the first complete volume"));
+    }
+
+    auto metadata = m_params;
+    metadata.sizeX = static_cast<int>(m_sizeX);
+    metadata.sizeY = static_cast<int>(m_sizeY);
+    metadata.sizeZ = m_slicesPerVolume;
+    metadata.sizeC = m_interleavedChannels;
+    metadata.sizeT = static_cast<int>(sizeT);
+    metadata.pixelType = m_pixelType;
+    if (metadata.channels.size() > static_cast<size_t>(m_interleavedChannels))
+        metadata.channels.resize(m_interleavedChannels);
+
+    try {
+        using ome::xml::model::enums::DimensionOrder;
+        using NonNegativeInteger = ome::xml::model::primitives::NonNegativeInteger;
+
+        auto meta = OMETiffImage::createOmeMetadata(metadata, DimensionOrder::XYCZT);
+        OMETiffImage::applyMetadata(*meta, metadata, false);
+
+        // all planes are stored in the order given by the dimension order, starting at the first IFD
+        const auto uuid = QStringLiteral("urn:uuid:") + QUuid::createUuid().toString(QUuid::WithoutBraces);
+        meta->setUUID(uuid.toStdString());
+        meta->setTiffDataIFD(NonNegativeInteger(0), 0, 0);
+        meta->setTiffDataFirstC(NonNegativeInteger(0), 0, 0);
+        meta->setTiffDataFirstZ(NonNegativeInteger(0), 0, 0);
+        meta->setTiffDataFirstT(NonNegativeInteger(0), 0, 0);
+        meta->setTiffDataPlaneCount(NonNegativeInteger(sizeT * planesPerVolume), 0, 0);
+        meta->setUUIDFileName(QFileInfo(m_destPath).fileName().toStdString(), 0, 0);
+        meta->setUUIDValue(uuid.toStdString(), 0, 0);
+
+        auto xml = ome::files::getOMEXML(*meta);
+        if (xml.rfind("<?xml", 0) != 0)
+            xml.insert(0, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+
+        const auto written = OMETiffImage::writeOmeXml(m_partPath, xml);
+        if (!written) {
+            QFile::remove(m_partPath);
+            return std::unexpected(written.error());
+        }
+    } catch (const std::exception &e) {
+        QFile::remove(m_partPath);
+        return std::unexpected(QStringLiteral("Failed to write the OME-XML header: %1").arg(e.what()));
+    }
+
+    if (QFileInfo::exists(m_destPath))
+        return std::unexpected(
+            QStringLiteral("%1 already exists, the result was kept as %2").arg(m_destPath, m_partPath));
+    if (!QFile::rename(m_partPath, m_destPath))
+        return std::unexpected(QStringLiteral("Failed to move %1 to %2").arg(m_partPath, m_destPath));
+
+    const auto dropped = m_planes - sizeT * planesPerVolume;
+    if (dropped > 0)
+        return QStringLiteral("Dropped %1 plane(s) of an incomplete last volume").arg(dropped);
+    return QString();
+}
+
+void TailConverter::finish(bool success, const QString &message)
+{
+    m_pollTimer.stop();
+    if (!success && m_out) {
+        m_out.reset();
+        QFile::remove(m_partPath);
+    }
+
+    emit finished(success, message);
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <expected>
+#include <memory>
+
+#include "ometiffimage.h"
+
+namespace ome::files::tiff
+{
+class TIFF;
+class IFD;
+} // namespace ome::files::tiff
+
+/**
+ * @brief Converts a raw TIFF to OME-TIFF while it is still being written.
+ *
+ * The source file is polled for new IFDs, which are appended to the output as soon as
+ * the writer has started the next one. Interleaved channels are stored in XYCZT order,
+ * which is the order acquisition software writes them in, so planes never need to be
+ * reordered or held back. Once the source did not grow for the idle timeout, the
+ * acquisition is considered finished: the remaining planes are copied, the final
+ * dimensions are written to the OME-XML header and the output is moved into place.
+ */
+class TailConverter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TailConverter(
+        const QString &sourcePath,
+        const QString &destPath,
+        const ImageMetadata &params,
+        QObject *parent = nullptr);
+    ~TailConverter() override;
+
+    /**
+     * @brief Number of channels the acquisition interleaves, 1 if it does not.
+     */
+    void setInterleavedChannels(int count);
+
+    /**
+     * @brief Number of Z slices per volume, 1 for plain time series.
+     */
+    void setSlicesPerVolume(int count);
+
+    /**
+     * @brief Time the source must not grow before the acquisition is considered finished.
+     */
+    void setIdleTimeout(qint64 msecs);
+
+    /**
+     * @brief Compression of the pixel data of the output, Deflate by default.
+     */
+    void setCompression(TiffCompression compression);
+
+    /**
+     * @brief Start following the source file.
+     * @return false if the source does not exist.
+     */
+    bool start();
+
+    [[nodiscard]] QString sourcePath() const;
+    [[nodiscard]] QString destPath() const;
+    [[nodiscard]] quint64 planesWritten() const;
+
+signals:
+    void progressChanged(quint64 planes);
+    void finished(bool success, const QString &message);
+
+private:
+    void poll();
+    std::expected<bool, QString> readNewPlanes(bool acquisitionEnded);
+    std::expected<bool, QString> appendPlane(const ome::files::tiff::IFD &ifd);
+    std::expected<QString, QString> finalize();
+    void finish(bool success, const QString &message);
+
+    QString m_sourcePath;
+    QString m_destPath;
+    QString m_partPath;
+    ImageMetadata m_params;
+    int m_interleavedChannels = 1;
+    int m_slicesPerVolume = 1;
+    qint64 m_idleTimeoutMs = 5000;
+    TiffCompression m_compression = TiffCompression::Deflate;
+
+    QTimer m_pollTimer;
+    QElapsedTimer m_idleTimer;
+    qint64 m_lastSize = -1;
+    qint64 m_readSize = -1;
+
+    std::shared_ptr<ome::files::tiff::TIFF> m_out;
+    quint64 m_lastOffset = 0;
+    quint64 m_planes = 0;
+    quint32 m_sizeX = 0;
+    quint32 m_sizeY = 0;
+    QString m_pixelType;
+};
@@ -0,0 +1,302 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include "tiffdeduplicator.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QtEndian>
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <limits>
+#include <unordered_map>
+
+#include "perftrace.h"
+#include "tiffstripreader.h"
+
+static constexpr quint16 TagStripOffsets = 273;
+static constexpr quint16 TagStripByteCounts = 279;
+
+// Tags that point to data in ways that are not adjusted here
+static constexpr std::array<quint16, 7> UnsupportedTags = {
+    288,   // FreeOffsets
+    324,   // TileOffsets
+    330,   // SubIFDs
+    513,   // JPEGInterchangeFormat
+    34665, // ExifIFD
+    34853, // GPSInfo
+    40965, // InteroperabilityIFD
+};
+
+// Only multiples of this are removed, so everything behind keeps its alignment
+static constexpr quint64 RemoveAlignment = 8;
+
+static constexpr quint64 MoveBlockBytes = 8 * 1024 * 1024;
+
+TiffDeduplicator::TiffDeduplicator(const QString &filename)
+    : m_filename(filename)
+{
+}
+
+std::expected<TiffDeduplicator::Result, QString> TiffDeduplicator::run()
+{
+    PERF_TRACE_SCOPE("TiffDeduplicator::run", "save");
+    m_duplicates = 0;
+    m_removed.clear();
+    m_removedUpTo.clear();
+    m_patches.clear();
+
+    {
+        TiffStripReader reader(m_filename);
+        auto planned = reader.open();
+        if (planned)
+            planned = plan(reader);
+        if (!planned) {
+            qWarning().noquote() << "Not deduplicating planes of" << m_filename << ":" << planned.error();
+            return Result{};
+        }
+        if (!planned.value())
+            return Result{};
+    }
+
+    const auto applied = apply();
+    if (!applied)
+        return std::unexpected(applied.error());
+
+    const Result result{m_duplicates, m_removedUpTo.back()};
+    qDebug().noquote() << QStringLiteral("%1 planes of %2 share the strips of an earlier plane, saving %3 bytes")
+                              .arg(result.planes)
+                              .arg(m_filename)
+                              .arg(result.bytes);
+    return result;
+}
+
+std::expected<bool, QString> TiffDeduplicator::plan(const TiffStripReader &reader)
+{
+    const auto count = reader.directoryCount();
+    if (count < 2)
+        return false;
+    m_fileSize = reader.fileSize();
+    m_bigEndian = reader.isBigEndian();
+    const bool bigTiff = reader.isBigTiff();
+    const quint8 offsetWidth = bigTiff ? 8 : 4;
+
+    struct Strips {
+        std::vector<quint64> offsets;
+        std::vector<quint64> byteCounts;
+        TiffStripReader::Entry offsetsEntry;
+    };
+    std::vector<Strips> strips(count);
+
+    // everything that is still referenced once the duplicate strips are gone
+    std::vector<Range> kept = {{0, bigTiff ? 16U : 8U}};
+    m_patches.push_back({bigTiff ? 8U : 4U, reader.directoryOffset(0), offsetWidth});
+
+    for (size_t i = 0; i < count; ++i) {
+        const auto entries = reader.entries(i);
+        if (!entries)
+            return std::unexpected(entries.error());
+
+        const auto offset = reader.directoryOffset(i);
+        const auto nextPos = offset + (bigTiff ? 8 : 2) + entries->size() * (bigTiff ? 20 : 12);
+        kept.push_back({offset, nextPos + offsetWidth - offset});
+        const TiffStripReader::Entry nextEntry{0, static_cast<quint16>(bigTiff ? 16 : 4), 1, nextPos, nextPos};
+        const auto next = reader.readValues(nextEntry);
+        if (!next)
+            return std::unexpected(next.error());
+        m_patches.push_back({nextPos, next->front(), offsetWidth});
+
+        for (const auto &entry : entries.value()) {
+            if (std::ranges::find(UnsupportedTags, entry.tag) != UnsupportedTags.end() || entry.type == 13
+                || entry.type == 18)
+                return std::unexpected(QStringLiteral("TIFF tag %1 is not supported").arg(entry.tag));
+            const auto typeSize = TiffStripReader::fieldTypeSize(entry.type);
+            if (typeSize == 0)
+                return std::unexpected(
+                    QStringLiteral("Unknown type %1 of TIFF tag %2").arg(entry.type).arg(entry.tag));
+
+            if (!entry.isInline()) {
+                kept.push_back({entry.valueOffset, entry.count * typeSize});
+                m_patches.push_back({entry.valuePos, entry.valueOffset, offsetWidth});
+            }
+            if (entry.tag != TagStripOffsets && entry.tag != TagStripByteCounts)
+                continue;
+            if (typeSize != 2 && typeSize != 4 && typeSize != 8)
+                return std::unexpected(
+                    QStringLiteral("Unexpected type %1 of TIFF tag %2").arg(entry.type).arg(entry.tag));
+
+            auto values = reader.readValues(entry);
+            if (!values)
+                return std::unexpected(values.error());
+            if (entry.tag == TagStripOffsets) {
+                strips[i].offsets = std::move(values.value());
+                strips[i].offsetsEntry = entry;
+            } else {
+                strips[i].byteCounts = std::move(values.value());
+            }
+        }
+
+        if (strips[i].offsets.size() != strips[i].byteCounts.size())
+            return std::unexpected(QStringLiteral("TIFF directory %1 has an invalid strip table").arg(i));
+        for (size_t s = 0; s < strips[i].offsets.size(); ++s) {
+            if (strips[i].offsets[s] > m_fileSize || m_fileSize - strips[i].offsets[s] < strips[i].byteCounts[s])
+                return std::unexpected(QStringLiteral("Strip %1 of TIFF directory %2 is truncated").arg(s).arg(i));
+        }
+    }
+
+    const auto stripData = [&](size_t dir, size_t s) {
+        return reader.bytes(strips[dir].offsets[s], strips[dir].byteCounts[s]);
+    };
+
+    // find the first directory with the same strips for every directory, confirming hash matches byte by byte
+    constexpr auto unique = std::numeric_limits<size_t>::max();
+    std::vector<size_t> source(count, unique);
+    std::unordered_map<size_t, std::vector<size_t>> byHash;
+    for (size_t i = 0; i < count; ++i) {
+        const auto &own = strips[i];
+        if (own.offsets.empty())
+            continue;
+
+        size_t hash = own.offsets.size();
+        for (size_t s = 0; s < own.offsets.size(); ++s)
+            hash = hash * 31 + std::hash<std::string_view>{}(stripData(i, s));
+
+        bool shared = false;
+        auto &candidates = byHash[hash];
+        for (const auto c : candidates) {
+            if (strips[c].byteCounts != own.byteCounts)
+                continue;
+            bool same = true;
+            for (size_t s = 0; s < own.offsets.size() && same; ++s)
+                same = stripData(c, s) == stripData(i, s);
+            if (!same)
+                continue;
+
+            // directories that already share their strips have nothing to remove
+            shared = strips[c].offsets == own.offsets;
+            if (!shared)
+                source[i] = c;
+            break;
+        }
+        if (source[i] == unique && !shared)
+            candidates.push_back(i);
+    }
+
+    std::vector<Range> duplicates;
+    for (size_t i = 0; i < count; ++i) {
+        auto &target = source[i] == unique ? kept : duplicates;
+        for (size_t s = 0; s < strips[i].offsets.size(); ++s) {
+            if (strips[i].byteCounts[s] > 0)
+                target.push_back({strips[i].offsets[s], strips[i].byteCounts[s]});
+        }
+        if (source[i] != unique)
+            m_duplicates++;
+    }
+    if (duplicates.empty())
+        return false;
+
+    // merge strips stored back to back, so they only lose alignment padding once
+    std::ranges::sort(duplicates, {}, &Range::start);
+    for (const auto &range : duplicates) {
+        if (!m_removed.empty() && m_removed.back().start + m_removed.back().length >= range.start)
+            m_removed.back().length = std::max(
+                m_removed.back().length, range.start + range.length - m_removed.back().start);
+        else
+            m_removed.push_back(range);
+    }
+    for (auto &range : m_removed)
+        range.length -= range.length % RemoveAlignment;
+    std::erase_if(m_removed, [](const Range &range) {
+        return range.length == 0;
+    });
+    if (m_removed.empty())
+        return false;
+
+    // nothing that stays may live within the removed data
+    for (const auto &range : kept) {
+        if (range.length == 0)
+            continue;
+        const auto it = std::ranges::partition_point(m_removed, [&](const Range &removed) {
+            return removed.start + removed.length <= range.start;
+        });
+        if (it != m_removed.end() && it->start < range.start + range.length)
+            return std::unexpected(QStringLiteral("Strips of duplicate planes overlap other data"));
+    }
+
+    quint64 total = 0;
+    for (const auto &range : m_removed) {
+        total += range.length;
+        m_removedUpTo.push_back(total);
+    }
+
+    // duplicates refer to the strips of their source, all others keep their own
+    for (size_t i = 0; i < count; ++i) {
+        const auto &entry = strips[i].offsetsEntry;
+        const auto &offsets = strips[source[i] == unique ? i : source[i]].offsets;
+        const auto width = static_cast<quint8>(TiffStripReader::fieldTypeSize(entry.type));
+        for (size_t s = 0; s < strips[i].offsets.size(); ++s)
+            m_patches.push_back({entry.valueOffset + s * width, offsets[s], width});
+    }
+
+    return true;
+}
+
+quint64 TiffDeduplicator::remap(quint64 offset) const
+{
+    const auto it = std::ranges::partition_point(m_removed, [&](const Range &removed) {
+        return removed.start < offset;
+    });
+    const auto index = static_cast<size_t>(it - m_removed.begin());
+    return index == 0 ? offset : offset - m_removedUpTo[index - 1];
+}
+
+std::expected<bool, QString> TiffDeduplicator::apply()
+{
+    QFile file(m_filename);
+    if (!file.open(QIODevice::ReadWrite))
+        return std::unexpected(QStringLiteral("Failed to open %1: %2").arg(m_filename, file.errorString()));
+
+    // move the data between removed ranges up, front to back, so nothing is overwritten before it was moved
+    std::vector<char> buffer(MoveBlockBytes);
+    for (size_t k = 0; k < m_removed.size(); ++k) {
+        const auto shift = m_removedUpTo[k];
+        const auto segmentStart = m_removed[k].start + m_removed[k].length;
+        const auto segmentEnd = k + 1 < m_removed.size() ? m_removed[k + 1].start : m_fileSize;
+        for (auto pos = segmentStart; pos < segmentEnd; pos += MoveBlockBytes) {
+            const auto size = static_cast<qint64>(std::min(MoveBlockBytes, segmentEnd - pos));
+            if (!file.seek(static_cast<qint64>(pos)) || file.read(buffer.data(), size) != size
+                || !file.seek(static_cast<qint64>(pos - shift)) || file.write(buffer.data(), size) != size)
+                return std::unexpected(
+                    QStringLiteral("Failed to move data within %1: %2").arg(m_filename, file.errorString()));
+        }
+    }
+
+    for (const auto &patch : m_patches) {
+        const auto value = remap(patch.value);
+        uchar bytes[8];
+        switch (patch.width) {
+        case 2:
+            m_bigEndian ? qToBigEndian<quint16>(value, bytes) : qToLittleEndian<quint16>(value, bytes);
+            break;
+        case 4:
+            m_bigEndian ? qToBigEndian<quint32>(value, bytes) : qToLittleEndian<quint32>(value, bytes);
+            break;
+        default:
+            m_bigEndian ? qToBigEndian<quint64>(value, bytes) : qToLittleEndian<quint64>(value, bytes);
+        }
+
+        if (!file.seek(static_cast<qint64>(remap(patch.pos)))
+            || file.write(reinterpret_cast<const char *>(bytes), patch.width) != patch.width)
+            return std::unexpected(
+                QStringLiteral("Failed to update offsets in %1: %2").arg(m_filename, file.errorString()));
+    }
+
+    if (!file.resize(static_cast<qint64>(m_fileSize - m_removedUpTo.back())))
+        return std::unexpected(QStringLiteral("Failed to truncate %1: %2").arg(m_filename, file.errorString()));
+
+    return true;
+}
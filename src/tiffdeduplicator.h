@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <QString>
+#include <expected>
+#include <vector>
+
+class TiffStripReader;
+
+/**
+ * @brief Makes TIFF directories with identical strips share a single copy of them.
+ *
+ * ome-files writes every plane in full and has no way to point a directory at strips
+ * that were already written, so this works on the finished file instead. Directories
+ * are hashed by their compressed strip data; when a directory matches an earlier one
+ * byte for byte, its strips are cut out of the file, everything behind them is moved
+ * up, and all offsets in the file are adjusted so the directory refers to the strips
+ * of the earlier one. Blank frames and repeated frames compress to identical strips,
+ * so the file shrinks by the size of all repeats.
+ *
+ * The file is modified in place, so it must not be in use. Files containing structures
+ * that could refer to the moved data in ways not known here, like tiles, sub-IFDs or
+ * EXIF data, are left unchanged.
+ */
+class TiffDeduplicator
+{
+public:
+    struct Result {
+        quint64 planes = 0; /// Directories that now share the strips of an earlier one
+        quint64 bytes = 0;  /// Bytes the file shrank by
+    };
+
+    explicit TiffDeduplicator(const QString &filename);
+
+    /**
+     * @brief Find duplicate directories, and remove their strips from the file.
+     * @return What was removed, or an error if modifying the file failed, which leaves it unusable.
+     */
+    std::expected<Result, QString> run();
+
+private:
+    struct Range {
+        quint64 start = 0;
+        quint64 length = 0;
+    };
+
+    /// An offset stored in the file, which has to be adjusted once the strips are removed
+    struct Patch {
+        quint64 pos = 0;
+        quint64 value = 0;
+        quint8 width = 0;
+    };
+
+    std::expected<bool, QString> plan(const TiffStripReader &reader);
+    std::expected<bool, QString> apply();
+    [[nodiscard]] quint64 remap(quint64 offset) const;
+
+    QString m_filename;
+    quint64 m_fileSize = 0;
+    bool m_bigEndian = false;
+    quint64 m_duplicates = 0;
+    std::vector<Range> m_removed;
+    std::vector<quint64> m_removedUpTo; /// Bytes removed by each range and all ranges in front of it
+    std::vector<Patch> m_patches;
+};
@@ -0,0 +1,403 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include "tiffstripreader.h"
+
+#include <QSysInfo>
+#include <QtConcurrent>
+#include <QtEndian>
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_set>
+
+#include "deflatecodec.h"
+
+// TIFF tags we need to know about
+static constexpr quint16 TagImageWidth = 256;
+static constexpr quint16 TagImageLength = 257;
+static constexpr quint16 TagBitsPerSample = 258;
+static constexpr quint16 TagCompression = 259;
+static constexpr quint16 TagFillOrder = 266;
+static constexpr quint16 TagStripOffsets = 273;
+static constexpr quint16 TagSamplesPerPixel = 277;
+static constexpr quint16 TagRowsPerStrip = 278;
+static constexpr quint16 TagStripByteCounts = 279;
+static constexpr quint16 TagPredictor = 317;
+static constexpr quint16 TagTileWidth = 322;
+
+static constexpr quint16 CompressionNone = 1;
+static constexpr quint16 CompressionAdobeDeflate = 8;
+static constexpr quint16 CompressionDeflate = 32946;
+
+// planes smaller than this decode faster on one thread than it takes to hand out the strips
+static constexpr size_t ParallelDecodeMinBytes = 4 * 1024 * 1024;
+
+quint64 TiffStripReader::fieldTypeSize(quint16 type)
+{
+    switch (type) {
+    case 1:  // BYTE
+    case 2:  // ASCII
+    case 6:  // SBYTE
+    case 7:  // UNDEFINED
+        return 1;
+    case 3:  // SHORT
+    case 8:  // SSHORT
+        return 2;
+    case 4:  // LONG
+    case 9:  // SLONG
+    case 11: // FLOAT
+    case 13: // IFD
+        return 4;
+    case 5:  // RATIONAL
+    case 10: // SRATIONAL
+    case 12: // DOUBLE
+    case 16: // LONG8
+    case 17: // SLONG8
+    case 18: // IFD8
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+TiffStripReader::TiffStripReader(const QString &filename)
+    : m_file(filename)
+{
+}
+
+TiffStripReader::~TiffStripReader()
+{
+    if (m_data != nullptr)
+        m_file.unmap(const_cast<uchar *>(m_data));
+}
+
+template<typename T>
+T TiffStripReader::read(quint64 offset) const
+{
+    if (offset > m_size || m_size - offset < sizeof(T))
+        throw std::out_of_range("TIFF structure points outside of the file");
+    return m_bigEndian ? qFromBigEndian<T>(m_data + offset) : qFromLittleEndian<T>(m_data + offset);
+}
+
+std::expected<bool, QString> TiffStripReader::open()
+{
+    if (!m_file.open(QIODevice::ReadOnly))
+        return std::unexpected(QStringLiteral("Failed to open %1: %2").arg(m_file.fileName(), m_file.errorString()));
+    m_size = static_cast<quint64>(m_file.size());
+    if (m_size < 16)
+        return std::unexpected(QStringLiteral("%1 is too small to be a TIFF file").arg(m_file.fileName()));
+    m_data = m_file.map(0, m_file.size());
+    if (m_data == nullptr)
+        return std::unexpected(QStringLiteral("Failed to map %1: %2").arg(m_file.fileName(), m_file.errorString()));
+
+    if (m_data[0] == 'I' && m_data[1] == 'I')
+        m_bigEndian = false;
+    else if (m_data[0] == 'M' && m_data[1] == 'M')
+        m_bigEndian = true;
+    else
+        return std::unexpected(QStringLiteral("%1 is not a TIFF file").arg(m_file.fileName()));
+
+    try {
+        const auto version = read<quint16>(2);
+        quint64 offset;
+        if (version == 42) {
+            m_bigTiff = false;
+            offset = read<quint32>(4);
+        } else if (version == 43) {
+            m_bigTiff = true;
+            if (read<quint16>(4) != 8)
+                return std::unexpected(
+                    QStringLiteral("%1 has an unsupported BigTIFF offset size").arg(m_file.fileName()));
+            offset = read<quint64>(8);
+        } else {
+            return std::unexpected(QStringLiteral("%1 is not a TIFF file").arg(m_file.fileName()));
+        }
+
+        // walk the directory chain, which a broken file may have turned into a loop
+        std::unordered_set<quint64> seen;
+        m_directoryOffsets.clear();
+        while (offset != 0 && seen.insert(offset).second) {
+            m_directoryOffsets.push_back(offset);
+            if (m_bigTiff) {
+                const auto count = read<quint64>(offset);
+                if (count > m_size / 20)
+                    throw std::out_of_range("Invalid TIFF directory entry count");
+                offset = read<quint64>(offset + 8 + count * 20);
+            } else {
+                const auto count = read<quint16>(offset);
+                offset = read<quint32>(offset + 2 + count * 12);
+            }
+        }
+    } catch (const std::exception &e) {
+        return std::unexpected(QStringLiteral("Failed to read directories of %1: %2").arg(m_file.fileName(), e.what()));
+    }
+
+    return true;
+}
+
+size_t TiffStripReader::directoryCount() const
+{
+    return m_directoryOffsets.size();
+}
+
+bool TiffStripReader::isBigTiff() const
+{
+    return m_bigTiff;
+}
+
+bool TiffStripReader::isBigEndian() const
+{
+    return m_bigEndian;
+}
+
+quint64 TiffStripReader::fileSize() const
+{
+    return m_size;
+}
+
+quint64 TiffStripReader::directoryOffset(size_t index) const
+{
+    return index < m_directoryOffsets.size() ? m_directoryOffsets[index] : 0;
+}
+
+std::string_view TiffStripReader::bytes(quint64 offset, quint64 size) const
+{
+    if (m_data == nullptr || offset > m_size || m_size - offset < size)
+        return {};
+    return {reinterpret_cast<const char *>(m_data + offset), static_cast<size_t>(size)};
+}
+
+std::expected<std::vector<quint64>, QString> TiffStripReader::readValues(const Entry &entry) const
+{
+    const auto typeSize = fieldTypeSize(entry.type);
+    if (typeSize == 0 || (typeSize == 8 && entry.type != 16 && entry.type != 18))
+        return std::unexpected(QStringLiteral("Unexpected type %1 of TIFF tag %2").arg(entry.type).arg(entry.tag));
+    if (entry.count > m_size / typeSize)
+        return std::unexpected(QStringLiteral("Invalid value count of TIFF tag %1").arg(entry.tag));
+
+    std::vector<quint64> values(entry.count);
+    try {
+        for (quint64 i = 0; i < entry.count; ++i) {
+            const auto pos = entry.valueOffset + i * typeSize;
+            switch (typeSize) {
+            case 1:
+                values[i] = read<quint8>(pos);
+                break;
+            case 2:
+                values[i] = read<quint16>(pos);
+                break;
+            case 4:
+                values[i] = read<quint32>(pos);
+                break;
+            default:
+                values[i] = read<quint64>(pos);
+            }
+        }
+    } catch (const std::exception &e) {
+        return std::unexpected(QStringLiteral("Failed to read values of TIFF tag %1: %2").arg(entry.tag).arg(e.what()));
+    }
+
+    return values;
+}
+
+std::expected<std::vector<TiffStripReader::Entry>, QString> TiffStripReader::entries(size_t index) const
+{
+    if (index >= m_directoryOffsets.size())
+        return std::unexpected(QStringLiteral("TIFF directory %1 does not exist").arg(index));
+
+    std::vector<Entry> result;
+    try {
+        const auto offset = m_directoryOffsets[index];
+        const auto count = m_bigTiff ? read<quint64>(offset) : read<quint16>(offset);
+        if (count > m_size / 12)
+            throw std::out_of_range("Invalid TIFF directory entry count");
+        const quint64 entrySize = m_bigTiff ? 20 : 12;
+        const quint64 inlineSize = m_bigTiff ? 8 : 4;
+        const auto firstEntry = offset + (m_bigTiff ? 8 : 2);
+
+        result.reserve(count);
+        for (quint64 i = 0; i < count; ++i) {
+            const auto pos = firstEntry + i * entrySize;
+            Entry entry;
+            entry.tag = read<quint16>(pos);
+            entry.type = read<quint16>(pos + 2);
+            entry.count = m_bigTiff ? read<quint64>(pos + 4) : read<quint32>(pos + 4);
+            entry.valuePos = pos + (m_bigTiff ? 12 : 8);
+            if (entry.count * fieldTypeSize(entry.type) <= inlineSize)
+                entry.valueOffset = entry.valuePos;
+            else
+                entry.valueOffset = m_bigTiff ? read<quint64>(entry.valuePos) : read<quint32>(entry.valuePos);
+            result.push_back(entry);
+        }
+    } catch (const std::exception &e) {
+        return std::unexpected(QStringLiteral("Failed to read TIFF directory %1: %2").arg(index).arg(e.what()));
+    }
+
+    return result;
+}
+
+std::expected<TiffStripReader::Directory, QString> TiffStripReader::directory(size_t index) const
+{
+    const auto fields = entries(index);
+    if (!fields)
+        return std::unexpected(fields.error());
+
+    Directory dir;
+    quint16 samplesPerPixel = 1;
+    bool hasRowsPerStrip = false;
+    for (const auto &entry : fields.value()) {
+        switch (entry.tag) {
+        case TagImageWidth:
+        case TagImageLength:
+        case TagBitsPerSample:
+        case TagCompression:
+        case TagFillOrder:
+        case TagStripOffsets:
+        case TagSamplesPerPixel:
+        case TagRowsPerStrip:
+        case TagStripByteCounts:
+        case TagPredictor:
+            break;
+        case TagTileWidth:
+            return std::unexpected(QStringLiteral("Tiled TIFF directories are not supported"));
+        default:
+            continue;
+        }
+
+        const auto values = readValues(entry);
+        if (!values)
+            return std::unexpected(values.error());
+        if (values->empty())
+            continue;
+        const auto &v = values.value();
+
+        switch (entry.tag) {
+        case TagImageWidth:
+            dir.width = static_cast<quint32>(v[0]);
+            break;
+        case TagImageLength:
+            dir.height = static_cast<quint32>(v[0]);
+            break;
+        case TagBitsPerSample:
+            dir.bitsPerSample = static_cast<quint16>(v[0]);
+            break;
+        case TagCompression:
+            dir.compression = static_cast<quint16>(v[0]);
+            break;
+        case TagFillOrder:
+            if (v[0] != 1)
+                return std::unexpected(QStringLiteral("Reversed bit fill order is not supported"));
+            break;
+        case TagStripOffsets:
+            dir.stripOffsets = v;
+            break;
+        case TagSamplesPerPixel:
+            samplesPerPixel = static_cast<quint16>(v[0]);
+            break;
+        case TagRowsPerStrip:
+            dir.rowsPerStrip = static_cast<quint32>(std::min<quint64>(v[0], UINT32_MAX));
+            hasRowsPerStrip = true;
+            break;
+        case TagStripByteCounts:
+            dir.stripByteCounts = v;
+            break;
+        case TagPredictor:
+            if (v[0] != 1)
+                return std::unexpected(QStringLiteral("TIFF predictors are not supported"));
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (samplesPerPixel != 1)
+        return std::unexpected(QStringLiteral("Only grayscale TIFF directories are supported"));
+    if (dir.compression != CompressionNone && dir.compression != CompressionAdobeDeflate
+        && dir.compression != CompressionDeflate)
+        return std::unexpected(QStringLiteral("TIFF compression %1 is not supported").arg(dir.compression));
+    if (dir.width == 0 || dir.height == 0 || dir.bitsPerSample == 0 || dir.bitsPerSample % 8 != 0)
+        return std::unexpected(QStringLiteral("Unsupported TIFF image layout"));
+
+    if (!hasRowsPerStrip || dir.rowsPerStrip == 0 || dir.rowsPerStrip > dir.height)
+        dir.rowsPerStrip = dir.height;
+    const auto stripCount = (static_cast<size_t>(dir.height) + dir.rowsPerStrip - 1) / dir.rowsPerStrip;
+    if (dir.stripOffsets.size() != stripCount || dir.stripByteCounts.size() != stripCount)
+        return std::unexpected(QStringLiteral("TIFF directory %1 has an invalid strip table").arg(index));
+    for (size_t s = 0; s < stripCount; ++s) {
+        if (dir.stripOffsets[s] > m_size || m_size - dir.stripOffsets[s] < dir.stripByteCounts[s])
+            return std::unexpected(QStringLiteral("Strip %1 of TIFF directory %2 is truncated").arg(s).arg(index));
+    }
+
+    return dir;
+}
+
+std::expected<bool, QString> TiffStripReader::readDirectory(size_t index, void *dst, size_t dstSize) const
+{
+    const auto dir = directory(index);
+    if (!dir)
+        return std::unexpected(dir.error());
+    if (dir->planeBytes() != dstSize)
+        return std::unexpected(QStringLiteral("TIFF directory %1 does not match the plane size").arg(index));
+
+    const auto rowBytes = dir->rowBytes();
+    const auto stripBytes = rowBytes * dir->rowsPerStrip;
+    const auto sampleBytes = dir->bitsPerSample / 8;
+    const bool swapBytes = m_bigEndian != (QSysInfo::ByteOrder == QSysInfo::BigEndian) && sampleBytes > 1;
+    auto out = static_cast<uchar *>(dst);
+
+    // strips are independent, so each one is decoded and byte-swapped on its own
+    const auto decodeStrip = [&](size_t s) -> bool {
+        const auto rows = std::min<size_t>(dir->rowsPerStrip, dir->height - s * dir->rowsPerStrip);
+        const auto src = m_data + dir->stripOffsets[s];
+        const auto srcSize = static_cast<size_t>(dir->stripByteCounts[s]);
+        const auto size = rows * rowBytes;
+        const auto stripOut = out + s * stripBytes;
+
+        if (dir->compression == CompressionNone) {
+            if (srcSize < size)
+                return false;
+            std::memcpy(stripOut, src, size);
+        } else if (!DeflateCodec::decompress(src, srcSize, stripOut, size)) {
+            return false;
+        }
+
+        if (swapBytes) {
+            for (size_t i = 0; i < size; i += sampleBytes)
+                std::reverse(stripOut + i, stripOut + i + sampleBytes);
+        }
+        return true;
+    };
+
+    const auto stripCount = dir->stripOffsets.size();
+    std::atomic<size_t> badStrip = stripCount;
+    if (stripCount > 1 && dstSize >= ParallelDecodeMinBytes) {
+        // large planes, like stitched mosaics, are decoded on all cores
+        std::vector<size_t> strips(stripCount);
+        std::iota(strips.begin(), strips.end(), size_t(0));
+        QtConcurrent::blockingMap(strips, [&](size_t s) {
+            if (!decodeStrip(s)) {
+                auto expected = stripCount;
+                badStrip.compare_exchange_strong(expected, s);
+            }
+        });
+    } else {
+        for (size_t s = 0; s < stripCount; ++s) {
+            if (!decodeStrip(s)) {
+                badStrip = s;
+                break;
+            }
+        }
+    }
+
+    if (badStrip != stripCount)
+        return std::unexpected(
+            QStringLiteral("Strip %1 of TIFF directory %2 is corrupt").arg(badStrip.load()).arg(index));
+
+    return true;
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <QFile>
+#include <QString>
+#include <expected>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Decodes the strips of TIFF directories without going through libtiff.
+ *
+ * libtiff inflates every strip through zlib's streaming interface. For the common case
+ * of grayscale strips that are deflated (or not compressed at all) without a predictor,
+ * this reader inflates whole strips with DeflateCodec straight from the memory-mapped
+ * file into the plane buffer. Directories stored in any other way are reported as
+ * unsupported and have to be read with libtiff.
+ */
+class TiffStripReader
+{
+public:
+    /**
+     * @brief Strip layout of the pixel data of one directory.
+     */
+    struct Directory {
+        quint32 width = 0;
+        quint32 height = 0;
+        quint32 rowsPerStrip = 0;
+        quint16 bitsPerSample = 0;
+        quint16 compression = 1;
+        std::vector<quint64> stripOffsets;
+        std::vector<quint64> stripByteCounts;
+
+        [[nodiscard]] size_t rowBytes() const
+        {
+            return static_cast<size_t>(width) * (bitsPerSample / 8);
+        }
+        [[nodiscard]] size_t planeBytes() const
+        {
+            return rowBytes() * height;
+        }
+    };
+
+    /**
+     * @brief A field of a directory.
+     */
+    struct Entry {
+        quint16 tag = 0;
+        quint16 type = 0;
+        quint64 count = 0;
+        quint64 valuePos = 0;    /// Position of the value field within the entry
+        quint64 valueOffset = 0; /// Position of the value, inline in the entry or elsewhere in the file
+
+        [[nodiscard]] bool isInline() const
+        {
+            return valueOffset == valuePos;
+        }
+    };
+
+    explicit TiffStripReader(const QString &filename);
+    ~TiffStripReader();
+
+    TiffStripReader(const TiffStripReader &) = delete;
+    TiffStripReader &operator=(const TiffStripReader &) = delete;
+
+    /**
+     * @brief Map the file and find all of its directories.
+     */
+    std::expected<bool, QString> open();
+
+    [[nodiscard]] size_t directoryCount() const;
+
+    /**
+     * @brief Read the strip layout of a directory.
+     * @return The layout, or an error if the directory is stored in a way this reader can not decode.
+     */
+    [[nodiscard]] std::expected<Directory, QString> directory(size_t index) const;
+
+    /**
+     * @brief Decode all strips of a directory, converting the samples to native byte order.
+     * @param dst Destination buffer, rows are stored without padding.
+     * @param dstSize Size of @p dst, which must match the decoded size of the directory.
+     */
+    std::expected<bool, QString> readDirectory(size_t index, void *dst, size_t dstSize) const;
+
+    // Access to the raw structure of the file, for tools that modify it
+    [[nodiscard]] bool isBigTiff() const;
+    [[nodiscard]] bool isBigEndian() const;
+    [[nodiscard]] quint64 fileSize() const;
+    [[nodiscard]] quint64 directoryOffset(size_t index) const;
+
+    /**
+     * @brief Read all fields of a directory.
+     */
+    [[nodiscard]] std::expected<std::vector<Entry>, QString> entries(size_t index) const;
+
+    /**
+     * @brief Read the values of an integer field.
+     */
+    [[nodiscard]] std::expected<std::vector<quint64>, QString> readValues(const Entry &entry) const;
+
+    /**
+     * @brief Get a range of the file, or an empty view if it is not within the file.
+     */
+    [[nodiscard]] std::string_view bytes(quint64 offset, quint64 size) const;
+
+    /**
+     * @brief Size of a single value of a TIFF field type, or 0 for unknown types.
+     */
+    static quint64 fieldTypeSize(quint16 type);
+
+private:
+    template<typename T>
+    [[nodiscard]] T read(quint64 offset) const;
+
+    QFile m_file;
+    const uchar *m_data = nullptr;
+    quint64 m_size = 0;
+    bool m_bigTiff = false;
+    bool m_bigEndian = false;
+    std::vector<quint64> m_directoryOffsets;
+};
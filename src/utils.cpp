@@ -7,8 +7,18 @@
 #include "utils.h"
 
 #include <QDir>
+#include <QFile>
 #include <QRandomGenerator>
 
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_MACOS)
+#include <mach/mach.h>
+#elif defined(Q_OS_UNIX)
+#include <unistd.h>
+#endif
+
 QString createRandomString(int len)
 {
     const auto possibleChars = QStringLiteral("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789");
@@ -41,3 +51,43 @@ QString formatDataSize(size_t bytes)
 
     return QString("%1 B").arg(bytes);
 }
+
+QString formatDuration(qint64 secs)
+{
+    if (secs < 0)
+        return QStringLiteral("-");
+    if (secs >= 3600)
+        return QStringLiteral("%1h %2m").arg(secs / 3600).arg((secs % 3600) / 60, 2, 10, QLatin1Char('0'));
+    if (secs >= 60)
+        return QStringLiteral("%1m %2s").arg(secs / 60).arg(secs % 60, 2, 10, QLatin1Char('0'));
+
+    return QStringLiteral("%1s").arg(secs);
+}
+
+size_t currentProcessMemoryUsage()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.WorkingSetSize;
+    return 0;
+#elif defined(Q_OS_MACOS)
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count)
+        == KERN_SUCCESS)
+        return info.resident_size;
+    return 0;
+#elif defined(Q_OS_UNIX)
+    // second field of statm is the resident set size, in pages
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if (!statm.open(QIODevice::ReadOnly))
+        return 0;
+    const auto fields = statm.readAll().split(' ');
+    if (fields.size() < 2)
+        return 0;
+    return fields[1].toULongLong() * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+    return 0;
+#endif
+}
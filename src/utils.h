@@ -18,3 +18,13 @@ QString createRandomString(int len);
  * @brief Format a byte count into a human-readable string with appropriate units (KB, MB, GB, etc.)
  */
 QString formatDataSize(size_t bytes);
+
+/**
+ * @brief Format a duration in seconds into a short human-readable string, like "1h 05m" or "42s"
+ */
+QString formatDuration(qint64 secs);
+
+/**
+ * @brief Get the resident memory of the current process in bytes, or 0 if unknown.
+ */
+size_t currentProcessMemoryUsage();
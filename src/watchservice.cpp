@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#include "watchservice.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QSettings>
+#include <algorithm>
+
+#include "folderwatcher.h"
+#include "metadatajson.h"
+#include "savedparamsmanager.h"
+#include "savequeue.h"
+#include "tailconverter.h"
+
+WatchService::WatchService(QObject *parent)
+    : QObject(parent),
+      m_watcher(std::make_unique<FolderWatcher>(this)),
+      m_savedParams(std::make_unique<SavedParamsManager>(this)),
+      m_queue(std::make_unique<SaveQueue>(this))
+{
+    QSettings settings("OMERewriter", "OMERewriter");
+    m_watcher->setNameFilters(
+        settings.value("watch/nameFilters", QStringList{QStringLiteral("*.tif"), QStringLiteral("*.tiff")})
+            .toStringList());
+    m_watcher->setStableTime(settings.value("watch/stableTimeMs", 5000).toLongLong());
+    m_watcher->setReportExisting(settings.value("watch/convertExisting", true).toBool());
+
+    // ScanImage interleaves the channels of a recording, which the parameter set tells us the count of
+    m_deinterleave = settings.value("watch/deinterleave", true).toBool();
+    m_deleteSource = settings.value("watch/deleteSource", false).toBool();
+
+    connect(m_watcher.get(), &FolderWatcher::fileReady, this, &WatchService::onFileReady);
+}
+
+WatchService::~WatchService() = default;
+
+void WatchService::setParameterFile(const QString &path)
+{
+    m_paramsFile = path.isEmpty() ? QString() : QFileInfo(path).absoluteFilePath();
+}
+
+void WatchService::setMaxConcurrentJobs(int count)
+{
+    m_queue->setMaxConcurrentJobs(count);
+}
+
+bool WatchService::start(const QStringList &dirs)
+{
+    int watched = 0;
+    for (const auto &dir : dirs) {
+        if (m_watcher->addDirectory(dir)) {
+            qInfo().noquote() << "Watching" << dir;
+            watched++;
+        }
+    }
+
+    if (watched == 0)
+        return false;
+
+    qInfo().noquote() << QStringLiteral("Waiting for finished acquisitions (%1, up to %2 parallel conversions)")
+                             .arg(m_watcher->usesInotify() ? QStringLiteral("inotify") : QStringLiteral("polling"))
+                             .arg(m_queue->maxConcurrentJobs());
+    return true;
+}
+
+QString WatchService::parameterFileFor(const QString &tiffPath) const
+{
+    if (!m_paramsFile.isEmpty())
+        return m_paramsFile;
+
+    // Pick the saved parameter set with the longest name that starts the file name, or the
+    // name of one of its parent directories, e.g. "mouse12_920nm.json" for "mouse12_920nm_00001.tif"
+    QStringList names = {QFileInfo(tiffPath).completeBaseName()};
+    auto dir = QFileInfo(tiffPath).absoluteDir();
+    while (!dir.isRoot() && !dir.dirName().isEmpty()) {
+        names.append(dir.dirName());
+        if (!dir.cdUp())
+            break;
+    }
+
+    QString bestMatch;
+    qsizetype bestLength = 0;
+    for (const auto &paramsFile : m_savedParams->getFiles()) {
+        const auto paramsName = QFileInfo(paramsFile).completeBaseName();
+        if (paramsName.size() <= bestLength)
+            continue;
+
+        const bool matches = std::any_of(names.cbegin(), names.cend(), [&paramsName](const QString &name) {
+            return name.startsWith(paramsName, Qt::CaseInsensitive);
+        });
+        if (matches) {
+            bestMatch = paramsFile;
+            bestLength = paramsName.size();
+        }
+    }
+
+    return bestMatch;
+}
+
+void WatchService::onFileReady(const QString &path)
+{
+    const auto paramsFile = parameterFileFor(path);
+    if (paramsFile.isEmpty()) {
+        qWarning().noquote() << "No matching parameter set for" << path << "- not converting it";
+        return;
+    }
+
+    const auto params = MetadataJson::loadParameters(paramsFile);
+    if (!params) {
+        qWarning().noquote() << "Failed to load parameters" << paramsFile << "-" << params.error();
+        return;
+    }
+
+    const QFileInfo fi(path);
+    SaveRequest request;
+    request.sourcePath = path;
+    request.destPath = fi.absoluteDir().absoluteFilePath(fi.completeBaseName() + ".ome.tiff");
+    request.metadata = params.value();
+    request.applyAsParameters = true;
+    request.deleteSource = m_deleteSource;
+    if (m_deinterleave && params->channels.size() > 1)
+        request.interleavedChannels = params->channels.size();
+
+    qInfo().noquote() << "Converting" << path << "with" << QFileInfo(paramsFile).fileName();
+    auto job = m_queue->enqueue(request);
+    connect(job, &SaveJob::finished, this, [this, job](bool success, const QString &message) {
+        if (success)
+            qInfo().noquote() << "Converted:" << job->request().destPath;
+        else
+            qWarning().noquote() << "Failed to convert" << job->request().sourcePath << "-" << message;
+        if (success && !message.isEmpty())
+            qWarning().noquote() << message;
+
+        // the service runs for a long time, don't keep every job around
+        m_queue->removeFinished();
+    });
+}
+
+bool WatchService::follow(const QString &tiffPath, int slicesPerVolume)
+{
+    const QFileInfo fi(tiffPath);
+    if (!fi.exists()) {
+        qWarning().noquote() << "Can not follow" << tiffPath << "- file does not exist";
+        return false;
+    }
+
+    const auto paramsFile = parameterFileFor(fi.absoluteFilePath());
+    if (paramsFile.isEmpty()) {
+        qWarning().noquote() << "No matching parameter set for" << tiffPath;
+        return false;
+    }
+    const auto params = MetadataJson::loadParameters(paramsFile);
+    if (!params) {
+        qWarning().noquote() << "Failed to load parameters" << paramsFile << "-" << params.error();
+        return false;
+    }
+
+    QSettings settings("OMERewriter", "OMERewriter");
+    m_tailConverter = std::make_unique<TailConverter>(
+        fi.absoluteFilePath(), fi.absoluteDir().absoluteFilePath(fi.completeBaseName() + ".ome.tiff"), params.value());
+    m_tailConverter->setIdleTimeout(settings.value("watch/stableTimeMs", 5000).toLongLong());
+    m_tailConverter->setSlicesPerVolume(slicesPerVolume);
+
+    // planes are written as they arrive, so "auto" has nothing to choose a codec from and keeps the default
+    const auto compression = tiffCompressionFromName(settings.value("saving/compression").toString());
+    if (compression && OMETiffImage::isCompressionAvailable(compression.value()))
+        m_tailConverter->setCompression(compression.value());
+    if (m_deinterleave && params->channels.size() > 1)
+        m_tailConverter->setInterleavedChannels(static_cast<int>(params->channels.size()));
+
+    connect(m_tailConverter.get(), &TailConverter::finished, this, [this](bool success, const QString &message) {
+        const auto converter = m_tailConverter.get();
+        if (success)
+            qInfo().noquote() << "Converted" << converter->planesWritten() << "planes:" << converter->destPath();
+        else
+            qWarning().noquote() << "Failed to convert" << converter->sourcePath() << "-" << message;
+        if (success && !message.isEmpty())
+            qWarning().noquote() << message;
+
+        emit followFinished(success);
+    });
+
+    qInfo().noquote() << "Following" << tiffPath << "with" << QFileInfo(paramsFile).fileName();
+    return m_tailConverter->start();
+}
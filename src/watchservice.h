@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2025-2026 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QStringList>
+#include <memory>
+
+class FolderWatcher;
+class SavedParamsManager;
+class SaveQueue;
+class TailConverter;
+
+/**
+ * @brief Headless service converting raw acquisitions to OME-TIFF as soon as they are complete.
+ *
+ * Finished TIFF files in the watched directories are converted next to the original,
+ * using either a fixed parameter set or the saved parameter set whose name matches
+ * the file or one of its parent directories.
+ */
+class WatchService : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit WatchService(QObject *parent = nullptr);
+    ~WatchService() override;
+
+    /**
+     * @brief Use this parameter set for all files, instead of picking a matching one.
+     */
+    void setParameterFile(const QString &path);
+
+    /**
+     * @brief Maximum number of conversions running at the same time.
+     */
+    void setMaxConcurrentJobs(int count);
+
+    /**
+     * @brief Start watching the given directories.
+     * @return false if none of them could be watched.
+     */
+    bool start(const QStringList &dirs);
+
+    /**
+     * @brief Find the parameter set to convert a file with.
+     * @return Path to the parameter set, or an empty string if none matches.
+     */
+    [[nodiscard]] QString parameterFileFor(const QString &tiffPath) const;
+
+    /**
+     * @brief Convert a TIFF that is still being written, while the acquisition runs.
+     * @param slicesPerVolume Number of Z slices per volume of the recording.
+     * @return false if the file can not be followed.
+     */
+    bool follow(const QString &tiffPath, int slicesPerVolume = 1);
+
+signals:
+    /**
+     * @brief Emitted when following a file has ended.
+     */
+    void followFinished(bool success);
+
+private:
+    void onFileReady(const QString &path);
+
+    std::unique_ptr<FolderWatcher> m_watcher;
+    std::unique_ptr<SavedParamsManager> m_savedParams;
+    std::unique_ptr<SaveQueue> m_queue;
+    std::unique_ptr<TailConverter> m_tailConverter;
+    QString m_paramsFile;
+    bool m_deinterleave;
+    bool m_deleteSource;
+};
@@ -19,6 +19,7 @@ eatmydata apt-get install -yq --no-install-recommends \
     gettext \
     libqt6opengl6-dev \
     libqt6svg6-dev \
+    libqt6sql6-sqlite \
     qt6-base-dev \
     qt6-5compat-dev \
     libgtest-dev \
@@ -28,4 +29,6 @@ eatmydata apt-get install -yq --no-install-recommends \
     python3-genshi \
     libboost-dev \
     libtiff-dev \
-    libpng-dev
+    libpng-dev \
+    zlib1g-dev \
+    libdeflate-dev